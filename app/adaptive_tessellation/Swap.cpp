@@ -58,7 +58,7 @@ void addCustomOps(Executor& e)
 
 auto swap_renew = [](auto& m, auto op, auto& tris) {
     auto edges = m.new_edges_after(tris);
-    auto optup = std::vector<std::pair<std::string, wmtk::TriMesh::Tuple>>();
+    auto optup = std::vector<std::pair<decltype(op), wmtk::TriMesh::Tuple>>();
     for (auto& e : edges) optup.emplace_back(op, e);
     return optup;
 };
@@ -57,7 +57,7 @@ bool harmonic_tet::HarmonicTet::smooth_after(const Tuple& t)
     wmtk::logger().trace("Gradient Descent iteration for vertex smoothing.");
     auto vid = t.vid(*this);
 
-    auto locs = get_one_ring_tets_for_vertex(t);
+    const auto& locs = get_one_ring_tets_for_vertex_scratch(t);
     assert(locs.size() > 0);
     std::vector<std::array<double, 12>> assembles(locs.size());
     auto loc_id = 0;
@@ -108,11 +108,10 @@ bool HarmonicTet::swap_edge_before(const Tuple& t)
 {
     if (!TetMesh::swap_edge_before(t)) return false;
 
-    auto incident_tets = get_incident_tets_for_edge(t);
     auto total_energy = 0.;
-    for (auto& l : incident_tets) {
-        total_energy += tet_attrs[l.tid(*this)].quality;
-    }
+    for_each_incident_tid_of_edge(t.vid(*this), switch_vertex(t).vid(*this), [&](size_t tid) {
+        total_energy += tet_attrs[tid].quality;
+    });
     edgeswap_cache.local().total_energy = total_energy;
     return true;
 }
@@ -141,14 +140,12 @@ bool HarmonicTet::swap_face_after(const Tuple& t)
 {
     if (!TetMesh::swap_face_after(t)) return false;
 
-    auto incident_tets = get_incident_tets_for_edge(t);
-
     auto total_energy = 0.;
-    for (auto& l : incident_tets) {
-        auto q = get_quality(l);
-        tet_attrs[l.tid(*this)].quality = q;
+    for_each_incident_tid_of_edge(t.vid(*this), switch_vertex(t).vid(*this), [&](size_t tid) {
+        auto q = get_quality(tuple_from_tet(tid));
+        tet_attrs[tid].quality = q;
         total_energy += q;
-    }
+    });
     wmtk::logger().trace("quality {} from {}", total_energy, faceswap_cache.local().total_energy);
 
     if (total_energy > faceswap_cache.local().total_energy) return false;
@@ -407,14 +404,13 @@ void HarmonicTet::swap_all_edges(bool parallel)
             std::set<size_t> eids;
             std::vector<size_t> twice;
             for (auto ti : newt) {
-                for (auto j = 0; j < 6; j++) {
-                    auto e_tup = m.tuple_from_edge(ti.tid(m), j);
+                m.for_each_edge_of_tet(ti, [&](const auto& e_tup) {
                     auto eid = e_tup.eid(m);
                     auto [it, suc] = eids.insert(eid);
                     if (!suc) twice.push_back(eid);
-                }
+                });
             }
-            std::vector<std::pair<std::string, wmtk::TetMesh::Tuple>> op_tups;
+            std::vector<std::pair<decltype(op), wmtk::TetMesh::Tuple>> op_tups;
             for (auto eid : twice) op_tups.emplace_back(op, m.tuple_from_edge(eid / 6, eid % 6));
             return op_tups;
         };
@@ -54,19 +54,34 @@ bool adjust_sizing_field(
     // outputs scale_multipliers
     tbb::concurrent_vector<double> scale_multipliers(mesh.vert_capacity(), recover_scalar);
 
-    std::vector<Vector3d> pts;
+    // the centers and the vertices of the low quality tets, gathered per range of tets
+    struct LowQuality
+    {
+        std::vector<Vector3d> pts;
+        std::vector<size_t> vids;
+    };
+    auto low_quality = mesh.TetMesh::reduce_tetra(
+        LowQuality(),
+        [&](LowQuality& l, auto& t) {
+            auto tid = t.tid(mesh);
+            if (mesh.m_tet_attribute[tid].quality < filter_energy) return;
+            auto vs = mesh.oriented_tet_vids(t);
+            Vector3d c(0, 0, 0);
+            for (int j = 0; j < 4; j++) {
+                c += (mesh.m_vertex_attribute[vs[j]].pos);
+                l.vids.emplace_back(vs[j]);
+            }
+            l.pts.emplace_back(c / 4);
+        },
+        [](const LowQuality& a, const LowQuality& b) {
+            auto l = a;
+            l.pts.insert(l.pts.end(), b.pts.begin(), b.pts.end());
+            l.vids.insert(l.vids.end(), b.vids.begin(), b.vids.end());
+            return l;
+        });
+    auto& pts = low_quality.pts;
     std::queue<size_t> v_queue;
-    mesh.TetMesh::for_each_tetra([&](auto& t) {
-        auto tid = t.tid(mesh);
-        if (mesh.m_tet_attribute[tid].quality < filter_energy) return;
-        auto vs = mesh.oriented_tet_vids(t);
-        Vector3d c(0, 0, 0);
-        for (int j = 0; j < 4; j++) {
-            c += (mesh.m_vertex_attribute[vs[j]].pos);
-            v_queue.emplace(vs[j]);
-        }
-        pts.emplace_back(c / 4);
-    });
+    for (auto vid : low_quality.vids) v_queue.push(vid);
 
     wmtk::logger().info("filter energy {} Low Quality Tets {}", filter_energy, pts.size());
 
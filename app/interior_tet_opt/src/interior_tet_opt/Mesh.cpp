@@ -11,6 +11,22 @@
 #include "wmtk/utils/TetraQualityUtils.hpp"
 #include "wmtk/utils/io.hpp"
 
+// clang-format off
+#include <wmtk/utils/DisableWarnings.hpp>
+#include <tbb/parallel_for.h>
+#include <wmtk/utils/EnableWarnings.hpp>
+// clang-format on
+
+namespace {
+// the cube of the AMIPS energy, with the invalid ones of the degenerate tets replaced by 1e50
+double quality_from_energy(double amips_energy)
+{
+    double energy = std::pow(amips_energy, 3);
+    if (std::isinf(energy) || std::isnan(energy)) return 1e50;
+    return energy;
+}
+} // namespace
+
 namespace app::interior_tet_opt {
 
 void InteriorTetOpt::initialize(
@@ -268,11 +284,7 @@ bool InteriorTetOpt::smooth_after(const Tuple& t)
 
     auto old_pos = m_vertex_attribute[vid].pos;
     auto old_asssembles = assembles;
-    m_vertex_attribute[vid].pos = wmtk::newton_method_from_stack(
-        assembles,
-        wmtk::AMIPS_energy,
-        wmtk::AMIPS_jacobian,
-        wmtk::AMIPS_hessian);
+    m_vertex_attribute[vid].pos = wmtk::AMIPS_newton_method_from_stack(assembles);
     wmtk::logger().trace(
         "old pos {} -> new pos {}",
         old_pos.transpose(),
@@ -385,7 +397,7 @@ void InteriorTetOpt::collapse_all_edges(bool is_limit_length)
     auto setup_and_execute = [&](auto& executor) {
         executor.renew_neighbor_tuples = [&](const auto& m, auto op, const auto& newts) {
             count_success++;
-            std::vector<std::pair<std::string, wmtk::TetMesh::Tuple>> op_tups;
+            std::vector<std::pair<decltype(op), wmtk::TetMesh::Tuple>> op_tups;
             for (auto t : newts) {
                 op_tups.emplace_back(op, t);
                 op_tups.emplace_back(op, t.switch_vertex(m));
@@ -557,9 +569,41 @@ double InteriorTetOpt::get_quality(const Tuple& loc) const
         T[3 * 3 + j] = ps[3][j];
     }
 
-    double energy = std::pow(wmtk::AMIPS_energy(T), 3);
-    if (std::isinf(energy) || std::isnan(energy)) return 1e50;
-    return energy;
+    return quality_from_energy(wmtk::AMIPS_energy(T));
+}
+
+void InteriorTetOpt::update_missing_qualities()
+{
+    const auto tets = get_tets();
+    auto& arena = wmtk::ExecutionContext::instance().arena(NUM_THREADS);
+    arena.execute([&] {
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, tets.size(), 1024),
+            [&](const tbb::blocked_range<size_t>& r) {
+                wmtk::AMIPSBatch batch;
+                std::array<size_t, wmtk::AMIPS_BATCH_SIZE> batch_tids;
+                auto evaluate_batch = [&]() {
+                    wmtk::AMIPSLanes energy;
+                    wmtk::AMIPS_energy_batch(batch, energy);
+                    for (auto i = 0; i < batch.size; i++)
+                        m_tet_attribute[batch_tids[i]].quality = quality_from_energy(energy[i]);
+                    batch.clear();
+                };
+                for (size_t i = r.begin(); i < r.end(); i++) {
+                    const auto tid = tets[i].tid(*this);
+                    if (m_tet_attribute[tid].quality >= 0) continue;
+                    auto its = oriented_tet_vertices(tets[i]);
+                    std::array<double, 12> T;
+                    for (int k = 0; k < 4; k++)
+                        for (int j = 0; j < 3; j++)
+                            T[k * 3 + j] = m_vertex_attribute[its[k].vid(*this)].pos[j];
+                    batch_tids[batch.size] = tid;
+                    batch.push_back(T);
+                    if (batch.full()) evaluate_batch();
+                }
+                if (batch.size > 0) evaluate_batch();
+            });
+    });
 }
 
 
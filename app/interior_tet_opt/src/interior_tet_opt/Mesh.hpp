@@ -33,6 +33,10 @@ struct InteriorTetOpt : wmtk::TetMesh
 
     bool is_inverted(const Tuple&) const;
     double get_quality(const Tuple&) const;
+    /**
+     * @brief computes the qualities of the tets that have none yet, in parallel and in batches
+     */
+    void update_missing_qualities();
     double get_length2(const Tuple&) const;
     bool invariants(const std::vector<Tuple>& t) override; //
     void final_output_mesh(std::string);
@@ -146,23 +150,28 @@ struct InteriorTetOpt : wmtk::TetMesh
     }
     std::tuple<double, double> get_max_avg_energy()
     {
-        double max_energy = -1.;
-        double avg_energy = 0;
-        auto cnt = 0;
-
-        TetMesh::for_each_tetra([&](auto& t) {
-            auto& q = m_tet_attribute[t.tid(*this)].quality;
-            if (q < 0) q = get_quality(t);
-
-            if (q > max_energy) max_energy = q;
-
-            avg_energy += std::cbrt(q);
-            cnt++;
-        });
-
-        avg_energy /= cnt;
-
-        return std::make_tuple(std::cbrt(max_energy), avg_energy);
+        struct EnergyStats
+        {
+            double max = -1.;
+            double sum = 0.; // of the cube roots
+            size_t cnt = 0;
+        };
+        update_missing_qualities();
+        auto stats = TetMesh::reduce_tetra(
+            EnergyStats(),
+            [&](EnergyStats& s, auto& t) {
+                auto q = m_tet_attribute[t.tid(*this)].quality;
+
+                if (q > s.max) s.max = q;
+
+                s.sum += std::cbrt(q);
+                s.cnt++;
+            },
+            [](const EnergyStats& a, const EnergyStats& b) {
+                return EnergyStats{std::max(a.max, b.max), a.sum + b.sum, a.cnt + b.cnt};
+            });
+
+        return std::make_tuple(std::cbrt(stats.max), stats.sum / stats.cnt);
     }
 };
 } // namespace app::interior_tet_opt
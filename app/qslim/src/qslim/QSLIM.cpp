@@ -45,12 +45,6 @@ public:
     }
 };
 
-
-template <typename Executor>
-void addCustomOps(Executor& e)
-{
-    e.add_operation(std::make_shared<QSLIMEdgeCollapseOperation>());
-}
 } // namespace
 
 QSLIM::QSLIM(std::vector<Eigen::Vector3d> _m_vertex_positions, int num_threads)
@@ -69,12 +63,9 @@ QSLIM::QSLIM(std::vector<Eigen::Vector3d> _m_vertex_positions, int num_threads)
 
 void QSLIM::set_freeze(TriMesh::Tuple& v)
 {
-    for (auto e : get_one_ring_edges_for_vertex(v)) {
-        if (is_boundary_edge(e)) {
-            vertex_attrs[v.vid(*this)].freeze = true;
-            continue;
-        }
-    }
+    for_each_edge_around_vertex(v, [&](const Tuple& e) {
+        if (is_boundary_edge(e)) vertex_attrs[v.vid(*this)].freeze = true;
+    });
 }
 
 void QSLIM::create_mesh(
@@ -163,7 +154,7 @@ void QSLIM::partition_mesh_morton()
     if (NUM_THREADS == 0) return;
     wmtk::logger().info("Number of parts: {} by morton", NUM_THREADS);
 
-    tbb::task_arena arena(NUM_THREADS);
+    auto& arena = wmtk::ExecutionContext::instance().arena(NUM_THREADS);
 
     arena.execute([&] {
         std::vector<Eigen::Vector3d> V_v(vert_capacity());
@@ -403,7 +394,6 @@ bool QSLIM::collapse_qslim(int target_vert_number)
         return -compute_cost_for_e(new_e);
     };
     auto setup_and_execute = [&](auto& executor) {
-        addCustomOps(executor);
         executor.num_threads = NUM_THREADS;
         executor.renew_neighbor_tuples = renew;
         executor.priority = measure_priority;
@@ -426,13 +416,15 @@ bool QSLIM::collapse_qslim(int target_vert_number)
     };
 
     if (NUM_THREADS > 0) {
-        auto executor = wmtk::ExecutePass<QSLIM, ExecutionPolicy::kPartition>();
+        auto executor =
+            wmtk::ExecutePass<QSLIM, ExecutionPolicy::kStealing, QSLIMEdgeCollapseOperation>();
         executor.lock_vertices = [](auto& m, const auto& e, int task_id) {
             return m.try_set_edge_mutex_two_ring(e, task_id);
         };
         setup_and_execute(executor);
     } else {
-        auto executor = wmtk::ExecutePass<QSLIM, ExecutionPolicy::kSeq>();
+        auto executor =
+            wmtk::ExecutePass<QSLIM, ExecutionPolicy::kSeq, QSLIMEdgeCollapseOperation>();
         setup_and_execute(executor);
     }
     return true;
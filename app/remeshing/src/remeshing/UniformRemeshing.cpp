@@ -15,7 +15,7 @@ using namespace wmtk;
 
 auto renew = [](auto& m, auto op, auto& tris) {
     auto edges = m.new_edges_after(tris);
-    auto optup = std::vector<std::pair<std::string, TriMesh::Tuple>>();
+    auto optup = std::vector<std::pair<decltype(op), TriMesh::Tuple>>();
     for (auto& e : edges) optup.emplace_back(op, e);
     return optup;
 };
@@ -114,7 +114,7 @@ void UniformRemeshing::partition_mesh_morton()
     if (NUM_THREADS == 0) return;
     wmtk::logger().info("Number of parts: {} by morton", NUM_THREADS);
 
-    tbb::task_arena arena(NUM_THREADS);
+    auto& arena = wmtk::ExecutionContext::instance().arena(NUM_THREADS);
 
     arena.execute([&] {
         std::vector<Eigen::Vector3d> V_v(vert_capacity());
@@ -310,8 +310,7 @@ bool UniformRemeshing::smooth_before(const Tuple& t)
 
 bool UniformRemeshing::smooth_after(const TriMesh::Tuple& t)
 {
-    auto one_ring_tris = get_one_ring_tris_for_vertex(t);
-    if (one_ring_tris.size() < 2) {
+    if (get_valence_for_vertex(t) < 2) {
         return false;
     }
     Eigen::Vector3d after_smooth = tangential_smooth(t);
@@ -359,7 +358,7 @@ double UniformRemeshing::compute_vertex_valence(const TriMesh::Tuple& t) const
     for (int i = 0; i < valences.size(); i++) {
         TriMesh::Tuple vert = valences[i].first;
         int val = 6;
-        auto one_ring_edges = get_one_ring_edges_for_vertex(vert);
+        const auto& one_ring_edges = get_one_ring_edges_for_vertex_scratch(vert);
         for (auto edge : one_ring_edges) {
             if (is_boundary_edge(edge)) {
                 val = 4;
@@ -479,13 +478,15 @@ bool UniformRemeshing::split_remeshing(double L)
     auto edges2 = tbb::concurrent_vector<std::pair<std::string, TriMesh::Tuple>>();
     auto setup_and_execute = [&](auto& executor) {
         addCustomOps(executor);
+        // the new vertices are told apart by their ids, which must not land in reserved slots
+        release_reserved_slots();
         vid_threshold = vert_capacity();
         executor.num_threads = NUM_THREADS;
         executor.renew_neighbor_tuples = [&](auto& m, auto op, auto& tris) {
             count_success++;
             auto edges = m.replace_edges_after_split(tris, vid_threshold);
             for (auto e2 : m.new_sub_edges_after_split(tris)) edges2.emplace_back(op, e2);
-            auto optup = std::vector<std::pair<std::string, TriMesh::Tuple>>();
+            auto optup = std::vector<std::pair<decltype(op), TriMesh::Tuple>>();
             for (auto& e : edges) optup.emplace_back(op, e);
             return optup;
         };
@@ -606,7 +607,7 @@ Eigen::Vector3d normal(UniformRemeshing& m, std::array<TriMesh::Tuple, 3>& verts
 
 Eigen::Vector3d UniformRemeshing::smooth(const TriMesh::Tuple& t)
 {
-    auto one_ring_edges = get_one_ring_edges_for_vertex(t);
+    const auto& one_ring_edges = get_one_ring_edges_for_vertex_scratch(t);
     if (one_ring_edges.size() < 3) return vertex_attrs[t.vid(*this)].pos;
     Eigen::Vector3d after_smooth(0, 0, 0);
     Eigen::Vector3d after_smooth_boundary(0, 0, 0);
@@ -629,7 +630,7 @@ Eigen::Vector3d UniformRemeshing::smooth(const TriMesh::Tuple& t)
 
 Eigen::Vector3d UniformRemeshing::tangential_smooth(const Tuple& t)
 {
-    auto one_ring_tris = get_one_ring_tris_for_vertex(t);
+    const auto& one_ring_tris = get_one_ring_tris_for_vertex_scratch(t);
     if (one_ring_tris.size() < 2) return vertex_attrs[t.vid(*this)].pos;
     Eigen::Vector3d after_smooth = smooth(t);
     // get normal and area of each face
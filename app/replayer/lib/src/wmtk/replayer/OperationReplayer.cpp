@@ -134,6 +134,7 @@ size_t OperationReplayer::play_to(size_t end)
             }
             mesh.build_vertex_connectivity(tri_op.vertex_size);
             mesh.current_tri_size = tri_op.triangle_size;
+            mesh.reset_element_counts();
         };
 
 
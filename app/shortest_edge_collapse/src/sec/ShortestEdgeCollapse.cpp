@@ -55,12 +55,9 @@ ShortestEdgeCollapse::ShortestEdgeCollapse(
 
 void ShortestEdgeCollapse::set_freeze(TriMesh::Tuple& v)
 {
-    for (auto e : get_one_ring_edges_for_vertex(v)) {
-        if (is_boundary_edge(e)) {
-            vertex_attrs[v.vid(*this)].freeze = true;
-            continue;
-        }
-    }
+    for_each_edge_around_vertex(v, [&](const Tuple& e) {
+        if (is_boundary_edge(e)) vertex_attrs[v.vid(*this)].freeze = true;
+    });
 }
 
 void ShortestEdgeCollapse::create_mesh_nofreeze(
@@ -174,7 +171,7 @@ std::vector<TriMesh::Tuple> ShortestEdgeCollapse::new_edges_after(
 
 bool ShortestEdgeCollapse::collapse_shortest(int target_vert_number)
 {
-    size_t initial_size = get_vertices().size();
+    size_t initial_size = vertex_size();
     auto collect_all_ops = std::vector<std::pair<std::string, Tuple>>();
     for (auto& loc : get_edges()) collect_all_ops.emplace_back("edge_collapse", loc);
 
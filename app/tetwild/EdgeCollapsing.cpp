@@ -28,7 +28,7 @@ void tetwild::TetWild::collapse_all_edges(bool is_limit_length)
     auto setup_and_execute = [&](auto& executor) {
         executor.renew_neighbor_tuples = [&](const auto& m, auto op, const auto& newts) {
             count_success++;
-            std::vector<std::pair<std::string, wmtk::TetMesh::Tuple>> op_tups;
+            std::vector<std::pair<decltype(op), wmtk::TetMesh::Tuple>> op_tups;
             for (auto t : newts) {
                 op_tups.emplace_back(op, t);
                 op_tups.emplace_back(op, t.switch_vertex(m));
@@ -70,7 +70,7 @@ void tetwild::TetWild::collapse_all_edges(bool is_limit_length)
     };
     if (NUM_THREADS > 0) {
         timer.start();
-        auto executor = wmtk::ExecutePass<TetWild, wmtk::ExecutionPolicy::kPartition>();
+        auto executor = wmtk::ExecutePass<TetWild, wmtk::ExecutionPolicy::kStealing>();
         executor.lock_vertices = [](auto& m, const auto& e, int task_id) -> bool {
             return m.try_set_edge_mutex_two_ring(e, task_id);
         };
@@ -123,29 +123,25 @@ bool tetwild::TetWild::collapse_edge_before(const Tuple& loc) // input is an edg
     }
 
 
-    auto n1_locs = get_one_ring_tets_for_vertex(loc);
-    auto n12_locs = get_incident_tets_for_edge(loc); // todo: duplicated computation
-
-    std::map<size_t, double> qs;
+    // the one rings are sorted, so the tets of v1 that are not around the edge, and that change
+    // with the collapse, are merged out of them without any map
+    const auto& n1_tids = one_ring_tids(v1_id);
+    const auto& n2_tids = one_ring_tids(v2_id);
     cache.max_energy = 0;
-    for (auto& l : n1_locs) {
-        qs[l.tid(*this)] = m_tet_attribute[l.tid(*this)].m_quality; // get_quality(l);
-        cache.max_energy = std::max(cache.max_energy, qs[l.tid(*this)]);
-    }
-    for (auto& l : n12_locs) {
-        qs.erase(l.tid(*this));
-    }
-
-
-    for (auto& q : qs) {
-        //
-        cache.changed_tids.push_back(q.first);
+    for (size_t tid : n1_tids) {
+        cache.max_energy = std::max(cache.max_energy, m_tet_attribute[tid].m_quality);
     }
+    std::set_difference(
+        n1_tids.begin(),
+        n1_tids.end(),
+        n2_tids.begin(),
+        n2_tids.end(),
+        std::back_inserter(cache.changed_tids));
 
     //
     std::set<int> unique_fid;
-    for (auto& t : n12_locs) {
-        auto vs = oriented_tet_vids(t);
+    for_each_incident_tid_of_edge(v1_id, v2_id, [&](size_t tid) {
+        auto vs = oriented_tet_vids(tuple_from_tet(tid));
         std::array<size_t, 3> f_vids = {{v1_id, 0, 0}};
         int cnt = 1;
         for (int j = 0; j < 4; j++) {
@@ -156,18 +152,18 @@ bool tetwild::TetWild::collapse_edge_before(const Tuple& loc) // input is an edg
         }
         auto [_1, global_fid1] = tuple_from_face(f_vids);
         auto [it, suc] = unique_fid.insert(global_fid1);
-        if (!suc) continue;
+        if (!suc) return;
 
         auto [_2, global_fid2] = tuple_from_face({{v2_id, f_vids[1], f_vids[2]}});
         auto f_attr = m_face_attribute[global_fid1];
         f_attr.merge(m_face_attribute[global_fid2]);
         cache.changed_faces.push_back(std::make_pair(f_attr, f_vids));
-    }
+    });
 
     if (VA[v1_id].m_is_on_surface) {
         std::vector<std::array<size_t, 3>> fs;
-        for (auto& t : n1_locs) {
-            auto vs = oriented_tet_vids(t);
+        for (size_t tid : n1_tids) {
+            auto vs = oriented_tet_vids(tuple_from_tet(tid));
 
             int j_v1 = -1;
             auto skip = [&]() {
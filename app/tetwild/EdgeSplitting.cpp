@@ -37,7 +37,7 @@ void tetwild::TetWild::split_all_edges()
     };
     if (NUM_THREADS > 0) {
         timer.start();
-        auto executor = wmtk::ExecutePass<TetWild, wmtk::ExecutionPolicy::kPartition>();
+        auto executor = wmtk::ExecutePass<TetWild, wmtk::ExecutionPolicy::kStealing>();
         executor.lock_vertices = [&](auto& m, const auto& e, int task_id) -> bool {
             return m.try_set_edge_mutex_two_ring(e, task_id);
         };
@@ -124,7 +124,7 @@ bool tetwild::TetWild::split_edge_after(const Tuple& loc)
             (m_vertex_attribute[v1_id].m_pos + m_vertex_attribute[v2_id].m_pos) / 2;
         m_vertex_attribute[v_id].m_posf = m_vertex_attribute[v_id].m_pos.cast<double>();
     } else
-        m_vertex_attribute[v_id].m_pos = m_vertex_attribute[v_id].m_posf.cast<wmtk::Rational>();
+        m_vertex_attribute[v_id].m_pos = m_vertex_attribute[v_id].m_posf.cast<tetwild::Rational>();
 
     /// update quality
     for (auto& loc : locs) {
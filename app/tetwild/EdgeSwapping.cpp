@@ -90,7 +90,7 @@ void tetwild::TetWild::swap_all_edges()
     };
     if (NUM_THREADS > 0) {
         timer.start();
-        auto executor = wmtk::ExecutePass<TetWild, wmtk::ExecutionPolicy::kPartition>();
+        auto executor = wmtk::ExecutePass<TetWild, wmtk::ExecutionPolicy::kStealing>();
         executor.lock_vertices = [](auto& m, const auto& e, int task_id) -> bool {
             return m.try_set_edge_mutex_two_ring(e, task_id);
         };
@@ -123,7 +123,7 @@ void tetwild::TetWild::swap_all_faces()
     };
     if (NUM_THREADS > 0) {
         timer.start();
-        auto executor = wmtk::ExecutePass<TetWild, wmtk::ExecutionPolicy::kPartition>();
+        auto executor = wmtk::ExecutePass<TetWild, wmtk::ExecutionPolicy::kStealing>();
         executor.lock_vertices = [](auto& m, const auto& e, int task_id) -> bool {
             return m.try_set_face_mutex_two_ring(e, task_id);
         };
@@ -145,7 +145,7 @@ bool tetwild::TetWild::swap_edge_before(const Tuple& t)
     if (!TetMesh::swap_edge_before(t)) return false;
 
     if (is_edge_on_surface(t) || is_edge_on_bbox(t)) return false;
-    auto incident_tets = get_incident_tets_for_edge(t);
+    const auto& incident_tets = get_incident_tets_for_edge_scratch(t);
     auto max_energy = -1.0;
     for (auto& l : incident_tets) {
         max_energy = std::max(m_tet_attribute[l.tid(*this)].m_quality, max_energy);
@@ -213,7 +213,7 @@ bool tetwild::TetWild::swap_face_after(const Tuple& t)
 {
     if (!TetMesh::swap_face_after(t)) return false;
 
-    auto incident_tets = get_incident_tets_for_edge(t);
+    const auto& incident_tets = get_incident_tets_for_edge_scratch(t);
 
     auto max_energy = -1.0;
     for (auto& l : incident_tets) {
@@ -252,7 +252,7 @@ void tetwild::TetWild::swap_all_edges_44()
     };
     if (NUM_THREADS > 0) {
         timer.start();
-        auto executor = wmtk::ExecutePass<TetWild, wmtk::ExecutionPolicy::kPartition>();
+        auto executor = wmtk::ExecutePass<TetWild, wmtk::ExecutionPolicy::kStealing>();
         executor.lock_vertices = [](auto& m, const auto& e, int task_id) -> bool {
             return m.try_set_edge_mutex_two_ring(e, task_id);
         };
@@ -273,7 +273,7 @@ bool tetwild::TetWild::swap_edge_44_before(const Tuple& t)
     if (!TetMesh::swap_edge_44_before(t)) return false;
 
     if (is_edge_on_surface(t) || is_edge_on_bbox(t)) return false;
-    auto incident_tets = get_incident_tets_for_edge(t);
+    const auto& incident_tets = get_incident_tets_for_edge_scratch(t);
     auto max_energy = -1.0;
     for (auto& l : incident_tets) {
         max_energy = std::max(m_tet_attribute[l.tid(*this)].m_quality, max_energy);
@@ -294,7 +294,7 @@ bool tetwild::TetWild::swap_edge_44_after(const Tuple& t)
 {
     if (!TetMesh::swap_edge_44_after(t)) return false;
 
-    auto incident_tets = get_incident_tets_for_edge(t);
+    const auto& incident_tets = get_incident_tets_for_edge_scratch(t);
 
     auto max_energy = -1.0;
     for (auto& l : incident_tets) {
@@ -21,6 +21,8 @@ struct Parameters
 
     double stop_energy = 10;
 
+    bool reorder_mesh = false; // renumber the mesh along a Morton order when consolidating
+
     void init(const Vector3d& min_, const Vector3d& max_)
     {
         min = min_;
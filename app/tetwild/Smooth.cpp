@@ -27,7 +27,7 @@ bool tetwild::TetWild::smooth_after(const Tuple& t)
     wmtk::logger().trace("Newton iteration for vertex smoothing.");
     auto vid = t.vid(*this);
 
-    auto locs = get_one_ring_tets_for_vertex(t);
+    const auto& locs = get_one_ring_tets_for_vertex_scratch(t);
     auto max_quality = 0.;
     for (auto& tet : locs) {
         max_quality = std::max(max_quality, m_tet_attribute[tet.tid(*this)].m_quality);
@@ -60,11 +60,7 @@ bool tetwild::TetWild::smooth_after(const Tuple& t)
 
     auto old_pos = m_vertex_attribute[vid].m_posf;
     auto old_asssembles = assembles;
-    m_vertex_attribute[vid].m_posf = wmtk::newton_method_from_stack(
-        assembles,
-        wmtk::AMIPS_energy,
-        wmtk::AMIPS_jacobian,
-        wmtk::AMIPS_hessian);
+    m_vertex_attribute[vid].m_posf = wmtk::AMIPS_newton_method_from_stack(assembles);
     wmtk::logger().trace(
         "old pos {} -> new pos {}",
         old_pos.transpose(),
@@ -116,17 +112,19 @@ bool tetwild::TetWild::smooth_after(const Tuple& t)
     }
 
     // quality
-    auto max_after_quality = 0.;
     for (auto& loc : locs) {
         if (is_inverted(loc)) return false;
-        auto t_id = loc.tid(*this);
-        m_tet_attribute[t_id].m_quality = get_quality(loc);
-        max_after_quality = std::max(max_after_quality, m_tet_attribute[t_id].m_quality);
+    }
+    const auto qualities = get_qualities(locs);
+    auto max_after_quality = 0.;
+    for (size_t i = 0; i < locs.size(); i++) {
+        m_tet_attribute[locs[i].tid(*this)].m_quality = qualities[i];
+        max_after_quality = std::max(max_after_quality, qualities[i]);
     }
     if (max_after_quality > max_quality) return false;
 
 
-    m_vertex_attribute[vid].m_pos = m_vertex_attribute[vid].m_posf.cast<wmtk::Rational>();
+    m_vertex_attribute[vid].m_pos = m_vertex_attribute[vid].m_posf.cast<tetwild::Rational>();
 
 
     return true;
@@ -146,9 +144,12 @@ void tetwild::TetWild::smooth_all_vertices()
     wmtk::logger().debug("Num verts {}", collect_all_ops.size());
     if (NUM_THREADS > 0) {
         timer.start();
-        auto executor = wmtk::ExecutePass<TetWild, wmtk::ExecutionPolicy::kPartition>();
-        executor.lock_vertices = [](auto& m, const auto& e, int task_id) -> bool {
-            return m.try_set_vertex_mutex_one_ring(e, task_id);
+        auto executor = wmtk::ExecutePass<TetWild, wmtk::ExecutionPolicy::kColor>();
+        // smoothing only touches the one-ring of the vertex
+        executor.conflict_vertices = [](auto& m, auto, const auto& e) {
+            auto vids = m.get_one_ring_vids_for_vertex(e.vid(m));
+            vids.push_back(e.vid(m));
+            return vids;
         };
         executor.num_threads = NUM_THREADS;
         executor(*this, collect_all_ops);
@@ -57,14 +57,21 @@ void tetwild::TetWild::mesh_improvement(int max_its)
         ///energy check
         wmtk::logger().info("max energy {} stop {}", max_energy, m_params.stop_energy);
         if (max_energy < m_params.stop_energy) break;
-        consolidate_mesh();
+        if (m_params.reorder_mesh)
+            consolidate_mesh([this](size_t i) { return m_vertex_attribute[i].m_posf; });
+        else
+            consolidate_mesh();
         wmtk::logger().info("v {} t {}", vert_capacity(), tet_capacity());
 
-        auto cnt_round = 0, cnt_verts = 0;
-        TetMesh::for_each_vertex([&](auto& v) {
-            if (m_vertex_attribute[v.vid(*this)].m_is_rounded) cnt_round++;
-            cnt_verts++;
-        });
+        auto [cnt_round, cnt_verts] = TetMesh::reduce_vertex(
+            std::pair<size_t, size_t>(0, 0),
+            [&](auto& cnt, auto& v) {
+                if (m_vertex_attribute[v.vid(*this)].m_is_rounded) cnt.first++;
+                cnt.second++;
+            },
+            [](auto& a, auto& b) {
+                return std::pair<size_t, size_t>(a.first + b.first, a.second + b.second);
+            });
         if (cnt_round < cnt_verts) {
             wmtk::logger().info("rounded {}/{}", cnt_round, cnt_verts);
         } else {
@@ -92,6 +99,12 @@ void tetwild::TetWild::mesh_improvement(int max_its)
 
     wmtk::logger().info("========it post========");
     local_operations({{0, 1, 0, 0}});
+
+    const auto amips = wmtk::AMIPS_p3_counters();
+    wmtk::logger().info(
+        "AMIPS energies escalated to rationals {}/{}",
+        amips.num_escalations,
+        amips.num_evaluations);
 }
 
 std::tuple<double, double> tetwild::TetWild::local_operations(
@@ -443,19 +456,25 @@ double tetwild::TetWild::get_length2(const wmtk::TetMesh::Tuple& l) const
 
 std::tuple<double, double> tetwild::TetWild::get_max_avg_energy()
 {
-    double max_energy = -1.;
-    double avg_energy = 0.;
-    auto cnt = 0;
-    TetMesh::for_each_tetra([&](auto& t) {
-        auto q = m_tet_attribute[t.tid(*this)].m_quality;
-        max_energy = std::max(max_energy, q);
-        avg_energy += std::cbrt(q);
-        cnt++;
-    });
-
-    avg_energy /= cnt;
+    struct EnergyStats
+    {
+        double max = -1.;
+        double sum = 0.; // of the cube roots
+        size_t cnt = 0;
+    };
+    auto stats = TetMesh::reduce_tetra(
+        EnergyStats(),
+        [&](EnergyStats& s, auto& t) {
+            auto q = m_tet_attribute[t.tid(*this)].m_quality;
+            s.max = std::max(s.max, q);
+            s.sum += std::cbrt(q);
+            s.cnt++;
+        },
+        [](const EnergyStats& a, const EnergyStats& b) {
+            return EnergyStats{std::max(a.max, b.max), a.sum + b.sum, a.cnt + b.cnt};
+        });
 
-    return std::make_tuple(std::cbrt(max_energy), avg_energy);
+    return std::make_tuple(std::cbrt(stats.max), stats.sum / stats.cnt);
 }
 
 
@@ -514,10 +533,9 @@ bool tetwild::TetWild::round(const Tuple& v)
     auto old_pos = m_vertex_attribute[i].m_pos;
     m_vertex_attribute[i].m_pos << m_vertex_attribute[i].m_posf[0], m_vertex_attribute[i].m_posf[1],
         m_vertex_attribute[i].m_posf[2];
-    auto conn_tets = get_one_ring_tets_for_vertex(v);
     m_vertex_attribute[i].m_is_rounded = true;
-    for (auto& tet : conn_tets) {
-        if (is_inverted(tet)) {
+    for (size_t tid : one_ring_tids(i)) {
+        if (is_inverted(tuple_from_tet(tid))) {
             m_vertex_attribute[i].m_is_rounded = false;
             m_vertex_attribute[i].m_pos = old_pos;
             return false;
@@ -527,6 +545,15 @@ bool tetwild::TetWild::round(const Tuple& v)
     return true;
 }
 
+namespace {
+// the invalid energies, of the degenerate tets, are replaced by max_energy
+double quality_from_energy(double energy, double max_energy)
+{
+    if (std::isinf(energy) || std::isnan(energy) || energy < 27 - 1e-3) return max_energy;
+    return energy;
+}
+} // namespace
+
 double tetwild::TetWild::get_quality(const Tuple& loc) const
 {
     std::array<Vector3d, 4> ps;
@@ -545,15 +572,66 @@ double tetwild::TetWild::get_quality(const Tuple& loc) const
         for (auto k = 0; k < 4; k++)
             for (auto j = 0; j < 3; j++) T[k * 3 + j] = ps[k][j];
 
-        energy = wmtk::AMIPS_energy_stable_p3<wmtk::Rational>(T);
+        energy = wmtk::AMIPS_energy_stable_p3<tetwild::Rational>(T);
     } else {
-        std::array<wmtk::Rational, 12> T;
+        std::array<tetwild::Rational, 12> T;
         for (auto k = 0; k < 4; k++)
             for (auto j = 0; j < 3; j++) T[k * 3 + j] = m_vertex_attribute[its[k]].m_pos[j];
-        energy = wmtk::AMIPS_energy_rational_p3<wmtk::Rational>(T);
+        energy = wmtk::AMIPS_energy_rational_p3<tetwild::Rational>(T);
     }
-    if (std::isinf(energy) || std::isnan(energy) || energy < 27 - 1e-3) return MAX_ENERGY;
-    return energy;
+    return quality_from_energy(energy, MAX_ENERGY);
+}
+
+std::vector<double> tetwild::TetWild::get_qualities(const std::vector<Tuple>& locs) const
+{
+    std::vector<double> qualities(locs.size());
+    wmtk::AMIPSBatch batch;
+    std::array<size_t, wmtk::AMIPS_BATCH_SIZE> batch_locs;
+    auto evaluate_batch = [&]() {
+        wmtk::AMIPSLanes energy;
+        const int escalated = wmtk::AMIPS_energy_p3_filtered_batch(batch, energy);
+        for (auto i = 0; i < batch.size; i++) {
+            if ((escalated >> i) & 1)
+                energy[i] = wmtk::AMIPS_energy_rational_p3<tetwild::Rational>(batch.tet(i));
+            qualities[batch_locs[i]] = quality_from_energy(energy[i], MAX_ENERGY);
+        }
+        batch.clear();
+    };
+
+    for (size_t i = 0; i < locs.size(); i++) {
+        auto its = oriented_tet_vids(locs[i]);
+        std::array<double, 12> T;
+        auto is_rounded = true;
+        for (auto k = 0; k < 4 && is_rounded; k++) {
+            is_rounded = m_vertex_attribute[its[k]].m_is_rounded;
+            for (auto j = 0; j < 3; j++) T[k * 3 + j] = m_vertex_attribute[its[k]].m_posf[j];
+        }
+        if (!is_rounded) {
+            qualities[i] = get_quality(locs[i]);
+            continue;
+        }
+        batch_locs[batch.size] = i;
+        batch.push_back(T);
+        if (batch.full()) evaluate_batch();
+    }
+    if (batch.size > 0) evaluate_batch();
+    return qualities;
+}
+
+void tetwild::TetWild::update_qualities()
+{
+    const auto tets = get_tets();
+    auto& arena = wmtk::ExecutionContext::instance().arena(NUM_THREADS);
+    arena.execute([&] {
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, tets.size(), 1024),
+            [&](const tbb::blocked_range<size_t>& r) {
+                const std::vector<Tuple> block(tets.begin() + r.begin(), tets.begin() + r.end());
+                const auto qualities = get_qualities(block);
+                for (size_t i = 0; i < block.size(); i++)
+                    m_tet_attribute[block[i].tid(*this)].m_quality = qualities[i];
+            });
+    });
 }
 
 
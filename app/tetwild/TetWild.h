@@ -149,7 +149,7 @@ public:
 
         wmtk::logger().info("Number of parts: {} by morton", NUM_THREADS);
 
-        tbb::task_arena arena(NUM_THREADS);
+        auto& arena = wmtk::ExecutionContext::instance().arena(NUM_THREADS);
 
         arena.execute([&] {
             std::vector<Eigen::Vector3d> V_v(vert_capacity());
@@ -289,6 +289,14 @@ public:
 
     bool is_inverted(const Tuple& loc) const;
     double get_quality(const Tuple& loc) const;
+    /**
+     * @brief get_quality of the tets, with the energies of the rounded tets evaluated in batches
+     */
+    std::vector<double> get_qualities(const std::vector<Tuple>& locs) const;
+    /**
+     * @brief recomputes the qualities of all the tets, in parallel
+     */
+    void update_qualities();
     bool round(const Tuple& loc);
     //
     bool is_edge_on_surface(const Tuple& loc);
@@ -145,7 +145,7 @@ auto internal_insert_single_triangle(
     };
 
     const auto& [flag, intersected_tets, intersected_edges, intersected_pos] =
-        wmtk::triangle_insert_prepare_info<wmtk::Rational>(
+        wmtk::triangle_insert_prepare_info<tetwild::Rational>(
             m,
             face,
             marked_tet_faces, // output
@@ -220,7 +220,7 @@ void tetwild::TetWild::init_from_input_surface(
         wmtk::logger().info("insertion queue {}: {}", i, insertion_queues[i].size());
     }
 
-    tbb::task_arena arena(insertion_queues.size());
+    auto& arena = wmtk::ExecutionContext::instance().arena(insertion_queues.size());
     tbb::task_group tg;
 
     arena.execute([&, &m = *this, &tet_face_tags = this->tet_face_tags]() {
@@ -355,7 +355,7 @@ void tetwild::TetWild::init_from_input_surface(
 
 void tetwild::TetWild::finalize_triangle_insertion(const std::vector<std::array<size_t, 3>>& faces)
 {
-    tbb::task_arena arena(std::max(NUM_THREADS, 1));
+    auto& arena = wmtk::ExecutionContext::instance().arena(std::max(NUM_THREADS, 1));
 
     arena.execute([&faces, this] {
         tbb::parallel_for(this->tet_face_tags.range(), [&faces, this](auto& r) {
@@ -442,7 +442,6 @@ void tetwild::TetWild::finalize_triangle_insertion(const std::vector<std::array<
         wmtk::logger().info("cnt_round {}/{}", cnt_round, vert_capacity());
 
         //// init qualities
-        auto& m = *this;
-        for_each_tetra([&m](auto& t) { m.m_tet_attribute[t.tid(m)].m_quality = m.get_quality(t); });
+        update_qualities();
     });
 }
@@ -8,15 +8,24 @@
 #include <vector>
 
 #include <Eigen/Core>
+#include <wmtk/utils/LazyRational.hpp>
 #include <wmtk/utils/Rational.hpp>
 
 namespace tetwild {
 
+// the exact coordinates, which stay doubles until they need a rational with the cmake option
+// WMTK_TETWILD_LAZY_RATIONAL
+#if defined(WMTK_TETWILD_LAZY_RATIONAL)
+typedef wmtk::LazyRational Rational;
+#else
+typedef wmtk::Rational Rational;
+#endif
+
 typedef Eigen::Vector3d Vector3d;
-typedef Eigen::Matrix<wmtk::Rational, 3, 1> Vector3r;
+typedef Eigen::Matrix<Rational, 3, 1> Vector3r;
 
 typedef Eigen::Vector2d Vector2d;
-typedef Eigen::Matrix<wmtk::Rational, 2, 1> Vector2r;
+typedef Eigen::Matrix<Rational, 2, 1> Vector2r;
 
 typedef double Scalar;
 typedef Eigen::Matrix<Scalar, 3, 3> Matrix3;
@@ -11,6 +11,7 @@
 
 #include <memory>
 #include <vector>
+#include <wmtk/utils/GmpMemoryPool.hpp>
 #include <wmtk/utils/ManifoldUtils.hpp>
 #include <wmtk/utils/partition_utils.hpp>
 #include "wmtk/utils/InsertTriangleUtils.hpp"
@@ -39,6 +40,7 @@ int main(int argc, char** argv)
     int NUM_THREADS = 0;
     int max_its = 10;
     bool filter_with_input = false;
+    bool gmp_memory_pool = false;
 
     app.add_option("-i,--input", input_path, "Input mesh.");
     app.add_option("-o,--output", output_path, "Output mesh.");
@@ -56,7 +58,16 @@ int main(int argc, char** argv)
         "--sample-envelope",
         use_sample_envelope,
         "use_sample_envelope for both simp and optim");
+    app.add_flag(
+        "--reorder-mesh",
+        params.reorder_mesh,
+        "renumber the mesh along a Morton order at every consolidation");
+    app.add_flag(
+        "--gmp-memory-pool",
+        gmp_memory_pool,
+        "allocate the rationals from per-thread pools instead of malloc");
     CLI11_PARSE(app, argc, argv);
+    if (gmp_memory_pool) wmtk::use_gmp_memory_pool();
 
     std::vector<Eigen::Vector3d> verts;
     std::vector<std::array<size_t, 3>> tris;
@@ -28,7 +28,7 @@ TEST_CASE("tetwild_file_write", "[tetwild_operation]")
     std::vector<TetAttributes> tet_attrs(1);
     for (auto& v : vertices) {
         v.m_is_rounded = true;
-        v.m_pos = v.m_posf.cast<wmtk::Rational>();
+        v.m_pos = v.m_posf.cast<tetwild::Rational>();
     }
 
     tetwild.init(vertices.size(), tets);
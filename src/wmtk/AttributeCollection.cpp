@@ -30,5 +30,17 @@ std::optional<size_t> AbstractAttributeCollection::end_protect()
 
     return {};
 }
+void AbstractAttributeCollection::consolidate(const std::vector<size_t>& new2old, size_t stride)
+{
+    // new2old is any permutation, so the blocks are first moved out of the way
+    const size_t n = size();
+    const size_t n_moved = new2old.size() * stride;
+    resize(n + n_moved);
+    for (size_t i = 0; i < new2old.size(); i++) {
+        for (size_t j = 0; j < stride; j++) move(new2old[i] * stride + j, n + i * stride + j);
+    }
+    for (size_t k = 0; k < n_moved; k++) move(n + k, k);
+    resize(n);
+}
 AbstractAttributeCollection::~AbstractAttributeCollection() = default;
 AbstractAttributeCollection::AbstractAttributeCollection() = default;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <wmtk/utils/Compaction.hpp>
+#include <wmtk/utils/RollbackLog.hpp>
 #include <wmtk/utils/VectorUtils.h>
 #include <wmtk/utils/Logger.hpp>
 
@@ -12,6 +14,7 @@
 #include <list>
 #include <map>
 #include <optional>
+#include <tuple>
 
 namespace wmtk {
 /**
@@ -28,6 +31,11 @@ public:
     AbstractAttributeCollection();
     virtual ~AbstractAttributeCollection();
     virtual void move(size_t /*from*/, size_t to) = 0;
+    // sets an element back to a default-constructed value, when its slot is reused
+    virtual void reset(size_t i) = 0;
+    // moves the blocks of stride elements starting at new2old[i] * stride to i * stride. The
+    // default implementation calls move sequentially, through scratch slots past the end.
+    virtual void consolidate(const std::vector<size_t>& new2old, size_t stride);
     // resize an attribute, including shrinking its size
     // in potentially parallel code use grow_to_at_least insetad
     virtual void resize(size_t) = 0;
@@ -73,6 +81,22 @@ struct AttributeCollection : public AbstractAttributeCollection
         }
         m_attributes[to] = std::move(m_attributes[from]);
     }
+    void reset(size_t i) override
+    {
+        // disallow unprotected access with an active recorder
+        if (!in_protected.local()) {
+            assert(!has_recorders());
+        }
+        m_attributes[i] = T();
+    }
+    void consolidate(const std::vector<size_t>& new2old, size_t stride) override
+    {
+        // disallow unprotected access with an active recorder
+        if (!in_protected.local()) {
+            assert(!has_recorders());
+        }
+        compact_in_place(m_attributes, new2old, stride);
+    }
     void resize(size_t s) override
     {
         // disallow unprotected access with an active recorder
@@ -88,7 +112,7 @@ struct AttributeCollection : public AbstractAttributeCollection
                 // we need to copy out these elements:
                 // [        s, ... ,m_attributes.size()-1]
                 for (size_t j = s; j < m_attributes.size(); ++j) {
-                    rollback[j] = m_attributes[j];
+                    rollback.record(j, m_attributes[j]);
                 }
             }
         }
@@ -122,8 +146,10 @@ struct AttributeCollection : public AbstractAttributeCollection
     void rollback() override
     {
         grow_to_at_least(m_rollback_size.local());
+        // swapping leaves the memory of the discarded values to the log, for the next operations
+        using std::swap;
         for (auto& [i, v] : m_rollback_list.local()) {
-            m_attributes[i] = std::move(v);
+            swap(m_attributes[i], v);
         }
         in_protected.local() = false;
         end_protect();
@@ -153,7 +179,7 @@ struct AttributeCollection : public AbstractAttributeCollection
     T& operator[](size_t i)
     {
         if (in_protected.local()) {
-            m_rollback_list.local().emplace(i, m_attributes[i]);
+            m_rollback_list.local().record(i, m_attributes[i]);
         } else {
             // disallow unprotected access with an active recorder
             assert(!has_recorders());
@@ -164,8 +190,81 @@ struct AttributeCollection : public AbstractAttributeCollection
     const T& at(size_t i) const { return m_attributes[i]; }
 
     size_t size() const override { return m_attributes.size(); }
-    tbb::enumerable_thread_specific<std::map<size_t, T>> m_rollback_list;
+    tbb::enumerable_thread_specific<RollbackLog<T>> m_rollback_list;
     // experimenting with tbb, could be templated as well.
     tbb::concurrent_vector<T> m_attributes;
 };
+
+/**
+ * @brief attributes stored as one AttributeCollection per field. The columns are protected
+ * separately, so an operation only records the values of the columns it accesses without const,
+ * e.g. a smoothing that moves the positions does not copy the other fields of its vertices.
+ * Recorders are added to the columns.
+ *
+ */
+template <typename... Ts>
+class AttributeColumns : public AbstractAttributeCollection
+{
+public:
+    template <size_t I>
+    using Column = AttributeCollection<std::tuple_element_t<I, std::tuple<Ts...>>>;
+
+    template <size_t I>
+    Column<I>& column()
+    {
+        return std::get<I>(m_columns);
+    }
+    template <size_t I>
+    const Column<I>& column() const
+    {
+        return std::get<I>(m_columns);
+    }
+
+    void move(size_t from, size_t to) override
+    {
+        for_each_column([&](auto& c) { c.move(from, to); });
+    }
+    void reset(size_t i) override
+    {
+        for_each_column([&](auto& c) { c.reset(i); });
+    }
+    void consolidate(const std::vector<size_t>& new2old, size_t stride) override
+    {
+        for_each_column([&](auto& c) { c.consolidate(new2old, stride); });
+    }
+    void resize(size_t s) override
+    {
+        for_each_column([&](auto& c) { c.resize(s); });
+    }
+    void grow_to_at_least(size_t s) override
+    {
+        for_each_column([&](auto& c) { c.grow_to_at_least(s); });
+    }
+    size_t size() const override { return std::get<0>(m_columns).size(); }
+
+    void rollback() override
+    {
+        for_each_column([](auto& c) { c.rollback(); });
+        in_protected.local() = false;
+    }
+    void begin_protect() override
+    {
+        for_each_column([](auto& c) { c.begin_protect(); });
+        AbstractAttributeCollection::begin_protect();
+    }
+    std::optional<size_t> end_protect() override
+    {
+        for_each_column([](auto& c) { c.end_protect(); });
+        return AbstractAttributeCollection::end_protect();
+    }
+
+private:
+    template <typename F>
+    void for_each_column(F&& f)
+    {
+        std::apply([&](auto&... c) { (f(c), ...); }, m_columns);
+    }
+
+    std::tuple<AttributeCollection<Ts>...> m_columns;
+};
 } // namespace wmtk
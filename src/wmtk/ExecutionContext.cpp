@@ -0,0 +1,107 @@
+#include <wmtk/ExecutionContext.hpp>
+
+// clang-format off
+#include <wmtk/utils/DisableWarnings.hpp>
+#include <tbb/task_scheduler_observer.h>
+#include <wmtk/utils/EnableWarnings.hpp>
+// clang-format on
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace wmtk;
+
+namespace {
+#ifdef __linux__
+// the affinity of the current thread before each of the arenas it entered, innermost last, or
+// nothing when it was not pinned in that arena
+struct SavedAffinity
+{
+    bool pinned = false;
+    cpu_set_t mask;
+};
+thread_local std::vector<SavedAffinity> saved_affinities;
+#endif
+} // namespace
+
+/**
+ * @brief pins the threads entering its arena, when the context asks for it, and restores their
+ * affinity when they leave it
+ */
+class ExecutionContext::Observer : public tbb::task_scheduler_observer
+{
+public:
+    Observer(tbb::task_arena& arena, const ExecutionContext& context)
+        : tbb::task_scheduler_observer(arena)
+        , m_context(context)
+    {
+        observe(true);
+    }
+    ~Observer() { observe(false); }
+
+    void on_scheduler_entry(bool) override
+    {
+#ifdef __linux__
+        auto& saved = saved_affinities.emplace_back();
+        if (!m_context.thread_pinning()) return;
+        const int slot = tbb::this_task_arena::current_thread_index();
+        const unsigned num_cores = std::max(std::thread::hardware_concurrency(), 1u);
+        if (slot < 0 || sched_getaffinity(0, sizeof(cpu_set_t), &saved.mask) != 0) return;
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        CPU_SET(slot % num_cores, &mask);
+        saved.pinned = sched_setaffinity(0, sizeof(cpu_set_t), &mask) == 0;
+#endif
+    }
+
+    void on_scheduler_exit(bool) override
+    {
+#ifdef __linux__
+        if (saved_affinities.empty()) return;
+        auto& saved = saved_affinities.back();
+        if (saved.pinned) sched_setaffinity(0, sizeof(cpu_set_t), &saved.mask);
+        saved_affinities.pop_back();
+#endif
+    }
+
+private:
+    const ExecutionContext& m_context;
+};
+
+struct ExecutionContext::Arena
+{
+    Arena(int num_threads, const ExecutionContext& context)
+        : arena(num_threads)
+        , observer(arena, context)
+    {}
+
+    tbb::task_arena arena;
+    Observer observer; // declared last, so that it stops observing before the arena goes away
+};
+
+ExecutionContext& ExecutionContext::instance()
+{
+    // never destroyed, so that the arenas outlive the static objects that may still use them, and
+    // are not torn down after the scheduler itself at exit
+    static auto* context = new ExecutionContext();
+    return *context;
+}
+
+tbb::task_arena& ExecutionContext::arena(int num_threads)
+{
+    tbb::spin_mutex::scoped_lock lock(m_mutex);
+    auto& a = m_arenas[num_threads];
+    if (!a) a = std::make_unique<Arena>(num_threads, *this);
+    return a->arena;
+}
+
+size_t ExecutionContext::num_arenas() const
+{
+    tbb::spin_mutex::scoped_lock lock(m_mutex);
+    return m_arenas.size();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+// clang-format off
+#include <wmtk/utils/DisableWarnings.hpp>
+#include <tbb/spin_mutex.h>
+#include <tbb/task_arena.h>
+#include <wmtk/utils/EnableWarnings.hpp>
+// clang-format on
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <utility>
+
+namespace wmtk {
+
+/**
+ * @brief The task arenas shared by all the parallel helpers of the toolkit.
+ *
+ * Constructing a tbb::task_arena for each pass wakes its worker threads up again and loses the
+ * cache affinity between consecutive passes, which dominates the short passes on small meshes.
+ * The context instead keeps one arena per number of threads for the lifetime of the program.
+ * Each arena has its own observer, which optionally pins the threads that join it to cores.
+ */
+class ExecutionContext
+{
+public:
+    /**
+     * @brief the context of the program
+     */
+    static ExecutionContext& instance();
+
+    /**
+     * @brief the arena with the given number of threads, created on first use. Thread safe.
+     *
+     * The arenas are never destroyed, so that a helper can be called from a task of another arena.
+     */
+    tbb::task_arena& arena(int num_threads);
+
+    /**
+     * @brief runs f in the arena with the given number of threads, and returns its result
+     */
+    template <typename F>
+    decltype(auto) execute(int num_threads, F&& f)
+    {
+        return arena(num_threads).execute(std::forward<F>(f));
+    }
+
+    /**
+     * @brief pins the i-th thread of an arena to the i-th core while it works in the arena, or
+     * stops pinning them. Applies to the threads entering an arena afterwards, only on Linux.
+     */
+    void set_thread_pinning(bool pin) { m_pin_threads = pin; }
+    bool thread_pinning() const { return m_pin_threads; }
+
+    /**
+     * @return the number of arenas created so far
+     */
+    size_t num_arenas() const;
+
+private:
+    ExecutionContext() = default;
+
+    class Observer;
+    struct Arena;
+
+    mutable tbb::spin_mutex m_mutex;
+    std::map<int, std::unique_ptr<Arena>> m_arenas;
+    std::atomic_bool m_pin_threads = false;
+};
+
+} // namespace wmtk
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "wmtk/ExecutionContext.hpp"
+#include "wmtk/ExecutionTelemetry.hpp"
 #include "wmtk/TetMesh.h"
 #include "wmtk/TriMesh.h"
 #include "wmtk/TriMeshOperation.h"
@@ -11,6 +13,7 @@
 #include <wmtk/utils/DisableWarnings.hpp>
 #include <tbb/concurrent_priority_queue.h>
 #include <tbb/concurrent_queue.h>
+#include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_reduce.h>
 #include <tbb/spin_mutex.h>
@@ -21,19 +24,72 @@
 
 #include <Tracy.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <optional>
 #include <queue>
+#include <set>
 #include <stdexcept>
+#include <thread>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+#include <variant>
 
 namespace wmtk {
-enum class ExecutionPolicy { kSeq, kUnSeq, kPartition, kColor, kMax };
+/**
+ * @brief kPartition runs one queue per partition, kStealing additionally lets a task whose
+ * partition is drained take batches of work from the other partitions. kColor does not lock,
+ * it executes operations with disjoint ExecutePass::conflict_vertices in parallel.
+ */
+enum class ExecutionPolicy { kSeq, kUnSeq, kPartition, kStealing, kColor, kMax };
 
 using Op = std::string;
 
-template <class AppMesh, ExecutionPolicy policy = ExecutionPolicy::kSeq>
+/**
+ * @brief An operation as ExecutePass hands it to its callbacks: the name, and the id the pass
+ * interned the name to. It converts to the name, so callbacks can still compare or copy it, and
+ * the elements renew_neighbor_tuples returns with it are queued without looking the name up.
+ *
+ * @note the name is owned by the ExecutePass, a copy stays valid as long as the ExecutePass
+ * object. The id only holds during the pass that handed it out, later passes look the name up.
+ */
+class InternedOp
+{
+public:
+    InternedOp(const Op& name, size_t id)
+        : m_name(&name)
+        , m_id(id)
+    {}
+
+    const Op& name() const { return *m_name; }
+    size_t id() const { return m_id; }
+    operator const Op&() const { return *m_name; }
+
+    friend bool operator==(const InternedOp& a, const Op& b) { return *a.m_name == b; }
+    friend bool operator==(const InternedOp& a, const char* b) { return *a.m_name == b; }
+    friend bool operator!=(const InternedOp& a, const Op& b) { return *a.m_name != b; }
+    friend bool operator!=(const InternedOp& a, const char* b) { return *a.m_name != b; }
+
+private:
+    const Op* m_name;
+    size_t m_id;
+};
+
+/**
+ * @brief Runs a pass of operations over a mesh.
+ *
+ * @tparam StaticOperations (TriMesh only) operation types derived from TriMeshOperationShim that
+ * are dispatched by index at compile time, without map lookups or virtual calls. They are still
+ * referred to by their name(), and take precedence over registered operations of the same name.
+ */
+template <
+    class AppMesh,
+    ExecutionPolicy policy = ExecutionPolicy::kSeq,
+    typename... StaticOperations>
 struct ExecutePass
 {
     using Tuple = typename AppMesh::Tuple;
@@ -41,6 +97,9 @@ struct ExecutePass
     constexpr static bool IsTetMesh = std::is_base_of_v<wmtk::TetMesh, AppMesh>;
     // assume other than tetmesh we just have TriMesh
     using OperationType = std::conditional_t<IsTetMesh, OperatorFunc, TriMeshOperation>;
+    static_assert(
+        !IsTetMesh || sizeof...(StaticOperations) == 0,
+        "compile-time operation lists are only supported for TriMesh");
     /**
      * @brief A dictionary that registers names with operations.
      *
@@ -53,23 +112,32 @@ struct ExecutePass
         Op, // strings
         std::shared_ptr<OperationType>>
         new_edit_operation_maps;
+    /**
+     * @brief the instances of the compile-time operations
+     */
+    std::tuple<StaticOperations...> static_operations;
     /**
      * @brief Priority function (default to edge length)
      *
      */
-    std::function<double(const AppMesh&, Op op, const Tuple&)> priority = [](auto&, auto, auto&) {
-        return 0.;
-    };
+    std::function<double(const AppMesh&, InternedOp op, const Tuple&)> priority =
+        [](auto&, auto, auto&) { return 0.; };
     /**
      * @brief check on wheather new operations should be added to the prioirity queue
      *
      */
     std::function<bool(double)> should_renew = [](auto) { return true; };
+    /**
+     * @brief The elements renew_neighbor_tuples queues, either with operation names, or with the
+     * InternedOp it received, which saves looking the names up for each element.
+     */
+    using RenewedTuples =
+        std::variant<std::vector<std::pair<Op, Tuple>>, std::vector<std::pair<InternedOp, Tuple>>>;
     /**
      * @brief renew neighboring Tuples after each operation depends on the operation
      *
      */
-    std::function<std::vector<std::pair<Op, Tuple>>(const AppMesh&, Op, const std::vector<Tuple>&)>
+    std::function<RenewedTuples(const AppMesh&, InternedOp, const std::vector<Tuple>&)>
         renew_neighbor_tuples =
             [](auto&, auto, auto&) -> std::vector<std::pair<Op, Tuple>> { return {}; };
     /**
@@ -97,10 +165,12 @@ struct ExecutePass
      * @brief Should Process drops some Tuple from being processed.
          For example, if the energy is out-dated.
          This is in addition to calling tuple valid.
+         The element refers to the queued tuple, and is not copied.
      *
      */
-    std::function<bool(const AppMesh&, const std::tuple<double, Op, Tuple>& t)>
-        is_weight_up_to_date = [](const AppMesh& m, const std::tuple<double, Op, Tuple>& t) {
+    using QueuedElement = std::tuple<double, InternedOp, const Tuple&>;
+    std::function<bool(const AppMesh&, const QueuedElement& t)> is_weight_up_to_date =
+        [](const AppMesh& m, const QueuedElement& t) {
             // always do.
             assert(std::get<2>(t).is_valid(m));
             return true;
@@ -109,17 +179,72 @@ struct ExecutePass
      * @brief
      *used to collect operations that are not finished and used for later re-execution
      */
-    std::function<void(const AppMesh&, Op, const Tuple& t)> on_fail = [](auto&, auto, auto&) {};
+    std::function<void(const AppMesh&, InternedOp, const Tuple& t)> on_fail =
+        [](auto&, auto, auto&) {};
 
 
     size_t num_threads = 1;
 
     /**
-     * To Avoid mutual locking, retry limit is set, and then put in a serial queue in the end.
+     * To Avoid mutual locking, retry limit is set, and then put in a queue that is retried with
+     * coarser partitions after the parallel phase, and serially in the end.
      *
      */
     size_t max_retry_limit = 10;
 
+    /**
+     * @brief (kStealing only) the maximal number of elements an idle task takes at once from
+     * another partition's queue.
+     */
+    size_t steal_batch_size = 16;
+
+    /**
+     * @brief Renewed elements and lock retries are kept in a heap private to the task, which is
+     * merged with the shared partition queue while popping. With kStealing, this many elements
+     * are moved to the shared queue at once when the private heap grows over twice the size, so
+     * that idle tasks can steal them. 0 pushes every element to the shared queue directly.
+     */
+    size_t renewal_batch_size = 64;
+
+    /**
+     * @brief (kColor only) the vertices an operation reads or modifies. Two operations sharing a
+     * vertex are never executed concurrently. Defaults to the two-ring of the edge, the same
+     * region as locked by try_set_edge_mutex_two_ring.
+     */
+    std::function<std::vector<size_t>(const AppMesh&, InternedOp, const Tuple&)> conflict_vertices =
+        [](const AppMesh& m, InternedOp, const Tuple& e) {
+            const size_t v1 = e.vid(m);
+            const size_t v2 = e.switch_vertex(m).vid(m);
+            std::vector<size_t> vids = {v1, v2};
+            for (auto v : {v1, v2}) {
+                for (auto v_one_ring : m.get_one_ring_vids_for_vertex(v)) {
+                    vids.push_back(v_one_ring);
+                    for (auto v_two_ring : m.get_one_ring_vids_for_vertex(v_one_ring))
+                        vids.push_back(v_two_ring);
+                }
+            }
+            std::sort(vids.begin(), vids.end());
+            vids.erase(std::unique(vids.begin(), vids.end()), vids.end());
+            return vids;
+        };
+
+    /**
+     * @brief collect the statistics of the next runs into telemetry. This adds some timing and
+     * bookkeeping to every processed element.
+     */
+    bool collect_telemetry = false;
+
+    /**
+     * @brief (collect_telemetry only) the queue depths are sampled every that many processed
+     * elements.
+     */
+    size_t telemetry_sampling_frequency = 1000;
+
+    /**
+     * @brief the statistics of the last run, only filled when collect_telemetry is set.
+     */
+    ExecutionTelemetry telemetry;
+
     /* 
      * Add an operation to the set of operation types
      */
@@ -225,18 +350,39 @@ struct ExecutePass
 
 
 private:
+    // the names of the operations of all the passes, which the InternedOp point to
+    std::set<Op> interned_names;
+
     void operation_cleanup(AppMesh& m)
     { //
         // class ResourceManger
         // what about RAII mesh edit locking?
         // release mutex, but this should be implemented in TetMesh class.
-        if constexpr (policy == ExecutionPolicy::kSeq)
+        if constexpr (policy == ExecutionPolicy::kSeq || policy == ExecutionPolicy::kColor)
             return;
         else {
             m.release_vertex_mutex_in_stack();
         }
     }
 
+    template <size_t... I>
+    TriMeshOperation::ExecuteReturnData execute_static_operation(
+        [[maybe_unused]] int index,
+        [[maybe_unused]] AppMesh& m,
+        [[maybe_unused]] const Tuple& t,
+        std::index_sequence<I...>)
+    {
+        auto ret_data = TriMeshOperation::ExecuteReturnData();
+        ret_data.success = false;
+        // an empty fold is a lone false, which would warn as an unused value
+        if constexpr (sizeof...(I) > 0) {
+            (void)((size_t(index) == I &&
+                    (ret_data = std::get<I>(static_operations)(m, t), true)) ||
+                   ...);
+        }
+        return ret_data;
+    }
+
     size_t get_partition_id(const AppMesh& m, const Tuple& e)
     {
         if constexpr (policy == ExecutionPolicy::kSeq) return 0;
@@ -263,15 +409,163 @@ public:
         auto cnt_success = std::atomic<int>(0);
         auto cnt_fail = std::atomic<int>(0);
         auto stop = std::atomic<bool>(false);
-        using Elem = std::tuple<double, Op, Tuple, size_t>;
+        // (priority, operation id, tuple, retry count)
+        using Elem = std::tuple<double, size_t, Tuple, size_t>;
         auto queues = std::vector<tbb::concurrent_priority_queue<Elem>>(num_threads);
         auto final_queue = tbb::concurrent_priority_queue<Elem>();
 
+        // The operation names are interned to indices into op_names, in alphabetical order to
+        // break priority ties as before, so that queued elements do not carry strings and the
+        // operations are dispatched without a map lookup.
+        auto op_names = std::vector<const Op*>();
+        auto op_ids = std::map<Op, size_t>();
+        auto op_funcs = std::vector<OperationType*>();
+        auto static_op_index = std::vector<int>(); // -1 for the registered operations
+        {
+            auto all_ops = std::map<Op, std::pair<OperationType*, int>>();
+            if constexpr (IsTetMesh) {
+                for (auto& [name, func] : edit_operation_maps) all_ops[name] = {&func, -1};
+            } else {
+                for (auto& [name, func] : new_edit_operation_maps)
+                    all_ops[name] = {func.get(), -1};
+            }
+            std::apply(
+                [&all_ops](auto&... ops) {
+                    int i = 0;
+                    ((all_ops[ops.name()] = {nullptr, i++}), ...);
+                },
+                static_operations);
+            for (auto& [name, entry] : all_ops) {
+                op_ids[name] = op_names.size();
+                op_names.push_back(&*interned_names.insert(name).first);
+                op_funcs.push_back(entry.first);
+                static_op_index.push_back(entry.second);
+            }
+        }
+        auto interned_op = [&op_names](size_t op_id) {
+            return InternedOp(*op_names[op_id], op_id);
+        };
+        // Only the names are looked up, the InternedOp given to the callbacks of this pass already
+        // has its id.
+        auto intern = [&op_names, &op_ids, &interned_op](const auto& op) -> InternedOp {
+            if constexpr (std::is_same_v<std::decay_t<decltype(op)>, InternedOp>) {
+                if (op.id() < op_names.size() && op_names[op.id()] == &op.name()) return op;
+            }
+            auto it = op_ids.find(op);
+            if (it == op_ids.end())
+                throw std::runtime_error("ExecutePass: unknown operation " + Op(op));
+            return interned_op(it->second);
+        };
+        // Appends the renewed elements that should be renewed, with their priorities.
+        auto append_renewed = [&](RenewedTuples&& renewed, std::vector<Elem>& elements) {
+            std::visit(
+                [&](auto& op_tuples) {
+                    for (auto& [o, e] : op_tuples) {
+                        const auto op = intern(o);
+                        auto val = priority(m, op, e);
+                        if (should_renew(val)) elements.emplace_back(val, op.id(), e, 0);
+                    }
+                },
+                renewed);
+        };
+
+        telemetry = ExecutionTelemetry();
+        auto local_telemetry = tbb::enumerable_thread_specific<ExecutionTelemetry>();
+        auto cnt_processed = std::atomic<size_t>(0);
+        const auto start_time = std::chrono::steady_clock::now();
+        auto seconds_since = [](const std::chrono::steady_clock::time_point& t) {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+        };
+        // The wall time of the tasks is accumulated into idle_time, and their busy time is
+        // subtracted once everything is finished.
+        auto run_timed = [&](size_t slot, auto&& func) {
+            if (!collect_telemetry) return func();
+            const auto task_start_time = std::chrono::steady_clock::now();
+            func();
+            local_telemetry.local().add_idle_time(slot, seconds_since(task_start_time));
+        };
+
+        // Runs op on tup and returns the new elements, or an empty optional if it failed.
+        auto execute_operation = [&](size_t op_id,
+                                     const Tuple& tup) -> std::optional<std::vector<Tuple>> {
+            const Op& op = *op_names[op_id];
+            if (collect_telemetry)
+                OperationPhaseTimer::thread_storage() = &local_telemetry.local().phase_time;
+            auto newtup = std::optional<std::vector<Tuple>>();
+            if constexpr (std::is_base_of<wmtk::TriMesh, AppMesh>::value) {
+                auto ret_data = static_op_index[op_id] < 0
+                                    ? (*op_funcs[op_id])(m, tup)
+                                    : execute_static_operation(
+                                          static_op_index[op_id],
+                                          m,
+                                          tup,
+                                          std::index_sequence_for<StaticOperations...>());
+                if (ret_data.success) newtup = std::move(ret_data.new_tris);
+            } else {
+                newtup = (*op_funcs[op_id])(m, tup);
+            }
+            if (collect_telemetry) {
+                OperationPhaseTimer::thread_storage() = nullptr;
+                auto& counters = local_telemetry.local().operations[op];
+                (newtup ? counters.success : counters.fail)++;
+            }
+            if (newtup) {
+                cnt_success++;
+                cnt_update++;
+            } else {
+                on_fail(m, interned_op(op_id), tup);
+                cnt_fail++;
+            }
+            return newtup;
+        };
+
+        auto sample_queue_depths = [&](ExecutionTelemetry& local) {
+            auto depth = ExecutionTelemetry::QueueDepth();
+            depth.time = seconds_since(start_time);
+            for (auto& q : queues) depth.num_queued += q.size();
+            depth.num_final = final_queue.size();
+            local.queue_depths.push_back(depth);
+        };
+
         auto run_single_queue = [&](auto& Q, int task_id) {
+            // Only this task pushes into its private heap. Popping moves the top of Q into the
+            // heap first, so the elements are still processed in priority order.
+            auto private_heap = std::priority_queue<Elem>();
+            auto push = [&](Elem&& ele) {
+                if (renewal_batch_size == 0)
+                    Q.emplace(std::move(ele));
+                else
+                    private_heap.emplace(std::move(ele));
+            };
+            auto pop = [&](Elem& ele) {
+                if (private_heap.empty()) return Q.try_pop(ele);
+                if (!Q.empty() && Q.try_pop(ele)) private_heap.emplace(std::move(ele));
+                ele = private_heap.top();
+                private_heap.pop();
+                return true;
+            };
+            auto share_batch = [&]() {
+                if constexpr (policy == ExecutionPolicy::kStealing) {
+                    if (private_heap.size() <= 2 * renewal_batch_size) return;
+                    for (size_t i = 0; i < renewal_batch_size; i++) {
+                        Q.emplace(private_heap.top());
+                        private_heap.pop();
+                    }
+                }
+            };
+
             auto ele_in_queue = Elem();
-            while ([&]() { return Q.try_pop(ele_in_queue); }()) {
-                auto& [weight, op, tup, retry] = ele_in_queue;
-                if (!tup.is_valid(m)) continue;
+            while (pop(ele_in_queue)) {
+                auto& [weight, op_id, tup, retry] = ele_in_queue;
+                const Op& op = *op_names[op_id];
+                auto* local = collect_telemetry ? &local_telemetry.local() : nullptr;
+                auto busy_timer = ExecutionTelemetry::ScopedBusyTime(local, task_id);
+                if (local && ++cnt_processed % telemetry_sampling_frequency == 0)
+                    sample_queue_depths(*local);
+                if (!tup.is_valid(m)) {
+                    if (local) local->operations[op].invalid++;
+                    continue;
+                }
 
                 std::vector<Elem> renewed_elements;
                 {
@@ -280,58 +574,42 @@ public:
                         tup,
                         task_id); // Note that returning `Tuples` would be invalid.
                     if (!locked_vid) {
+                        if (local) {
+                            local->operations[op].lock_fail++;
+                            local->add_lock_failure(task_id);
+                        }
                         retry++;
                         if (retry < max_retry_limit) {
-                            Q.emplace(ele_in_queue);
+                            push(std::move(ele_in_queue));
                         } else {
                             retry = 0;
                             final_queue.emplace(ele_in_queue);
                         }
                         continue;
                     }
-                    if (tup.is_valid(m)) {
+                    if (local) local->add_retry_count(retry);
+                    if (!tup.is_valid(m)) {
+                        if (local) local->operations[op].invalid++;
+                    } else {
                         if (!is_weight_up_to_date(
                                 m,
-                                std::tuple<double, Op, Tuple>(
-                                    std::get<0>(ele_in_queue),
-                                    std::get<1>(ele_in_queue),
-                                    std::get<2>(ele_in_queue)))) {
+                                QueuedElement(weight, interned_op(op_id), tup))) {
+                            if (local) local->operations[op].outdated++;
                             operation_cleanup(m);
                             continue;
                         } // this can encode, in qslim, recompute(energy) == weight.
-                        std::vector<std::pair<Op, Tuple>> renewed_tuples;
-                        if constexpr (std::is_base_of<wmtk::TriMesh, AppMesh>::value) {
-                            auto ret_data = (*new_edit_operation_maps[op])( m, tup);
-                            if (ret_data.success) {
-                                renewed_tuples = renew_neighbor_tuples(m, op, ret_data.new_tris);
-                                cnt_success++;
-                                cnt_update++;
-                            } else {
-                                on_fail(m, op, tup);
-                                cnt_fail++;
-                            }
-                        } else {
-                            auto newtup = edit_operation_maps[op](m, tup);
-                            if (newtup) {
-                                renewed_tuples = renew_neighbor_tuples(m, op, newtup.value());
-                                cnt_success++;
-                                cnt_update++;
-                            } else {
-                                on_fail(m, op, tup);
-                                cnt_fail++;
-                            }
-                        }
-
-                        for (auto& [o, e] : renewed_tuples) {
-                            auto val = priority(m, o, e);
-                            if (should_renew(val)) renewed_elements.emplace_back(val, o, e, 0);
+                        if (auto newtup = execute_operation(op_id, tup); newtup) {
+                            append_renewed(
+                                renew_neighbor_tuples(m, interned_op(op_id), newtup.value()),
+                                renewed_elements);
                         }
                     }
                     operation_cleanup(m); // Maybe use RAII
                 }
                 for (auto& e : renewed_elements) {
-                    Q.emplace(e);
+                    push(std::move(e));
                 }
+                share_batch();
 
                 if (stop.load(std::memory_order_acquire)) return;
                 if (cnt_success > stopping_criterion_checking_frequency) {
@@ -345,33 +623,301 @@ public:
             }
         };
 
+        // Move up to steal_batch_size of the highest priority elements from another partition
+        // to the queue of task_id. Closer partition ids are tried first: with the morton
+        // partitioning they are also spatially closer, and lock_vertices is less likely to fail.
+        auto steal_from_other_queues = [&](int task_id) {
+            const int num_queues = queues.size();
+            auto ele_in_queue = Elem();
+            for (int offset = 1; offset < num_queues; offset++) {
+                for (int victim : {task_id + offset, task_id - offset}) {
+                    if (victim < 0 || victim >= num_queues) continue;
+                    size_t cnt_stolen = 0;
+                    while (cnt_stolen < steal_batch_size && queues[victim].try_pop(ele_in_queue)) {
+                        queues[task_id].emplace(ele_in_queue);
+                        cnt_stolen++;
+                    }
+                    if (cnt_stolen > 0) return true;
+                }
+            }
+            return false;
+        };
+
+        // Only the owner of a queue pushes into it (renewed elements and lock-failure retries),
+        // and it drains its own queue before stealing, so no element is left behind when the
+        // last busy task finishes. Tasks that have not been scheduled yet are not counted as
+        // busy: the arena may have fewer threads than partitions, and their queues are either
+        // stolen from or processed once they start.
+        auto num_busy_tasks = std::atomic<int>(0);
+        auto run_queue = [&](int task_id) {
+            if constexpr (policy != ExecutionPolicy::kStealing) {
+                run_single_queue(queues[task_id], task_id);
+            } else {
+                num_busy_tasks++;
+                while (true) {
+                    run_single_queue(queues[task_id], task_id);
+                    num_busy_tasks--;
+                    while (true) {
+                        if (stop.load(std::memory_order_acquire)) return;
+                        if (steal_from_other_queues(task_id)) {
+                            num_busy_tasks++;
+                            break;
+                        }
+                        if (num_busy_tasks.load(std::memory_order_acquire) == 0) return;
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        };
+
+        // (kColor) Operations are greedily colored such that the conflict_vertices of two
+        // operations with the same color are disjoint, then the color classes are executed one
+        // after the other, each with a lock-free parallel_for. Colors are claimed speculatively
+        // with an atomic fetch_or on a per-vertex color mask, so the coloring is parallel as well.
+        // An operation is deferred to the next round if it cannot get one of the 64 colors, or
+        // if an operation of an earlier color changed the connectivity around it, which makes its
+        // conflict region out of date. Only the deferred and the renewed operations are colored
+        // again in the next round.
+        auto run_colored_rounds = [&](std::vector<Elem>& pending) {
+            constexpr int max_num_colors = 64;
+            auto vertex_colors = std::vector<std::atomic<uint64_t>>();
+            auto vertex_modified_round = std::vector<std::atomic<size_t>>();
+            auto next_pending = tbb::enumerable_thread_specific<std::vector<Elem>>();
+            for (size_t round = 1; !pending.empty(); round++) {
+                if (vertex_colors.size() < m.vert_capacity()) {
+                    // all the entries are zero between rounds, the old ones do not need copying.
+                    vertex_colors = std::vector<std::atomic<uint64_t>>(2 * m.vert_capacity());
+                    vertex_modified_round = std::vector<std::atomic<size_t>>(2 * m.vert_capacity());
+                }
+                std::sort(pending.begin(), pending.end(), std::greater<Elem>());
+                if (collect_telemetry) {
+                    auto depth = ExecutionTelemetry::QueueDepth();
+                    depth.time = seconds_since(start_time);
+                    depth.num_queued = pending.size();
+                    telemetry.queue_depths.push_back(depth);
+                }
+
+                const size_t num_ops = pending.size();
+                auto regions = std::vector<std::vector<size_t>>(num_ops);
+                auto colors = std::vector<int>(num_ops, max_num_colors);
+                tbb::parallel_for(size_t(0), num_ops, [&](size_t i) {
+                    auto& [weight, op_id, tup, retry] = pending[i];
+                    if (!tup.is_valid(m)) return;
+                    regions[i] = conflict_vertices(m, interned_op(op_id), tup);
+                    uint64_t forbidden = 0;
+                    while (true) {
+                        for (auto v : regions[i])
+                            forbidden |= vertex_colors[v].load(std::memory_order_relaxed);
+                        int c = 0;
+                        while (c < max_num_colors && (forbidden >> c & 1)) c++;
+                        if (c == max_num_colors) {
+                            colors[i] = -1; // deferred
+                            return;
+                        }
+                        const uint64_t bit = uint64_t(1) << c;
+                        bool claimed = true;
+                        for (auto v : regions[i]) {
+                            if (vertex_colors[v].fetch_or(bit) & bit) {
+                                claimed = false;
+                                break;
+                            }
+                        }
+                        if (claimed) {
+                            colors[i] = c;
+                            return;
+                        }
+                        forbidden |= bit;
+                    }
+                });
+
+                // bucket the operations by color, keeping the priority order inside a color
+                auto color_offsets = std::vector<size_t>(max_num_colors + 1, 0);
+                for (size_t i = 0; i < num_ops; i++) {
+                    if (colors[i] == -1)
+                        next_pending.local().emplace_back(pending[i]);
+                    else if (colors[i] < max_num_colors)
+                        color_offsets[colors[i] + 1]++;
+                }
+                for (int c = 0; c < max_num_colors; c++) color_offsets[c + 1] += color_offsets[c];
+                auto order = std::vector<size_t>(color_offsets.back());
+                {
+                    auto fill = std::vector<size_t>(color_offsets.begin(), color_offsets.end() - 1);
+                    for (size_t i = 0; i < num_ops; i++)
+                        if (colors[i] >= 0 && colors[i] < max_num_colors)
+                            order[fill[colors[i]]++] = i;
+                }
+
+                for (int c = 0; c < max_num_colors && !stop.load(); c++) {
+                    tbb::parallel_for(color_offsets[c], color_offsets[c + 1], [&](size_t k) {
+                        const size_t i = order[k];
+                        auto& [weight, op_id, tup, retry] = pending[i];
+                        const Op& op = *op_names[op_id];
+                        auto* local = collect_telemetry ? &local_telemetry.local() : nullptr;
+                        auto busy_timer = ExecutionTelemetry::ScopedBusyTime(
+                            local,
+                            tbb::this_task_arena::current_thread_index());
+                        if (!tup.is_valid(m)) {
+                            if (local) local->operations[op].invalid++;
+                            return;
+                        }
+                        for (auto v : regions[i]) {
+                            if (vertex_modified_round[v].load(std::memory_order_relaxed) ==
+                                round) {
+                                next_pending.local().emplace_back(pending[i]);
+                                return;
+                            }
+                        }
+                        if (!is_weight_up_to_date(
+                                m,
+                                QueuedElement(weight, interned_op(op_id), tup))) {
+                            if (local) local->operations[op].outdated++;
+                            return;
+                        }
+                        auto newtup = execute_operation(op_id, tup);
+                        if (!newtup) return;
+                        for (auto& t : newtup.value()) {
+                            size_t vids[4];
+                            size_t num_vids = 0;
+                            if constexpr (IsTetMesh) {
+                                for (auto v : m.oriented_tet_vids(t)) vids[num_vids++] = v;
+                            } else {
+                                for (auto v : m.oriented_tri_vids(t)) vids[num_vids++] = v;
+                            }
+                            for (size_t j = 0; j < num_vids; j++) {
+                                if (vids[j] < vertex_modified_round.size())
+                                    vertex_modified_round[vids[j]].store(
+                                        round,
+                                        std::memory_order_relaxed);
+                            }
+                        }
+                        append_renewed(
+                            renew_neighbor_tuples(m, interned_op(op_id), newtup.value()),
+                            next_pending.local());
+                    });
+                    if (cnt_success > stopping_criterion_checking_frequency) {
+                        if (stopping_criterion(m)) stop.store(true);
+                        cnt_update.store(0, std::memory_order_release);
+                    }
+                    FrameMark;
+                }
+                if (stop.load()) return;
+
+                tbb::parallel_for(size_t(0), num_ops, [&](size_t i) {
+                    for (auto v : regions[i]) vertex_colors[v].store(0, std::memory_order_relaxed);
+                });
+                pending.clear();
+                for (auto& local_pending : next_pending) {
+                    pending.insert(pending.end(), local_pending.begin(), local_pending.end());
+                    local_pending.clear();
+                }
+                logger().debug("Color round {}: {} operations remain", round, pending.size());
+            }
+        };
+
         if constexpr (policy == ExecutionPolicy::kSeq) {
             for (auto& [op, e] : operation_tuples) {
                 if (!e.is_valid(m)) continue;
-                final_queue.emplace(priority(m, op, e), op, e, 0);
+                const auto interned = intern(op);
+                final_queue.emplace(priority(m, interned, e), interned.id(), e, 0);
+            }
+            run_timed(0, [&]() { run_single_queue(final_queue, 0); });
+        } else if constexpr (policy == ExecutionPolicy::kColor) {
+            auto pending = std::vector<Elem>();
+            for (auto& [op, e] : operation_tuples) {
+                if (!e.is_valid(m)) continue;
+                const auto interned = intern(op);
+                pending.emplace_back(priority(m, interned, e), interned.id(), e, 0);
+            }
+            auto& arena = ExecutionContext::instance().arena(num_threads);
+            const auto color_start_time = std::chrono::steady_clock::now();
+            arena.execute([&]() { run_colored_rounds(pending); });
+            if (collect_telemetry) {
+                for (size_t i = 0; i < num_threads; i++)
+                    telemetry.add_idle_time(i, seconds_since(color_start_time));
             }
-            run_single_queue(final_queue, 0);
         } else {
             for (auto& [op, e] : operation_tuples) {
                 if (!e.is_valid(m)) continue;
-                queues[get_partition_id(m, e)].emplace(priority(m, op, e), op, e, 0);
+                const auto interned = intern(op);
+                queues[get_partition_id(m, e)].emplace(
+                    priority(m, interned, e),
+                    interned.id(),
+                    e,
+                    0);
             }
-            // Comment out parallel: work on serial first.
-            tbb::task_arena arena(num_threads);
-            tbb::task_group tg;
-            arena.execute([&queues, &run_single_queue, &tg]() {
-                for (int task_id = 0; task_id < queues.size(); task_id++) {
-                    tg.run([&run_single_queue, &queues, task_id] {
-                        run_single_queue(queues[task_id], task_id);
-                    });
-                }
-                tg.wait();
-            });
+            auto& arena = ExecutionContext::instance().arena(num_threads);
+            auto run_queues_in_parallel = [&arena, &queues, &run_queue, &run_timed]() {
+                tbb::task_group tg;
+                arena.execute([&queues, &run_queue, &run_timed, &tg]() {
+                    for (int task_id = 0; task_id < queues.size(); task_id++) {
+                        tg.run([&run_timed, &run_queue, task_id] {
+                            run_timed(task_id, [&]() { run_queue(task_id); });
+                        });
+                    }
+                    tg.wait();
+                });
+            };
+            run_queues_in_parallel();
             logger().debug("Parallel Complete, remains element {}", final_queue.size());
-            run_single_queue(final_queue, 0);
+
+            // The elements that exceeded max_retry_limit are mostly around partition boundaries.
+            // Retry them in parallel with coarser partitions, merging neighboring partition ids
+            // (which are spatially close with the morton partitioning), and only run what is
+            // left serially when there is a single partition left or a round made no progress.
+            for (size_t num_partitions = queues.size() / 2, round = 1;
+                 num_partitions > 1 && !final_queue.empty() && !stop.load();
+                 num_partitions /= 2, round++) {
+                const size_t num_left = final_queue.size();
+                const int success_before = cnt_success;
+                const int fail_before = cnt_fail;
+
+                queues = std::vector<tbb::concurrent_priority_queue<Elem>>(num_partitions);
+                auto ele_in_queue = Elem();
+                while (final_queue.try_pop(ele_in_queue)) {
+                    auto& [weight, op_id, tup, retry] = ele_in_queue;
+                    if (!tup.is_valid(m)) continue;
+                    retry = 0;
+                    auto pid = get_partition_id(m, tup) * num_partitions / num_threads;
+                    queues[std::min(pid, num_partitions - 1)].emplace(ele_in_queue);
+                }
+                run_queues_in_parallel();
+
+                logger().info(
+                    "Retry round {} with {} partitions: {} elements, {} success, {} fail, {} left",
+                    round,
+                    num_partitions,
+                    num_left,
+                    cnt_success - success_before,
+                    cnt_fail - fail_before,
+                    final_queue.size());
+                if (collect_telemetry) {
+                    auto retry_round = ExecutionTelemetry::RetryRound();
+                    retry_round.num_partitions = num_partitions;
+                    retry_round.num_elements = num_left;
+                    retry_round.num_success = cnt_success - success_before;
+                    retry_round.num_fail = cnt_fail - fail_before;
+                    retry_round.num_left = final_queue.size();
+                    telemetry.retry_rounds.push_back(retry_round);
+                }
+                if (cnt_success == success_before && cnt_fail == fail_before &&
+                    final_queue.size() >= num_left)
+                    break;
+            }
+            if (collect_telemetry) telemetry.num_serial = final_queue.size();
+            run_timed(0, [&]() { run_single_queue(final_queue, 0); });
         }
 
         logger().info("cnt_success {} cnt_fail {}", cnt_success, cnt_fail);
+        if (collect_telemetry) {
+            for (auto& local : local_telemetry) telemetry.merge(local);
+            for (size_t i = 0; i < telemetry.busy_time.size(); i++)
+                telemetry.add_idle_time(i, -telemetry.busy_time[i]);
+            std::sort(
+                telemetry.queue_depths.begin(),
+                telemetry.queue_depths.end(),
+                [](const auto& a, const auto& b) { return a.time < b.time; });
+            telemetry.total_time = seconds_since(start_time);
+        }
         return true;
     }
 };
@@ -0,0 +1,109 @@
+#include <wmtk/ExecutionTelemetry.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <fstream>
+
+using namespace wmtk;
+
+namespace {
+template <typename T>
+void add_at(std::vector<T>& vec, size_t i, T value)
+{
+    if (vec.size() <= i) vec.resize(i + 1, T(0));
+    vec[i] += value;
+}
+
+template <typename T>
+void add_all(std::vector<T>& vec, const std::vector<T>& other)
+{
+    for (size_t i = 0; i < other.size(); i++) add_at(vec, i, other[i]);
+}
+} // namespace
+
+void ExecutionTelemetry::add_lock_failure(size_t partition)
+{
+    add_at(lock_failures_per_partition, partition, size_t(1));
+}
+
+void ExecutionTelemetry::add_retry_count(size_t retry)
+{
+    add_at(retry_histogram, retry, size_t(1));
+}
+
+void ExecutionTelemetry::add_busy_time(size_t slot, double time)
+{
+    add_at(busy_time, slot, time);
+}
+
+void ExecutionTelemetry::add_idle_time(size_t slot, double time)
+{
+    add_at(idle_time, slot, time);
+}
+
+void ExecutionTelemetry::merge(const ExecutionTelemetry& other)
+{
+    for (auto& [name, counters] : other.operations) {
+        auto& c = operations[name];
+        c.success += counters.success;
+        c.fail += counters.fail;
+        c.lock_fail += counters.lock_fail;
+        c.outdated += counters.outdated;
+        c.invalid += counters.invalid;
+    }
+    add_all(lock_failures_per_partition, other.lock_failures_per_partition);
+    add_all(retry_histogram, other.retry_histogram);
+    add_all(busy_time, other.busy_time);
+    add_all(idle_time, other.idle_time);
+    for (size_t i = 0; i < phase_time.size(); i++) phase_time[i] += other.phase_time[i];
+    queue_depths.insert(queue_depths.end(), other.queue_depths.begin(), other.queue_depths.end());
+    retry_rounds.insert(retry_rounds.end(), other.retry_rounds.begin(), other.retry_rounds.end());
+    num_serial += other.num_serial;
+}
+
+std::string ExecutionTelemetry::to_json(int indent) const
+{
+    nlohmann::json js;
+    js["total_time"] = total_time;
+    js["operations"] = nlohmann::json::object();
+    for (auto& [name, c] : operations) {
+        js["operations"][name] = {
+            {"success", c.success},
+            {"fail", c.fail},
+            {"lock_fail", c.lock_fail},
+            {"outdated", c.outdated},
+            {"invalid", c.invalid}};
+    }
+    js["lock_failures_per_partition"] = lock_failures_per_partition;
+    js["retry_histogram"] = retry_histogram;
+    js["queue_depths"] = nlohmann::json::array();
+    for (auto& q : queue_depths) {
+        js["queue_depths"].push_back(
+            {{"time", q.time}, {"num_queued", q.num_queued}, {"num_final", q.num_final}});
+    }
+    js["busy_time"] = busy_time;
+    js["idle_time"] = idle_time;
+    js["phase_time"] = {
+        {"before", phase_time[static_cast<size_t>(OperationPhase::kBefore)]},
+        {"execute", phase_time[static_cast<size_t>(OperationPhase::kExecute)]},
+        {"after", phase_time[static_cast<size_t>(OperationPhase::kAfter)]},
+        {"invariants", phase_time[static_cast<size_t>(OperationPhase::kInvariants)]},
+        {"rollback", phase_time[static_cast<size_t>(OperationPhase::kRollback)]}};
+    js["retry_rounds"] = nlohmann::json::array();
+    for (auto& r : retry_rounds) {
+        js["retry_rounds"].push_back(
+            {{"num_partitions", r.num_partitions},
+             {"num_elements", r.num_elements},
+             {"num_success", r.num_success},
+             {"num_fail", r.num_fail},
+             {"num_left", r.num_left}});
+    }
+    js["num_serial"] = num_serial;
+    return js.dump(indent);
+}
+
+void ExecutionTelemetry::dump_json(const std::string& path) const
+{
+    std::ofstream file(path);
+    file << to_json() << std::endl;
+}
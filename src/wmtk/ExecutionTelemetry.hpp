@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace wmtk {
+
+/**
+ * @brief The phases of a mesh operation, as timed by OperationPhaseTimer. kRollback is the time
+ * spent undoing the operations rejected by their after checks or invariants, so that kExecute
+ * only counts the execution itself.
+ */
+enum class OperationPhase { kBefore, kExecute, kAfter, kInvariants, kRollback, kMax };
+
+/**
+ * @brief Accumulates the wall time spent in the phases of a mesh operation. The times are only
+ * measured when ExecutePass collects telemetry, which sets the storage for the current thread,
+ * otherwise the timer does nothing.
+ */
+class OperationPhaseTimer
+{
+public:
+    using PhaseTimes = std::array<double, static_cast<size_t>(OperationPhase::kMax)>;
+
+    /**
+     * @brief the storage the timers of the current thread accumulate into, nullptr to disable.
+     */
+    static PhaseTimes*& thread_storage()
+    {
+        static thread_local PhaseTimes* storage = nullptr;
+        return storage;
+    }
+
+    OperationPhaseTimer(OperationPhase phase)
+        : m_storage(thread_storage())
+    {
+        start(phase);
+    }
+    ~OperationPhaseTimer() { stop(); }
+
+    /**
+     * @brief ends the current phase and starts timing the given one.
+     */
+    void start(OperationPhase phase)
+    {
+        if (m_storage == nullptr) return;
+        stop();
+        m_phase = phase;
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    void stop()
+    {
+        if (m_storage == nullptr || m_phase == OperationPhase::kMax) return;
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+        (*m_storage)[static_cast<size_t>(m_phase)] += elapsed.count();
+        m_phase = OperationPhase::kMax;
+    }
+
+private:
+    PhaseTimes* m_storage;
+    OperationPhase m_phase = OperationPhase::kMax;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * @brief Statistics of one ExecutePass run, collected when ExecutePass::collect_telemetry is set.
+ * All the times are in seconds.
+ */
+struct ExecutionTelemetry
+{
+    struct OperationCounters
+    {
+        size_t success = 0;
+        size_t fail = 0;
+        size_t lock_fail = 0;
+        size_t outdated = 0; // dropped by is_weight_up_to_date
+        size_t invalid = 0; // the tuple was invalidated before the operation was run
+    };
+    struct QueueDepth
+    {
+        double time = 0;
+        size_t num_queued = 0; // in the partition queues
+        size_t num_final = 0; // waiting for the retry rounds
+    };
+    struct RetryRound
+    {
+        size_t num_partitions = 0;
+        size_t num_elements = 0;
+        size_t num_success = 0;
+        size_t num_fail = 0;
+        size_t num_left = 0;
+    };
+
+    /**
+     * @brief adds the wall time of its scope to the busy time of a slot, does nothing if the
+     * telemetry is nullptr.
+     */
+    class ScopedBusyTime
+    {
+    public:
+        ScopedBusyTime(ExecutionTelemetry* telemetry, size_t slot)
+            : m_telemetry(telemetry)
+            , m_slot(slot)
+        {
+            if (m_telemetry) m_start = std::chrono::steady_clock::now();
+        }
+        ~ScopedBusyTime()
+        {
+            if (m_telemetry == nullptr) return;
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+            m_telemetry->add_busy_time(m_slot, elapsed.count());
+        }
+
+    private:
+        ExecutionTelemetry* m_telemetry;
+        size_t m_slot;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    double total_time = 0;
+    std::map<std::string, OperationCounters> operations;
+    std::vector<size_t> lock_failures_per_partition;
+    /**
+     * @brief number of operations that acquired their lock after i failed attempts
+     */
+    std::vector<size_t> retry_histogram;
+    std::vector<QueueDepth> queue_depths;
+    /**
+     * @brief per task (partition) for the queue based policies, per thread for kColor
+     */
+    std::vector<double> busy_time;
+    std::vector<double> idle_time;
+    OperationPhaseTimer::PhaseTimes phase_time = {};
+    std::vector<RetryRound> retry_rounds;
+    size_t num_serial = 0; // elements left for the final serial pass
+
+    void add_lock_failure(size_t partition);
+    void add_retry_count(size_t retry);
+    void add_busy_time(size_t slot, double time);
+    void add_idle_time(size_t slot, double time);
+    /**
+     * @brief adds up the counters and times of another (thread local) telemetry.
+     */
+    void merge(const ExecutionTelemetry& other);
+
+    std::string to_json(int indent = 2) const;
+    void dump_json(const std::string& path) const;
+};
+
+} // namespace wmtk
@@ -1,70 +1,100 @@
 #include <wmtk/TetMesh.h>
+#include <wmtk/ExecutionTelemetry.hpp>
 #include <wmtk/utils/TetMeshElementTopology.h>
 
 #include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
 #include <wmtk/AttributeCollection.hpp>
+#include <wmtk/utils/Compaction.hpp>
 #include <wmtk/utils/EnableWarnings.hpp>
+#include <wmtk/utils/ParallelCollect.hpp>
 #include <wmtk/utils/TupleUtils.hpp>
+#include <wmtk/utils/partition_utils.hpp>
 
 #include <Tracy.hpp>
 using namespace wmtk;
 
-int wmtk::TetMesh::get_next_empty_slot_t()
+void wmtk::TetMesh::reserve_tet_slab()
 {
-    while (current_tet_size + MAX_THREADS >= m_tet_connectivity.size() ||
-           tet_connectivity_synchronizing_flag) {
-        if (tet_connectivity_lock.try_lock()) {
-            if (current_tet_size + MAX_THREADS < m_tet_connectivity.size()) {
-                tet_connectivity_lock.unlock();
-                break;
-            }
-            tet_connectivity_synchronizing_flag = true;
-            auto current_capacity = m_tet_connectivity.size();
-            if (p_edge_attrs != nullptr) {
-                p_edge_attrs->grow_to_at_least(2 * current_capacity * 6);
-            }
-            if (p_face_attrs != nullptr) {
-                p_face_attrs->grow_to_at_least(2 * current_capacity * 4);
-            }
-            if (p_tet_attrs != nullptr) {
-                p_tet_attrs->grow_to_at_least(2 * current_capacity);
-            }
-            m_tet_connectivity.grow_to_at_least(2 * current_capacity);
-            tet_connectivity_synchronizing_flag = false;
-            tet_connectivity_lock.unlock();
-            break;
+    tbb::spin_mutex::scoped_lock lock(tet_connectivity_lock);
+    const size_t begin = current_tet_size;
+    const size_t end = begin + (NUM_THREADS > 1 ? SlotFreeList::slab_size : 1);
+    if (end > m_tet_connectivity.size()) {
+        const size_t capacity = std::max(2 * m_tet_connectivity.size(), end);
+        if (p_edge_attrs != nullptr) {
+            p_edge_attrs->grow_to_at_least(capacity * 6);
+        }
+        if (p_face_attrs != nullptr) {
+            p_face_attrs->grow_to_at_least(capacity * 4);
         }
+        if (p_tet_attrs != nullptr) {
+            p_tet_attrs->grow_to_at_least(capacity);
+        }
+        m_tet_connectivity.grow_to_at_least(capacity);
+        if (m_use_adjacency_cache) m_tet_adjacency.grow_to_at_least(capacity);
+    }
+
+    // the reserved slots are removed until they are handed out
+    for (size_t i = begin; i < end; i++) {
+        m_tet_connectivity[i].m_is_removed = true;
+        m_tet_connectivity[i].hash = -1;
     }
+    current_tet_size = end;
+    m_free_tets.reserve(begin, end);
+}
 
-    auto new_idx = current_tet_size++;
-    m_tet_connectivity[new_idx].hash = -1;
+int wmtk::TetMesh::get_next_empty_slot_t()
+{
+    auto tid = m_free_tets.pop();
+    if (!tid) {
+        reserve_tet_slab();
+        tid = m_free_tets.pop();
+    }
 
-    return new_idx;
+    // a removed slot keeps its hash, that the new tet increments
+    assert(m_tet_connectivity[*tid].m_is_removed);
+    m_tet_connectivity[*tid].m_is_removed = false;
+    m_tet_count.add(1);
+    return *tid;
 }
 
-int wmtk::TetMesh::get_next_empty_slot_v()
+void wmtk::TetMesh::reserve_vertex_slab()
 {
-    while (current_vert_size + MAX_THREADS >= m_vertex_connectivity.size() ||
-           vertex_connectivity_synchronizing_flag) {
-        if (vertex_connectivity_lock.try_lock()) {
-            if (current_vert_size + MAX_THREADS < m_vertex_connectivity.size()) {
-                vertex_connectivity_lock.unlock();
-                break;
-            }
-            vertex_connectivity_synchronizing_flag = true;
-            auto current_capacity = m_vertex_connectivity.size();
-            if (p_vertex_attrs != nullptr) {
-                p_vertex_attrs->grow_to_at_least(2 * current_capacity);
-            }
-            resize_vertex_mutex(2 * current_capacity);
-            m_vertex_connectivity.grow_to_at_least(2 * current_capacity);
-            vertex_connectivity_synchronizing_flag = false;
-            vertex_connectivity_lock.unlock();
-            break;
+    tbb::spin_mutex::scoped_lock lock(vertex_connectivity_lock);
+    const size_t begin = current_vert_size;
+    const size_t end = begin + (NUM_THREADS > 1 ? SlotFreeList::slab_size : 1);
+    check_connectivity_index_range(end);
+    if (end > m_vertex_connectivity.size()) {
+        const size_t capacity = std::max(2 * m_vertex_connectivity.size(), end);
+        if (p_vertex_attrs != nullptr) {
+            p_vertex_attrs->grow_to_at_least(capacity);
         }
+        resize_vertex_mutex(capacity);
+        m_vertex_connectivity.grow_to_at_least(capacity);
     }
 
-    return current_vert_size++;
+    for (size_t i = begin; i < end; i++) {
+        m_vertex_connectivity[i].m_is_removed = true;
+        m_vertex_connectivity[i].m_conn_tets.clear();
+    }
+    current_vert_size = end;
+    m_free_vertices.reserve(begin, end);
+}
+
+int wmtk::TetMesh::get_next_empty_slot_v()
+{
+    auto vid = m_free_vertices.pop();
+    if (!vid) {
+        reserve_vertex_slab();
+        vid = m_free_vertices.pop();
+    }
+
+    auto& vc = m_vertex_connectivity[*vid];
+    assert(vc.m_is_removed && vc.m_conn_tets.empty());
+    vc.m_is_removed = false;
+    if (p_vertex_attrs != nullptr) p_vertex_attrs->reset(*vid);
+    m_vertex_count.add(1);
+    return *vid;
 }
 
 wmtk::TetMesh::TetMesh()
@@ -77,12 +107,25 @@ wmtk::TetMesh::TetMesh()
 
 void wmtk::TetMesh::init(size_t n_vertices, const std::vector<std::array<size_t, 4>>& tets)
 {
+    check_connectivity_index_range(n_vertices);
     m_vertex_connectivity.resize(n_vertices);
     m_tet_connectivity.resize(tets.size());
     current_vert_size = n_vertices;
     current_tet_size = tets.size();
+    m_vertex_count.reset(n_vertices);
+    m_tet_count.reset(tets.size());
+    m_free_vertices.clear();
+    m_free_tets.clear();
+
+    // allocate each vertex list once, with the exact number of tets
+    std::vector<size_t> valences(n_vertices, 0);
+    for (auto& tet : tets)
+        for (auto v : tet) valences[v]++;
+    for (size_t i = 0; i < n_vertices; i++)
+        m_vertex_connectivity[i].m_conn_tets.reserve(valences[i]);
+
     for (int i = 0; i < tets.size(); i++) {
-        m_tet_connectivity[i].m_indices = tets[i];
+        m_tet_connectivity[i].set_vids(tets[i]);
         for (int j = 0; j < 4; j++) {
             assert(tets[i][j] < vert_capacity());
             m_vertex_connectivity[tets[i][j]].m_conn_tets.push_back(i);
@@ -106,40 +149,28 @@ void wmtk::TetMesh::init(size_t n_vertices, const std::vector<std::array<size_t,
     if (p_edge_attrs != nullptr) {
         p_edge_attrs->grow_to_at_least(6 * tets.size());
     }
+
+    if (m_use_adjacency_cache) build_adjacency_cache(m_tet_adjacency);
 }
 
 
 std::vector<wmtk::TetMesh::Tuple> wmtk::TetMesh::get_edges() const
 {
     ZoneScoped;
-    std::vector<std::tuple<size_t, size_t, TetMesh::Tuple>> edges;
-    edges.reserve(tet_capacity() * 6);
-    for (int i = 0; i < tet_capacity(); i++) {
-        if (m_tet_connectivity[i].m_is_removed) continue;
-        for (int j = 0; j < 6; j++) {
-            auto tup = tuple_from_edge(i, j);
-            auto v0 = tup.vid(*this);
-            auto v1 = tup.switch_vertex(*this).vid(*this);
-            if (v0 > v1) std::swap(v0, v1);
-            edges.emplace_back(v0, v1, tup);
-        }
-    }
-    std::sort(edges.begin(), edges.end(), [](auto& a, auto& b) {
-        return std::tie(std::get<0>(a), std::get<1>(a)) < std::tie(std::get<0>(b), std::get<1>(b));
+    // each edge is emitted once, by the tet of smallest tid around it, so that the tets are
+    // enumerated in parallel and the edges come out in the order of their eid, without any sort
+    std::vector<Tuple> edges;
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
+    arena.execute([&] {
+        edges = collect_in_order<Tuple>(tet_capacity(), [&](size_t i, std::vector<Tuple>& out) {
+            if (m_tet_connectivity[i].m_is_removed) return;
+            for (int j = 0; j < 6; j++) {
+                auto tup = tuple_from_edge(i, j);
+                if (tup.eid(*this) == 6 * i + j) out.push_back(tup);
+            }
+        });
     });
-    edges.erase(
-        std::unique(
-            edges.begin(),
-            edges.end(),
-            [](auto& a, auto& b) {
-                return std::tie(std::get<0>(a), std::get<1>(a)) ==
-                       std::tie(std::get<0>(b), std::get<1>(b));
-            }),
-        edges.end());
-    std::vector<TetMesh::Tuple> uniq_edges;
-    uniq_edges.reserve(edges.size());
-    for (auto& [v0, v1, e] : edges) uniq_edges.push_back(e);
-    return uniq_edges;
+    return edges;
 }
 
 
@@ -160,13 +191,16 @@ void wmtk::TetMesh::for_each_face(const std::function<void(const TetMesh::Tuple&
 std::vector<wmtk::TetMesh::Tuple> wmtk::TetMesh::get_faces() const
 {
     auto faces = std::vector<TetMesh::Tuple>();
-    for (int i = 0; i < tet_capacity(); i++) {
-        if (m_tet_connectivity[i].m_is_removed) continue;
-        for (int j = 0; j < 4; j++) {
-            auto face_t = tuple_from_face(i, j);
-            if (face_t.fid(*this) == 4 * i + j) faces.emplace_back(face_t);
-        }
-    }
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
+    arena.execute([&] {
+        faces = collect_in_order<Tuple>(tet_capacity(), [&](size_t i, std::vector<Tuple>& out) {
+            if (m_tet_connectivity[i].m_is_removed) return;
+            for (int j = 0; j < 4; j++) {
+                auto face_t = tuple_from_face(i, j);
+                if (face_t.fid(*this) == 4 * i + j) out.emplace_back(face_t);
+            }
+        });
+    });
 
     return faces;
 }
@@ -191,7 +225,11 @@ bool wmtk::TetMesh::check_mesh_connectivity_validity() const
     for (size_t i = 0; i < vert_capacity(); i++) {
         if (m_vertex_connectivity[i].m_is_removed) continue;
         assert(!m_vertex_connectivity[i].m_conn_tets.empty());
-        assert(m_vertex_connectivity[i].m_conn_tets == conn_tets[i]);
+        assert(std::equal(
+            m_vertex_connectivity[i].m_conn_tets.begin(),
+            m_vertex_connectivity[i].m_conn_tets.end(),
+            conn_tets[i].begin(),
+            conn_tets[i].end()));
     }
 
     // check is_removed
@@ -208,6 +246,15 @@ bool wmtk::TetMesh::check_mesh_connectivity_validity() const
             assert(!m_tet_connectivity[tid].m_is_removed && "m_tet_connectivity[tid].m_is_removed");
     }
 
+    // check the live counts
+    size_t n_vertices = 0, n_tets = 0;
+    for (size_t i = 0; i < vert_capacity(); i++)
+        if (!m_vertex_connectivity[i].m_is_removed) n_vertices++;
+    for (size_t i = 0; i < tet_capacity(); i++)
+        if (!m_tet_connectivity[i].m_is_removed) n_tets++;
+    assert(n_vertices == vertex_size() && "vertex_size() is out of date");
+    assert(n_tets == tet_size() && "tet_size() is out of date");
+
     // check tuple
     for (size_t i = 0; i < vert_capacity(); i++) {
         if (m_vertex_connectivity[i].m_is_removed) continue;
@@ -242,6 +289,8 @@ bool wmtk::TetMesh::check_mesh_connectivity_validity() const
         }
     }
 
+    assert(check_adjacency_cache_validity());
+
     return true;
 }
 
@@ -249,14 +298,17 @@ bool wmtk::TetMesh::check_mesh_connectivity_validity() const
 std::vector<wmtk::TetMesh::Tuple> wmtk::TetMesh::get_tets() const
 {
     std::vector<TetMesh::Tuple> tets;
-    for (auto i = 0; i < tet_capacity(); i++) {
-        auto& t = m_tet_connectivity[i];
-        if (t.m_is_removed) continue;
-        tets.emplace_back(tuple_from_tet(i));
-
-        assert(tets.back().tid(*this) == i);
-        assert(tets.back().is_valid(*this));
-    }
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
+    arena.execute([&] {
+        tets = collect_in_order<Tuple>(tet_capacity(), [&](size_t i, std::vector<Tuple>& out) {
+            auto& t = m_tet_connectivity[i];
+            if (t.m_is_removed) return;
+            out.emplace_back(tuple_from_tet(i));
+
+            assert(out.back().tid(*this) == i);
+            assert(out.back().is_valid(*this));
+        });
+    });
     return tets;
 }
 
@@ -264,24 +316,32 @@ std::vector<wmtk::TetMesh::Tuple> wmtk::TetMesh::get_tets() const
 std::vector<wmtk::TetMesh::Tuple> wmtk::TetMesh::get_vertices() const
 {
     std::vector<TetMesh::Tuple> verts;
-    for (auto i = 0; i < vert_capacity(); i++) {
-        auto& vc = m_vertex_connectivity[i];
-        if (vc.m_is_removed) continue;
-        assert(!vc.m_conn_tets.empty());
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
+    arena.execute([&] {
+        verts = collect_in_order<Tuple>(vert_capacity(), [&](size_t i, std::vector<Tuple>& out) {
+            auto& vc = m_vertex_connectivity[i];
+            if (vc.m_is_removed) return;
+            assert(!vc.m_conn_tets.empty());
 
-        verts.emplace_back(tuple_from_vertex(i));
+            out.emplace_back(tuple_from_vertex(i));
 
-        assert(verts.back().vid(*this) == i);
-        assert(verts.back().is_valid(*this));
-    }
+            assert(out.back().vid(*this) == i);
+            assert(out.back().is_valid(*this));
+        });
+    });
     return verts;
 }
 
 bool wmtk::TetMesh::smooth_vertex(const Tuple& loc0)
 {
+    auto phase_timer = OperationPhaseTimer(OperationPhase::kBefore);
     if (!smooth_before(loc0)) return false;
     start_protect_attributes();
-    if (!smooth_after(loc0) || !invariants(get_one_ring_tets_for_vertex(loc0))) {
+    phase_timer.start(OperationPhase::kAfter);
+    auto after_success = smooth_after(loc0);
+    phase_timer.start(OperationPhase::kInvariants);
+    if (!after_success || !invariants(get_one_ring_tets_for_vertex(loc0))) {
+        phase_timer.start(OperationPhase::kRollback);
         rollback_protected_attributes();
         return false;
     }
@@ -326,18 +386,20 @@ wmtk::TetMesh::Tuple wmtk::TetMesh::tuple_from_face(size_t tid, int local_fid) c
 std::tuple<wmtk::TetMesh::Tuple, size_t> wmtk::TetMesh::tuple_from_face(
     const std::array<size_t, 3>& vids) const
 {
-    auto tmp = set_intersection(
-        m_vertex_connectivity[vids[0]].m_conn_tets,
-        m_vertex_connectivity[vids[1]].m_conn_tets);
-    auto n12_t_ids = set_intersection(tmp, m_vertex_connectivity[vids[2]].m_conn_tets);
-    if (n12_t_ids.size() == 0 || n12_t_ids.size() > 2) {
+    // the tets of the face are the first tets of the edge that contain the third vertex
+    size_t n12_size = 0;
+    size_t n12_first_tid = -1;
+    for_each_incident_tid_of_edge(vids[0], vids[1], [&](size_t tid) {
+        if (m_tet_connectivity[tid].find(vids[2]) == -1) return;
+        if (n12_size++ == 0) n12_first_tid = tid;
+    });
+    if (n12_size == 0 || n12_size > 2) {
         return {Tuple(), -1};
     }
 
-    // tid
+    // tid, the smallest as the tids are sorted
     Tuple face;
-    face.m_global_tid = n12_t_ids[0];
-    if (n12_t_ids.size() > 1 && n12_t_ids[1] < n12_t_ids[0]) face.m_global_tid = n12_t_ids[1];
+    face.m_global_tid = n12_first_tid;
     // fid
     std::array<int, 3> f;
     for (int j = 0; j < 3; j++) {
@@ -368,12 +430,11 @@ std::tuple<wmtk::TetMesh::Tuple, size_t> wmtk::TetMesh::tuple_from_face(
 
 wmtk::TetMesh::Tuple wmtk::TetMesh::tuple_from_edge(const std::array<size_t, 2>& vids) const
 {
-    auto tets = set_intersection(
-        m_vertex_connectivity[vids[0]].m_conn_tets,
-        m_vertex_connectivity[vids[1]].m_conn_tets);
-    if (tets.empty()) return Tuple();
+    const auto& n1_t_ids = m_vertex_connectivity[vids[0]].m_conn_tets;
+    auto it = set_intersection_first(n1_t_ids, m_vertex_connectivity[vids[1]].m_conn_tets);
+    if (it == n1_t_ids.end()) return Tuple();
+    size_t tid = *it;
 
-    auto tid = tets.front();
     auto local_ind = m_tet_connectivity[tid].m_indices;
 
     for (auto local_eid = 0; local_eid < 6; local_eid++) {
@@ -471,11 +532,8 @@ std::vector<size_t> wmtk::TetMesh::get_one_ring_tids_for_vertex(const Tuple& t)
 std::vector<wmtk::TetMesh::Tuple> wmtk::TetMesh::get_one_ring_tets_for_vertex(const Tuple& t) const
 {
     std::vector<Tuple> tets;
-    auto& tids = m_vertex_connectivity[t.m_global_vid].m_conn_tets;
-    tets.reserve(tids.size());
-    for (auto t_id : tids) {
-        tets.emplace_back(tuple_from_tet(t_id));
-    }
+    tets.reserve(m_vertex_connectivity[t.m_global_vid].m_conn_tets.size());
+    for_each_tet_around_vertex(t, [&](const Tuple& tet) { tets.push_back(tet); });
     return tets;
 }
 
@@ -554,104 +612,152 @@ std::vector<size_t> wmtk::TetMesh::get_one_ring_vids_for_vertex_adj(
     return cache;
 }
 
+std::array<size_t, 2> wmtk::TetMesh::edge_vids(const Tuple& t) const
+{
+    const auto& tet = m_tet_connectivity[t.m_global_tid];
+    const auto& e = utils::tet_element_topology::local_edges[t.m_local_eid];
+    return {{tet[e[0]], tet[e[1]]}};
+}
+
 std::vector<wmtk::TetMesh::Tuple> wmtk::TetMesh::get_incident_tets_for_edge(const Tuple& t) const
 {
-    int v1_id = m_tet_connectivity[t.m_global_tid]
-                                  [utils::tet_element_topology::local_edges[t.m_local_eid][0]];
-    int v2_id = m_tet_connectivity[t.m_global_tid]
-                                  [utils::tet_element_topology::local_edges[t.m_local_eid][1]];
-
-    auto tids = set_intersection(
-        m_vertex_connectivity[v1_id].m_conn_tets,
-        m_vertex_connectivity[v2_id].m_conn_tets);
     std::vector<Tuple> tets;
-    for (int t_id : tids) {
-        tets.push_back(tuple_from_tet(t_id));
-    }
+    for_each_tet_around_edge(t, [&](const Tuple& tet) { tets.push_back(tet); });
     return tets;
 }
 
 std::vector<wmtk::TetMesh::Tuple> wmtk::TetMesh::get_one_ring_tets_for_edge(const Tuple& t) const
 {
-    int v1_id = m_tet_connectivity[t.m_global_tid]
-                                  [utils::tet_element_topology::local_edges[t.m_local_eid][0]];
-    int v2_id = m_tet_connectivity[t.m_global_tid]
-                                  [utils::tet_element_topology::local_edges[t.m_local_eid][1]];
-
-    auto tids = m_vertex_connectivity[v1_id].m_conn_tets;
-    tids.insert(
-        tids.end(),
-        m_vertex_connectivity[v2_id].m_conn_tets.begin(),
-        m_vertex_connectivity[v2_id].m_conn_tets.end());
-    vector_unique(tids);
-
     std::vector<Tuple> tets;
-    for (int t_id : tids) {
-        tets.emplace_back(tuple_from_tet(t_id));
-    }
+    for_each_tet_in_edge_one_ring(t, [&](const Tuple& tet) { tets.push_back(tet); });
     return tets;
 }
 
+const std::vector<wmtk::TetMesh::Tuple>& wmtk::TetMesh::get_one_ring_tets_for_vertex_scratch(
+    const Tuple& t) const
+{
+    auto& tets = m_vertex_one_ring_scratch.local();
+    tets.clear();
+    for_each_tet_around_vertex(t, [&](const Tuple& tet) { tets.push_back(tet); });
+    return tets;
+}
 
-void wmtk::TetMesh::consolidate_mesh()
+const std::vector<wmtk::TetMesh::Tuple>& wmtk::TetMesh::get_incident_tets_for_edge_scratch(
+    const Tuple& t) const
 {
-    auto v_cnt = 0;
-    std::vector<size_t> map_v_ids(vert_capacity(), -1);
-    for (auto i = 0; i < vert_capacity(); i++) {
-        if (m_vertex_connectivity[i].m_is_removed) continue;
-        map_v_ids[i] = v_cnt;
-        v_cnt++;
-    }
-    auto t_cnt = 0;
-    std::vector<size_t> map_t_ids(tet_capacity(), -1);
-    for (auto i = 0; i < tet_capacity(); i++) {
-        if (m_tet_connectivity[i].m_is_removed) continue;
-        map_t_ids[i] = t_cnt;
-        t_cnt++;
-    }
+    auto& tets = m_edge_incident_tets_scratch.local();
+    tets.clear();
+    for_each_tet_around_edge(t, [&](const Tuple& tet) { tets.push_back(tet); });
+    return tets;
+}
 
-    v_cnt = 0;
-    for (auto i = 0; i < vert_capacity(); i++) {
-        if (m_vertex_connectivity[i].m_is_removed) continue;
-        if (v_cnt != i) {
-            assert(v_cnt < i);
-            m_vertex_connectivity[v_cnt] = m_vertex_connectivity[i];
-            if (p_vertex_attrs != nullptr) {
-                p_vertex_attrs->move(i, v_cnt);
-            }
-        }
-        for (size_t& t_id : m_vertex_connectivity[v_cnt].m_conn_tets) t_id = map_t_ids[t_id];
-        v_cnt++;
-    }
-    t_cnt = 0;
-    for (int i = 0; i < tet_capacity(); i++) {
-        if (m_tet_connectivity[i].m_is_removed) continue;
 
-        if (t_cnt != i) {
-            assert(t_cnt < i);
-            m_tet_connectivity[t_cnt] = m_tet_connectivity[i];
-            m_tet_connectivity[t_cnt].hash = 0;
-            if (p_tet_attrs != nullptr) {
-                p_tet_attrs->move(i, t_cnt);
-            }
+void wmtk::TetMesh::consolidate_mesh()
+{
+    ZoneScoped;
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
+    arena.execute([&] {
+        std::vector<size_t> map_v_ids, map_t_ids;
+        const auto new2old_v = compact_ids(
+            vert_capacity(),
+            [&](size_t i) { return !m_vertex_connectivity[i].m_is_removed; },
+            map_v_ids);
+        const auto new2old_t = compact_ids(
+            tet_capacity(),
+            [&](size_t i) { return !m_tet_connectivity[i].m_is_removed; },
+            map_t_ids);
+        renumber_mesh(new2old_v, map_v_ids, new2old_t, map_t_ids);
+    });
+}
 
-            if (p_face_attrs != nullptr) {
-                for (auto j = 0; j < 4; j++) {
-                    p_face_attrs->move(i * 4 + j, t_cnt * 4 + j);
+void wmtk::TetMesh::consolidate_mesh(
+    const std::function<Eigen::Vector3d(size_t)>& vertex_position)
+{
+    ZoneScoped;
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
+    arena.execute([&] {
+        std::vector<size_t> map_v_ids, map_t_ids;
+        auto new2old_v = compact_ids(
+            vert_capacity(),
+            [&](size_t i) { return !m_vertex_connectivity[i].m_is_removed; },
+            map_v_ids);
+        sort_vertices_morton(new2old_v, vertex_position);
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, new2old_v.size()),
+            [&](tbb::blocked_range<size_t> r) {
+                for (auto i = r.begin(); i < r.end(); i++) map_v_ids[new2old_v[i]] = i;
+            });
+
+        // the tets are sorted by their smallest new vid, then by their old tid
+        auto new2old_t = compact_ids(
+            tet_capacity(),
+            [&](size_t i) { return !m_tet_connectivity[i].m_is_removed; },
+            map_t_ids);
+        auto keys = std::vector<std::pair<size_t, size_t>>(new2old_t.size());
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, new2old_t.size()),
+            [&](tbb::blocked_range<size_t> r) {
+                for (auto i = r.begin(); i < r.end(); i++) {
+                    auto& tet = m_tet_connectivity[new2old_t[i]];
+                    keys[i] = {map_v_ids[tet[0]], new2old_t[i]};
+                    for (auto j = 1; j < 4; j++)
+                        keys[i].first = std::min(keys[i].first, map_v_ids[tet[j]]);
                 }
-            }
-            if (p_edge_attrs != nullptr) {
-                for (auto j = 0; j < 6; j++) {
-                    p_edge_attrs->move(i * 6 + j, t_cnt * 6 + j);
+            });
+        tbb::parallel_sort(keys.begin(), keys.end());
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, keys.size()),
+            [&](tbb::blocked_range<size_t> r) {
+                for (auto i = r.begin(); i < r.end(); i++) {
+                    new2old_t[i] = keys[i].second;
+                    map_t_ids[new2old_t[i]] = i;
                 }
+            });
+
+        renumber_mesh(new2old_v, map_v_ids, new2old_t, map_t_ids);
+    });
+}
+
+void wmtk::TetMesh::renumber_mesh(
+    const std::vector<size_t>& new2old_v,
+    const std::vector<size_t>& map_v_ids,
+    const std::vector<size_t>& new2old_t,
+    const std::vector<size_t>& map_t_ids)
+{
+    const size_t v_cnt = new2old_v.size();
+    const size_t t_cnt = new2old_t.size();
+
+    compact_in_place(m_vertex_connectivity, new2old_v);
+    compact_in_place(m_tet_connectivity, new2old_t);
+    if (p_vertex_attrs != nullptr) p_vertex_attrs->consolidate(new2old_v, 1);
+    if (p_tet_attrs != nullptr) p_tet_attrs->consolidate(new2old_t, 1);
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, v_cnt),
+        [&](tbb::blocked_range<size_t> r) {
+            for (auto i = r.begin(); i < r.end(); i++) {
+                auto& conn_tets = m_vertex_connectivity[i].m_conn_tets;
+                for (size_t& t_id : conn_tets) t_id = map_t_ids[t_id];
+                // the reordering does not keep the tids sorted
+                std::sort(conn_tets.begin(), conn_tets.end());
             }
-        }
-        for (size_t& v_id : m_tet_connectivity[t_cnt].m_indices) v_id = map_v_ids[v_id];
-        t_cnt++;
-    }
+        });
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, t_cnt),
+        [&](tbb::blocked_range<size_t> r) {
+            for (auto i = r.begin(); i < r.end(); i++) {
+                auto& tet = m_tet_connectivity[i];
+                if (new2old_t[i] != i) tet.hash = 0;
+                for (auto& v_id : tet.m_indices) v_id = map_v_ids[v_id];
+            }
+        });
 
     current_vert_size = v_cnt;
     current_tet_size = t_cnt;
+    m_vertex_count.reset(v_cnt);
+    m_tet_count.reset(t_cnt);
+    m_free_vertices.clear();
+    m_free_tets.clear();
 
     m_vertex_connectivity.resize(v_cnt);
     m_tet_connectivity.resize(t_cnt);
@@ -670,6 +776,40 @@ void wmtk::TetMesh::consolidate_mesh()
         p_tet_attrs->grow_to_at_least(t_cnt);
     }
 
+    if (m_use_adjacency_cache) build_adjacency_cache(m_tet_adjacency);
+
+    // a shared face or edge lives in the slot of its incident tet of smallest tid, so the blocks of
+    // the tets only keep it in place when the tets keep their order
+    if (std::is_sorted(new2old_t.begin(), new2old_t.end())) {
+        if (p_face_attrs != nullptr) p_face_attrs->consolidate(new2old_t, 4);
+        if (p_edge_attrs != nullptr) p_edge_attrs->consolidate(new2old_t, 6);
+    } else {
+        if (p_face_attrs != nullptr) {
+            const auto new2old_f =
+                shared_slots_new2old(new2old_t, 4, [&](size_t i, int j) -> std::optional<size_t> {
+                    const auto t = tuple_from_face(i, j);
+                    const auto t_opp = switch_tetrahedron(t);
+                    if (t_opp && new2old_t[t_opp->tid(*this)] < new2old_t[i]) return {};
+                    return t.fid(*this);
+                });
+            p_face_attrs->consolidate(new2old_f, 1);
+        }
+        if (p_edge_attrs != nullptr) {
+            const auto new2old_e =
+                shared_slots_new2old(new2old_t, 6, [&](size_t i, int j) -> std::optional<size_t> {
+                    const auto t = tuple_from_edge(i, j);
+                    auto [v1_id, v2_id] = edge_vids(t);
+                    bool is_owned = true;
+                    for_each_incident_tid_of_edge(v1_id, v2_id, [&](size_t tid) {
+                        if (new2old_t[tid] < new2old_t[i]) is_owned = false;
+                    });
+                    if (!is_owned) return {};
+                    return t.eid(*this);
+                });
+            p_edge_attrs->consolidate(new2old_e, 1);
+        }
+    }
+
     assert(check_mesh_connectivity_validity());
 }
 
@@ -1055,7 +1195,7 @@ bool wmtk::TetMesh::try_set_vertex_mutex_one_ring(const Tuple& v, int threadid)
 
 void wmtk::TetMesh::for_each_edge(const std::function<void(const TetMesh::Tuple&)>& func)
 {
-    tbb::task_arena arena(NUM_THREADS);
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
     arena.execute([&] {
         tbb::parallel_for(
             tbb::blocked_range<int>(0, tet_capacity()),
@@ -1076,7 +1216,7 @@ void wmtk::TetMesh::for_each_edge(const std::function<void(const TetMesh::Tuple&
 
 void wmtk::TetMesh::for_each_tetra(const std::function<void(const TetMesh::Tuple&)>& func)
 {
-    tbb::task_arena arena(NUM_THREADS);
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
     arena.execute([&] {
         tbb::parallel_for(
             tbb::blocked_range<int>(0, tet_capacity()),
@@ -1093,7 +1233,7 @@ void wmtk::TetMesh::for_each_tetra(const std::function<void(const TetMesh::Tuple
 
 void wmtk::TetMesh::for_each_vertex(const std::function<void(const TetMesh::Tuple&)>& func)
 {
-    tbb::task_arena arena(NUM_THREADS);
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
     arena.execute([&] {
         tbb::parallel_for(
             tbb::blocked_range<int>(0, vert_capacity()),
@@ -1,14 +1,22 @@
 #pragma once
 
+#include <wmtk/ExecutionContext.hpp>
 #include <wmtk/TetMeshTuple.h>
+#include <wmtk/utils/ConnectivityIndex.hpp>
+#include <wmtk/utils/ElementCounter.hpp>
+#include <wmtk/utils/ParallelCollect.hpp>
+#include <wmtk/utils/SlotFreeList.hpp>
+#include <wmtk/utils/SmallVector.hpp>
 #include <wmtk/utils/VectorUtils.h>
 #include <type_traits>
 #include <wmtk/AttributeCollection.hpp>
 #include <wmtk/utils/Logger.hpp>
 
+#include <Eigen/Core>
 #include <tbb/concurrent_vector.h>
 #include <tbb/enumerable_thread_specific.h>
 #include <tbb/spin_mutex.h>
+#include <tbb/task_arena.h>
 
 #include <Tracy.hpp>
 
@@ -27,14 +35,18 @@ public:
     using Tuple = TetMeshTuple;
     friend class TetMeshTuple;
     /**
-     * (internal use) Maintains a list of tetra connected to the given vertex, and a flag to
-     * mark removal.
+     * (internal use) Maintains a sorted list of tetra connected to the given vertex, and a flag
+     * to mark removal.
      *
      */
     class VertexConnectivity
     {
     public:
-        std::vector<size_t> m_conn_tets; // todo: always keep it sorted
+        /**
+         * @brief most vertices are in fewer tets than the inline capacity, and never allocate
+         */
+        using TetList = SmallVector<size_t, 32>;
+        TetList m_conn_tets; // sorted, so that the one-rings are intersected by merging
         bool m_is_removed = false;
 
         size_t& operator[](const size_t index)
@@ -65,12 +77,12 @@ public:
     class TetrahedronConnectivity
     {
     public:
-        std::array<size_t, 4> m_indices;
+        std::array<ConnectivityIndex, 4> m_indices;
         bool m_is_removed = false;
 
         int hash = 0;
 
-        size_t& operator[](size_t index)
+        ConnectivityIndex& operator[](size_t index)
         {
             assert(index < 4);
             return m_indices[index];
@@ -94,6 +106,15 @@ public:
 
         int find_local_face(size_t v1_id, size_t v2_id, size_t v3_id) const;
 
+        /**
+         * @brief the vids of the tet, independently of the ConnectivityIndex they are stored as
+         */
+        std::array<size_t, 4> vids() const { return convert_indices<size_t>(m_indices); }
+        void set_vids(const std::array<size_t, 4>& vids)
+        {
+            m_indices = convert_indices<ConnectivityIndex>(vids);
+        }
+
         friend bool operator==(const TetrahedronConnectivity& l, const TetrahedronConnectivity& r)
         {
             return std::tie(l.m_indices, l.m_is_removed, l.hash) ==
@@ -103,6 +124,18 @@ public:
         void print_info() {}
     };
 
+    /**
+     * (internal use) Caches the neighbors and the global edge and face ids of a given tetra, see
+     * TetMesh::enable_adjacency_cache.
+     *
+     */
+    struct TetAdjacency
+    {
+        std::array<size_t, 4> tets; // the tet across each local face, -1 on the boundary
+        std::array<size_t, 4> faces; // global fid of each local face
+        std::array<size_t, 6> edges; // global eid of each local edge
+    };
+
     TetMesh();
     virtual ~TetMesh() = default;
     /**
@@ -119,29 +152,15 @@ public:
     size_t tet_capacity() const { return current_tet_size; }
 
     /**
-     * @brief get the number of unremoved verticies
+     * @brief get the number of unremoved verticies, in constant time
      *
      */
-    size_t vertex_size() const
-    {
-        int cnt = 0;
-        for (size_t i = 0; i < vert_capacity(); i++) {
-            if (!m_vertex_connectivity[i].m_is_removed) cnt++;
-        }
-        return cnt;
-    }
+    size_t vertex_size() const { return m_vertex_count.get(); }
     /**
-     * @brief get the number of unremoved tets
+     * @brief get the number of unremoved tets, in constant time
      *
      */
-    size_t tet_size() const
-    {
-        int cnt = 0;
-        for (size_t i = 0; i < tet_capacity(); i++) {
-            if (!m_tet_connectivity[i].m_is_removed) cnt++;
-        }
-        return cnt;
-    }
+    size_t tet_size() const { return m_tet_count.get(); }
     /**
      * Initialize TetMesh data structure
      *
@@ -244,6 +263,31 @@ public:
      *
      */
     void consolidate_mesh();
+    /**
+     * @brief consolidate_mesh, that also renumbers the vertices along the Morton order of their
+     * positions, and the tets along the order of their first vertex, so that the elements close
+     * in space are close in memory. WARNING: it invalidates all tuples!
+     *
+     * @param vertex_position the position of a vertex, given its id before the consolidation
+     */
+    void consolidate_mesh(const std::function<Eigen::Vector3d(size_t)>& vertex_position);
+
+    /**
+     * @brief Keeps a tet-tet adjacency and the global edge and face ids of every tet up to date
+     * with the connectivity, so that Tuple::eid, Tuple::fid and Tuple::switch_tetrahedron do not
+     * intersect the one-ring tets of the vertices anymore. The operations update the cache of the
+     * tets around the edges and faces they change.
+     *
+     * @param enable builds the cache if true, frees it otherwise
+     * @note not thread-safe, call it outside of ExecutePass
+     */
+    void enable_adjacency_cache(bool enable = true);
+    bool has_adjacency_cache() const { return m_use_adjacency_cache; }
+    /**
+     * @brief checks the adjacency cache against the connectivity, always true without the cache
+     *
+     */
+    bool check_adjacency_cache_validity() const;
 
     /**
      * Get all unique undirected edges in the mesh.
@@ -308,16 +352,49 @@ private:
     vector<TetrahedronConnectivity> m_tet_connectivity;
     std::atomic_long current_vert_size;
     std::atomic_long current_tet_size;
+    // the number of slots below the capacities that are not removed
+    ElementCounter m_vertex_count;
+    ElementCounter m_tet_count;
+    // the removed slots below the capacities, reused by get_next_empty_slot_v/t before growing,
+    // and the slabs of new slots of each thread
+    SlotFreeList m_free_vertices;
+    SlotFreeList m_free_tets;
+    // guard the reservation of the slabs, and the growth of the mesh
     tbb::spin_mutex vertex_connectivity_lock;
     tbb::spin_mutex tet_connectivity_lock;
-    bool vertex_connectivity_synchronizing_flag = false;
-    bool tet_connectivity_synchronizing_flag = false;
-    int MAX_THREADS = 128;
+
+    vector<TetAdjacency> m_tet_adjacency;
+    bool m_use_adjacency_cache = false;
+
+    /**
+     * (internal use) The edges and faces of the tets replaced by an operation, as sorted vids.
+     *
+     */
+    struct AdjacencyCacheUpdate
+    {
+        std::vector<std::array<size_t, 2>> edges;
+        std::vector<std::array<size_t, 3>> faces;
+
+        void add_tet(const std::array<size_t, 4>& tet);
+    };
+    void build_adjacency_cache(vector<TetAdjacency>& adjacency) const;
+    void update_adjacency_cache(AdjacencyCacheUpdate& update);
+
+    // moves the vertex new2old_v[i] to i and the tet new2old_t[i] to i, with the inverse maps
+    void renumber_mesh(
+        const std::vector<size_t>& new2old_v,
+        const std::vector<size_t>& map_v_ids,
+        const std::vector<size_t>& new2old_t,
+        const std::vector<size_t>& map_t_ids);
 
     int m_t_empty_slot = 0;
     int m_v_empty_slot = 0;
     int get_next_empty_slot_t();
     int get_next_empty_slot_v();
+    // reserve the next slab of new slots for the calling thread, growing the mesh and the
+    // attributes if needed
+    void reserve_tet_slab();
+    void reserve_vertex_slab();
 
     // TODO: subdivide_tets function should not be in the TetMesh API.
     void subdivide_tets(
@@ -556,6 +633,30 @@ public:
      * @return std::vector<size_t> a vector of vids
      */
     std::vector<size_t> get_one_ring_tids_for_vertex(const Tuple& t) const;
+    /**
+     * @brief the sorted tids of the one ring of a vertex, without any copy
+     *
+     * @param vid size_t type vertex id
+     * @note the list is invalidated by the next operation on the vertex
+     */
+    const VertexConnectivity::TetList& one_ring_tids(size_t vid) const
+    {
+        return m_vertex_connectivity[vid].m_conn_tets;
+    }
+    /**
+     * @brief visit the sorted tids incident to the edge (v1_id, v2_id), by merging the one rings
+     * of its vertices without any allocation
+     *
+     * @param visit called with the size_t tid of each tet
+     */
+    template <typename Visitor>
+    void for_each_incident_tid_of_edge(size_t v1_id, size_t v2_id, Visitor&& visit) const
+    {
+        set_intersection_for_each(
+            m_vertex_connectivity[v1_id].m_conn_tets,
+            m_vertex_connectivity[v2_id].m_conn_tets,
+            visit);
+    }
 
     /**
      * @brief Get the one ring vertices for a vertex
@@ -606,6 +707,90 @@ public:
      */
     std::vector<Tuple> get_one_ring_tets_for_edge(const Tuple& t) const;
 
+    /**
+     * @brief visit the one ring tets of a vertex, without any allocation
+     *
+     * @param t tuple pointing to a vertex
+     * @param visit called with the Tuple of each tet, in increasing tid. It must not change the
+     * connectivity.
+     */
+    template <typename Visitor>
+    void for_each_tet_around_vertex(const Tuple& t, Visitor&& visit) const
+    {
+        for (size_t tid : m_vertex_connectivity[t.m_global_vid].m_conn_tets) {
+            visit(tuple_from_tet(tid));
+        }
+    }
+    /**
+     * @brief visit the tets incident to an edge, without any allocation
+     *
+     * @param t tuple pointing to an edge
+     * @param visit called with the Tuple of each tet, in increasing tid. It must not change the
+     * connectivity.
+     */
+    template <typename Visitor>
+    void for_each_tet_around_edge(const Tuple& t, Visitor&& visit) const
+    {
+        auto [v1_id, v2_id] = edge_vids(t);
+        for_each_incident_tid_of_edge(v1_id, v2_id, [&](size_t tid) {
+            visit(tuple_from_tet(tid));
+        });
+    }
+    /**
+     * @brief visit the one ring tets of an edge, i.e. the tets of either of its vertices, by
+     * merging their sorted one rings without any allocation
+     *
+     * @param t tuple pointing to an edge
+     * @param visit called with the Tuple of each tet, in increasing tid. It must not change the
+     * connectivity.
+     */
+    template <typename Visitor>
+    void for_each_tet_in_edge_one_ring(const Tuple& t, Visitor&& visit) const
+    {
+        auto [v1_id, v2_id] = edge_vids(t);
+        const auto& tids1 = m_vertex_connectivity[v1_id].m_conn_tets;
+        const auto& tids2 = m_vertex_connectivity[v2_id].m_conn_tets;
+        auto i1 = tids1.begin(), i2 = tids2.begin();
+        while (i1 != tids1.end() || i2 != tids2.end()) {
+            size_t tid;
+            if (i2 == tids2.end() || (i1 != tids1.end() && *i1 < *i2))
+                tid = *i1++;
+            else if (i1 == tids1.end() || *i2 < *i1)
+                tid = *i2++;
+            else {
+                tid = *i1++;
+                i2++;
+            }
+            visit(tuple_from_tet(tid));
+        }
+    }
+    /**
+     * @brief visit the 6 edges of a tet, like tet_edges but without building the array
+     *
+     * @param t tuple pointing to a tet
+     * @param visit called with the Tuple of each edge, in the order of their local eids
+     */
+    template <typename Visitor>
+    void for_each_edge_of_tet(const Tuple& t, Visitor&& visit) const
+    {
+        for (int j = 0; j < 6; j++) visit(tuple_from_edge(t.m_global_tid, j));
+    }
+
+    /**
+     * @brief Get the one ring tets for a vertex, in a buffer of the calling thread
+     *
+     * @param t tuple pointing to a vertex
+     * @return one-ring, valid until the next call of this function by the same thread
+     */
+    const std::vector<Tuple>& get_one_ring_tets_for_vertex_scratch(const Tuple& t) const;
+    /**
+     * @brief Get the incident tets for edge, in a buffer of the calling thread
+     *
+     * @param t tuple pointing to an edge
+     * @return incident tets, valid until the next call of this function by the same thread
+     */
+    const std::vector<Tuple>& get_incident_tets_for_edge_scratch(const Tuple& t) const;
+
     /**
      * @brief
      *
@@ -656,15 +841,27 @@ public:
      */
     void remove_tets_by_ids(const std::vector<size_t>& tids)
     {
+        auto update = AdjacencyCacheUpdate();
         for (size_t tid : tids) {
+            if (m_tet_connectivity[tid].m_is_removed) continue;
+            if (m_use_adjacency_cache) update.add_tet(m_tet_connectivity[tid].vids());
             m_tet_connectivity[tid].m_is_removed = true;
+            m_tet_count.add(-1);
+            m_free_tets.release(tid);
             for (int j = 0; j < 4; j++)
-                vector_erase(m_vertex_connectivity[m_tet_connectivity[tid][j]].m_conn_tets, tid);
+                set_erase(m_vertex_connectivity[m_tet_connectivity[tid][j]].m_conn_tets, tid);
         }
-        for (auto& v : m_vertex_connectivity) {
+        // the slots past the capacity are not vertices yet, and must stay free
+        for (size_t i = 0; i < vert_capacity(); i++) {
+            auto& v = m_vertex_connectivity[i];
             if (v.m_is_removed) continue;
-            if (v.m_conn_tets.empty()) v.m_is_removed = true;
+            if (v.m_conn_tets.empty()) {
+                v.m_is_removed = true;
+                m_vertex_count.add(-1);
+                m_free_vertices.release(i);
+            }
         }
+        if (m_use_adjacency_cache) update_adjacency_cache(update);
     }
     bool m_collapse_check_link_condition = true;
 
@@ -707,6 +904,9 @@ private:
 
     void release_protect_attributes()
     {
+        // the operation succeeded, so the slots it removed can be reused
+        m_free_vertices.commit();
+        m_free_tets.commit();
         if (p_vertex_attrs != nullptr) {
             p_vertex_attrs->end_protect();
         }
@@ -779,7 +979,13 @@ public:
         if (!op.after(new_tet_tuples) || !invariants(new_tet_tuples)) { // rollback post-operation
 
             logger().trace("rolling back");
+            for (auto v : new_vids) {
+                m_vertex_connectivity[v].m_is_removed = true;
+                m_vertex_connectivity[v].m_conn_tets.clear();
+            }
+            m_vertex_count.add(-long(new_vnum));
             operation_failure_rollback_imp(rollback_vert_conn, affected, new_tet_id, old_tets);
+            for (auto v : new_vids) m_free_vertices.release(v);
             return false;
         }
         release_protect_attributes();
@@ -835,6 +1041,15 @@ public:
     tbb::enumerable_thread_specific<std::vector<size_t>> mutex_release_stack;
     tbb::enumerable_thread_specific<std::vector<size_t>> get_one_ring_cache;
 
+private:
+    // the vids of the edge of a tuple
+    std::array<size_t, 2> edge_vids(const Tuple& t) const;
+    // the buffers of the *_scratch queries, one per query so that they can be nested
+    mutable tbb::enumerable_thread_specific<std::vector<Tuple>> m_vertex_one_ring_scratch;
+    mutable tbb::enumerable_thread_specific<std::vector<Tuple>> m_edge_incident_tets_scratch;
+
+public:
+
     // void init(size_t n_vertices, const std::vector<std::array<size_t, 4>>& tets);
     int release_vertex_mutex_in_stack();
 
@@ -935,7 +1150,60 @@ public:
      *
      */
     void for_each_tetra(const std::function<void(const TetMesh::Tuple&)>&);
+
+    /**
+     * @brief reduce a value over the tets in parallel, without any shared state
+     *
+     * @param identity the initial value of each accumulator
+     * @param accumulate called as accumulate(T& acc, const Tuple& t) to fold each tet into the
+     * accumulator of its range of tets
+     * @param combine called as combine(const T& a, const T& b) to join two accumulators
+     * @return the reduced value, the same for any number of threads
+     */
+    template <typename T, typename Accumulate, typename Combine>
+    T reduce_tetra(const T& identity, Accumulate&& accumulate, Combine&& combine) const
+    {
+        return reduce_ids(tet_capacity(), identity, combine, [&](T& acc, size_t i) {
+            auto tup = tuple_from_tet(i);
+            if (tup.is_valid(*this)) accumulate(acc, tup);
+        });
+    }
+    /**
+     * @brief reduce a value over the vertices in parallel, see reduce_tetra
+     */
+    template <typename T, typename Accumulate, typename Combine>
+    T reduce_vertex(const T& identity, Accumulate&& accumulate, Combine&& combine) const
+    {
+        return reduce_ids(vert_capacity(), identity, combine, [&](T& acc, size_t i) {
+            auto tup = tuple_from_vertex(i);
+            if (tup.is_valid(*this)) accumulate(acc, tup);
+        });
+    }
+    /**
+     * @brief reduce a value over the edges in parallel, each edge being visited once by the tet
+     * that owns it, see reduce_tetra
+     */
+    template <typename T, typename Accumulate, typename Combine>
+    T reduce_edge(const T& identity, Accumulate&& accumulate, Combine&& combine) const
+    {
+        return reduce_ids(tet_capacity(), identity, combine, [&](T& acc, size_t i) {
+            if (!tuple_from_tet(i).is_valid(*this)) return;
+            for (int j = 0; j < 6; j++) {
+                auto tup = tuple_from_edge(i, j);
+                if (tup.eid(*this) == 6 * i + j) accumulate(acc, tup);
+            }
+        });
+    }
     int NUM_THREADS = 1;
+
+private:
+    template <typename T, typename Combine, typename AccumulateId>
+    T reduce_ids(size_t n, const T& identity, Combine& combine, AccumulateId&& accumulate) const
+    {
+        return ExecutionContext::instance().execute(
+            NUM_THREADS,
+            [&] { return reduce_in_order(n, identity, accumulate, combine); });
+    }
 };
 
 
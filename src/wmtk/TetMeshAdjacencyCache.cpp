@@ -0,0 +1,160 @@
+#include <wmtk/TetMesh.h>
+#include <wmtk/utils/TetMeshElementTopology.h>
+
+#include <wmtk/utils/VectorUtils.h>
+
+#include <Tracy.hpp>
+
+#include <algorithm>
+
+using namespace wmtk;
+
+void wmtk::TetMesh::enable_adjacency_cache(bool enable)
+{
+    m_use_adjacency_cache = enable;
+    if (enable) {
+        build_adjacency_cache(m_tet_adjacency);
+    } else {
+        m_tet_adjacency.clear();
+        m_tet_adjacency.shrink_to_fit();
+    }
+}
+
+void wmtk::TetMesh::build_adjacency_cache(vector<TetAdjacency>& adjacency) const
+{
+    ZoneScoped;
+    adjacency.clear();
+    adjacency.grow_to_at_least(m_tet_connectivity.size());
+
+    // sorted vids of the face, tid, local fid. Sorting puts the two tets of a face next to each
+    // other, the smaller tid first.
+    std::vector<std::array<size_t, 5>> faces;
+    // sorted vids of the edge, tid, local eid
+    std::vector<std::array<size_t, 4>> edges;
+    faces.reserve(tet_capacity() * 4);
+    edges.reserve(tet_capacity() * 6);
+    for (size_t i = 0; i < tet_capacity(); i++) {
+        if (m_tet_connectivity[i].m_is_removed) continue;
+        auto& tet = m_tet_connectivity[i];
+        for (auto j = 0; j < 4; j++) {
+            auto& f = utils::tet_element_topology::local_faces[j];
+            std::array<size_t, 5> face = {{tet[f[0]], tet[f[1]], tet[f[2]], i, size_t(j)}};
+            std::sort(face.begin(), face.begin() + 3);
+            faces.push_back(face);
+        }
+        for (auto j = 0; j < 6; j++) {
+            auto& e = utils::tet_element_topology::local_edges[j];
+            std::array<size_t, 4> edge = {{tet[e[0]], tet[e[1]], i, size_t(j)}};
+            if (edge[0] > edge[1]) std::swap(edge[0], edge[1]);
+            edges.push_back(edge);
+        }
+    }
+    std::sort(faces.begin(), faces.end());
+    std::sort(edges.begin(), edges.end());
+
+    for (size_t i = 0; i < faces.size();) {
+        auto& f0 = faces[i];
+        auto fid = f0[3] * 4 + f0[4];
+        if (i + 1 < faces.size() && std::equal(f0.begin(), f0.begin() + 3, faces[i + 1].begin())) {
+            auto& f1 = faces[i + 1];
+            assert(
+                i + 2 >= faces.size() ||
+                !std::equal(f0.begin(), f0.begin() + 3, faces[i + 2].begin()));
+            adjacency[f0[3]].tets[f0[4]] = f1[3];
+            adjacency[f0[3]].faces[f0[4]] = fid;
+            adjacency[f1[3]].tets[f1[4]] = f0[3];
+            adjacency[f1[3]].faces[f1[4]] = fid;
+            i += 2;
+        } else {
+            adjacency[f0[3]].tets[f0[4]] = -1;
+            adjacency[f0[3]].faces[f0[4]] = fid;
+            i++;
+        }
+    }
+
+    for (size_t i = 0; i < edges.size();) {
+        auto eid = edges[i][2] * 6 + edges[i][3];
+        auto j = i;
+        for (; j < edges.size() && edges[j][0] == edges[i][0] && edges[j][1] == edges[i][1]; j++)
+            adjacency[edges[j][2]].edges[edges[j][3]] = eid;
+        i = j;
+    }
+}
+
+void wmtk::TetMesh::AdjacencyCacheUpdate::add_tet(const std::array<size_t, 4>& tet)
+{
+    for (auto& f : utils::tet_element_topology::local_faces) {
+        std::array<size_t, 3> face = {{tet[f[0]], tet[f[1]], tet[f[2]]}};
+        std::sort(face.begin(), face.end());
+        faces.push_back(face);
+    }
+    for (auto& e : utils::tet_element_topology::local_edges) {
+        std::array<size_t, 2> edge = {{tet[e[0]], tet[e[1]]}};
+        if (edge[0] > edge[1]) std::swap(edge[0], edge[1]);
+        edges.push_back(edge);
+    }
+}
+
+void wmtk::TetMesh::update_adjacency_cache(AdjacencyCacheUpdate& update)
+{
+    ZoneScoped;
+    vector_unique(update.faces);
+    vector_unique(update.edges);
+
+    // the faces and edges that no longer exist have no tets left, and are skipped
+    for (auto& f : update.faces) {
+        auto tmp = set_intersection(
+            m_vertex_connectivity[f[0]].m_conn_tets,
+            m_vertex_connectivity[f[1]].m_conn_tets);
+        auto tids = set_intersection(tmp, m_vertex_connectivity[f[2]].m_conn_tets);
+        if (tids.empty()) continue;
+        assert(tids.size() <= 2);
+
+        auto l0 = m_tet_connectivity[tids[0]].find_local_face(f[0], f[1], f[2]);
+        assert(l0 >= 0);
+        auto fid = tids[0] * 4 + l0;
+        m_tet_adjacency[tids[0]].faces[l0] = fid;
+        if (tids.size() == 1) {
+            m_tet_adjacency[tids[0]].tets[l0] = -1;
+            continue;
+        }
+        auto l1 = m_tet_connectivity[tids[1]].find_local_face(f[0], f[1], f[2]);
+        assert(l1 >= 0);
+        m_tet_adjacency[tids[0]].tets[l0] = tids[1];
+        m_tet_adjacency[tids[1]].tets[l1] = tids[0];
+        m_tet_adjacency[tids[1]].faces[l1] = fid;
+    }
+
+    for (auto& e : update.edges) {
+        auto tids = set_intersection(
+            m_vertex_connectivity[e[0]].m_conn_tets,
+            m_vertex_connectivity[e[1]].m_conn_tets);
+        if (tids.empty()) continue;
+
+        size_t eid = -1;
+        for (auto t : tids) {
+            auto l = m_tet_connectivity[t].find_local_edge(e[0], e[1]);
+            assert(l >= 0);
+            if (eid == size_t(-1)) eid = t * 6 + l; // the smallest tid
+            m_tet_adjacency[t].edges[l] = eid;
+        }
+    }
+}
+
+bool wmtk::TetMesh::check_adjacency_cache_validity() const
+{
+    if (!m_use_adjacency_cache) return true;
+
+    auto expected = vector<TetAdjacency>();
+    build_adjacency_cache(expected);
+    for (size_t i = 0; i < tet_capacity(); i++) {
+        if (m_tet_connectivity[i].m_is_removed) continue;
+        if (m_tet_adjacency[i].tets != expected[i].tets ||
+            m_tet_adjacency[i].faces != expected[i].faces ||
+            m_tet_adjacency[i].edges != expected[i].edges) {
+            logger().debug("adjacency cache of tet {} is outdated", i);
+            return false;
+        }
+    }
+    return true;
+}
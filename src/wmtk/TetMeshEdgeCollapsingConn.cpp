@@ -1,4 +1,5 @@
 #include <wmtk/TetMesh.h>
+#include <wmtk/ExecutionTelemetry.hpp>
 
 #include <wmtk/utils/TetMeshElementTopology.h>
 #include <wmtk/utils/VectorUtils.h>
@@ -14,7 +15,9 @@
 using namespace wmtk;
 bool wmtk::TetMesh::collapse_edge(const Tuple& loc0, std::vector<Tuple>& new_edges)
 {
+    auto phase_timer = OperationPhaseTimer(OperationPhase::kBefore);
     if (!collapse_edge_before(loc0)) return false;
+    phase_timer.start(OperationPhase::kExecute);
 
     auto link_condition = [&VC = this->m_vertex_connectivity,
                            &TC = this->m_tet_connectivity,
@@ -138,13 +141,14 @@ bool wmtk::TetMesh::collapse_edge(const Tuple& loc0, std::vector<Tuple>& new_edg
 
 
     // should be a copy, for the purpose of rollback
-    auto n1_t_ids =
-        m_vertex_connectivity[v1_id].m_conn_tets; // note: conn_tets for v1 without removed tets
+    // note: conn_tets for v1 without removed tets
+    const auto& n1_conn_tets = m_vertex_connectivity[v1_id].m_conn_tets;
+    auto n1_t_ids = std::vector<size_t>(n1_conn_tets.begin(), n1_conn_tets.end());
     const auto& n2_t_ids = m_vertex_connectivity[v2_id].m_conn_tets;
 
     std::set<std::array<size_t, 4>> verify_conns; // simplified manifold topology check.
     for (auto _t : n2_t_ids) {
-        auto tet = m_tet_connectivity[_t].m_indices;
+        auto tet = m_tet_connectivity[_t].vids();
         std::sort(tet.begin(), tet.end());
         verify_conns.emplace(tet);
     }
@@ -166,7 +170,7 @@ bool wmtk::TetMesh::collapse_edge(const Tuple& loc0, std::vector<Tuple>& new_edg
         }
         if (l2 != -1) continue;
         assert(l1 != -1);
-        new_tet_conn.push_back(m_tet_connectivity[t_id].m_indices);
+        new_tet_conn.push_back(m_tet_connectivity[t_id].vids());
         new_tet_conn.back()[l1] = v2_id;
         preserved_tids.push_back(t_id);
     }
@@ -189,6 +193,8 @@ bool wmtk::TetMesh::collapse_edge(const Tuple& loc0, std::vector<Tuple>& new_edg
     //
     m_vertex_connectivity[v1_id].m_is_removed = true;
     m_vertex_connectivity[v1_id].m_conn_tets.clear();
+    m_vertex_count.add(-1);
+    m_free_vertices.stage(v1_id);
 
     // get eid, fid, tid for return
     Tuple new_loc;
@@ -230,9 +236,14 @@ bool wmtk::TetMesh::collapse_edge(const Tuple& loc0, std::vector<Tuple>& new_edg
     };
 
     start_protect_attributes();
-    if (!check_topology() || !collapse_edge_after(new_loc) ||
-        !invariants(get_one_ring_tets_for_vertex(new_loc))) {
+    auto after_success = check_topology();
+    phase_timer.start(OperationPhase::kAfter);
+    after_success = after_success && collapse_edge_after(new_loc);
+    phase_timer.start(OperationPhase::kInvariants);
+    if (!after_success || !invariants(get_one_ring_tets_for_vertex(new_loc))) {
+        phase_timer.start(OperationPhase::kRollback);
         m_vertex_connectivity[v1_id].m_is_removed = false;
+        m_vertex_count.add(1);
         operation_failure_rollback_imp(rollback_vert_conn, n1_t_ids, new_tet_id, old_tets);
         return false;
     }
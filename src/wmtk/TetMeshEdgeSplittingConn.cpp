@@ -1,11 +1,14 @@
 #include <wmtk/TetMesh.h>
+#include <wmtk/ExecutionTelemetry.hpp>
 
 #include <algorithm>
 #include <wmtk/utils/TupleUtils.hpp>
 
 bool wmtk::TetMesh::split_edge(const Tuple& loc0, std::vector<Tuple>& new_edges)
 {
+    auto phase_timer = OperationPhaseTimer(OperationPhase::kBefore);
     if (!split_edge_before(loc0)) return false;
+    phase_timer.start(OperationPhase::kExecute);
 
     // backup of everything
     auto loc1 = loc0;
@@ -47,12 +50,12 @@ bool wmtk::TetMesh::split_edge(const Tuple& loc0, std::vector<Tuple>& new_edges)
         old_tets_conn.push_back(tet);
         {
             auto l = tet.find(v2_id);
-            new_tet_conn[i] = (tet.m_indices);
+            new_tet_conn[i] = tet.vids();
             new_tet_conn[i][l] = v_id;
         }
         {
             auto l = tet.find(v1_id);
-            new_tet_conn[i + num] = (tet.m_indices);
+            new_tet_conn[i + num] = tet.vids();
             new_tet_conn[i + num][l] = v_id;
         }
     }
@@ -80,11 +83,17 @@ bool wmtk::TetMesh::split_edge(const Tuple& loc0, std::vector<Tuple>& new_edges)
     Tuple new_loc = Tuple(*this, v_id, eid_for_return, fid_for_return, tid_for_return);
 
     start_protect_attributes();
-    if (!split_edge_after(new_loc) || !invariants(get_one_ring_tets_for_vertex(new_loc))) {
+    phase_timer.start(OperationPhase::kAfter);
+    auto after_success = split_edge_after(new_loc);
+    phase_timer.start(OperationPhase::kInvariants);
+    if (!after_success || !invariants(get_one_ring_tets_for_vertex(new_loc))) {
+        phase_timer.start(OperationPhase::kRollback);
         m_vertex_connectivity[v_id].m_is_removed = true;
         m_vertex_connectivity[v_id].m_conn_tets.clear();
+        m_vertex_count.add(-1);
 
         operation_failure_rollback_imp(rollback_vert_conn, n12_t_ids, new_tet_id, old_tets_conn);
+        m_free_vertices.release(v_id);
 
         return false;
     }
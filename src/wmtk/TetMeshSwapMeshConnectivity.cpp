@@ -1,5 +1,6 @@
 
 #include <wmtk/TetMesh.h>
+#include <wmtk/ExecutionTelemetry.hpp>
 
 #include <wmtk/utils/VectorUtils.h>
 #include <wmtk/utils/TupleUtils.hpp>
@@ -31,12 +32,38 @@ void wmtk::TetMesh::operation_failure_rollback_imp(
     const std::vector<size_t>& new_tet_id,
     const std::vector<wmtk::TetMesh::TetrahedronConnectivity>& old_tets)
 {
+    auto update = AdjacencyCacheUpdate();
+    if (m_use_adjacency_cache) {
+        for (auto ti : new_tet_id) update.add_tet(m_tet_connectivity[ti].vids());
+        for (auto& tet : old_tets) update.add_tet(tet.vids());
+    }
+    long tet_delta = 0, vertex_delta = 0;
     for (auto ti : new_tet_id) {
+        if (!m_tet_connectivity[ti].m_is_removed) tet_delta--;
         m_tet_connectivity[ti].m_is_removed = true;
         m_tet_connectivity[ti].hash--;
     }
-    for (auto i = 0; i < affected.size(); i++) m_tet_connectivity[affected[i]] = old_tets[i];
-    for (auto& [v, conn] : rollback_vert_conn) m_vertex_connectivity[v] = std::move(conn);
+    for (auto i = 0; i < affected.size(); i++) {
+        tet_delta += long(m_tet_connectivity[affected[i]].m_is_removed) - old_tets[i].m_is_removed;
+        m_tet_connectivity[affected[i]] = old_tets[i];
+    }
+    for (auto& [v, conn] : rollback_vert_conn) {
+        vertex_delta += long(m_vertex_connectivity[v].m_is_removed) - conn.m_is_removed;
+        m_vertex_connectivity[v] = std::move(conn);
+    }
+    m_tet_count.add(tet_delta);
+    m_vertex_count.add(vertex_delta);
+
+    // the removed slots are restored, and the slots allocated past them are free again. Their hash
+    // is bumped, so that the tuples of the rejected tets stay invalid once they are reused
+    m_free_tets.discard();
+    m_free_vertices.discard();
+    for (auto ti : new_tet_id) {
+        if (!m_tet_connectivity[ti].m_is_removed) continue;
+        m_tet_connectivity[ti].hash++;
+        m_free_tets.release(ti);
+    }
+    if (m_use_adjacency_cache) update_adjacency_cache(update);
 
     rollback_protected_attributes();
 }
@@ -76,7 +103,11 @@ wmtk::TetMesh::operation_update_connectivity_impl(
     auto& vert_conn = this->m_vertex_connectivity;
     auto new_tid = std::vector<size_t>();
     auto affected_vid = std::set<size_t>();
+    auto update = AdjacencyCacheUpdate();
+    long tet_delta = 0;
     for (auto i : remove_id) {
+        if (m_use_adjacency_cache) update.add_tet(tet_conn[i].vids());
+        if (!tet_conn[i].m_is_removed) tet_delta--;
         tet_conn[i].m_is_removed = true;
         auto& conn = tet_conn[i].m_indices;
         for (auto j = 0; j < 4; j++) {
@@ -109,13 +140,16 @@ wmtk::TetMesh::operation_update_connectivity_impl(
             for (auto i = 0; i < add_size; i++) {
                 allocate_id[i + hole_size] = this->get_next_empty_slot_t(); // old_tet_size + i;
             }
+            // the reused slots can come before the removed ones
+            std::sort(allocate_id.begin(), allocate_id.end());
         }
     }
     assert(allocate_id.size() == new_tet_conn.size());
 
     for (auto i = 0; i < new_tet_conn.size(); i++) {
         auto id = allocate_id[i];
-        tet_conn[id].m_indices = new_tet_conn[i];
+        tet_conn[id].set_vids(new_tet_conn[i]);
+        if (tet_conn[id].m_is_removed) tet_delta++;
         tet_conn[id].m_is_removed = false;
         tet_conn[id].hash++;
         for (auto j = 0; j < 4; j++) {
@@ -123,7 +157,12 @@ wmtk::TetMesh::operation_update_connectivity_impl(
             assert(vert_conn.size() > vid && "Sufficient number of verts");
             wmtk::set_insert(vert_conn[vid].m_conn_tets, id);
         }
+        if (m_use_adjacency_cache) update.add_tet(new_tet_conn[i]);
     }
+    m_tet_count.add(tet_delta);
+    for (auto i : remove_id)
+        if (tet_conn[i].m_is_removed) m_free_tets.stage(i);
+    if (m_use_adjacency_cache) update_adjacency_cache(update);
 
     return rollback_vert_conn;
 }
@@ -134,7 +173,9 @@ bool wmtk::TetMesh::swap_edge(const Tuple& t, std::vector<Tuple>& new_tet_tuples
     // 3-2 edge to face.
     // only swap internal edges, not on boundary.
     // if (t.is_boundary_edge(*this)) return false;
+    auto phase_timer = OperationPhaseTimer(OperationPhase::kBefore);
     if (!swap_edge_before(t)) return false;
+    phase_timer.start(OperationPhase::kExecute);
     auto v1_id = t.vid(*this);
     auto v2_id = switch_vertex(t).vid(*this);
     auto& nb1 = m_vertex_connectivity[v1_id];
@@ -187,8 +228,8 @@ bool wmtk::TetMesh::swap_edge(const Tuple& t, std::vector<Tuple>& new_tet_tuples
             if (!inter.empty()) return false;
         }
 
-        new_tets[0] = tet_conn[t0_id].m_indices;
-        new_tets[1] = tet_conn[t1_id].m_indices;
+        new_tets[0] = tet_conn[t0_id].vids();
+        new_tets[1] = tet_conn[t1_id].vids();
 
         replace(new_tets[0], v2_id, n0_id);
         replace(new_tets[1], v1_id, n2_id);
@@ -219,7 +260,11 @@ bool wmtk::TetMesh::swap_edge(const Tuple& t, std::vector<Tuple>& new_tet_tuples
 
     for (auto ti : new_tet_id) new_tet_tuples.emplace_back(tuple_from_tet(ti));
     start_protect_attributes();
-    if (!swap_edge_after(newt) || !invariants(new_tet_tuples)) { // rollback post-operation
+    phase_timer.start(OperationPhase::kAfter);
+    auto after_success = swap_edge_after(newt);
+    phase_timer.start(OperationPhase::kInvariants);
+    if (!after_success || !invariants(new_tet_tuples)) { // rollback post-operation
+        phase_timer.start(OperationPhase::kRollback);
         assert(affected.size() == old_tets.size());
         operation_failure_rollback_imp(rollback_vert_conn, affected, new_tet_id, old_tets);
         return false;
@@ -304,7 +349,9 @@ bool wmtk::TetMesh::swap_edge_44(const Tuple& t, std::vector<Tuple>& new_tet_tup
     // 4-4 edge to face.
     // only swap internal edges, not on boundary.
     // if (t.is_boundary_edge(*this)) return false;
+    auto phase_timer = OperationPhaseTimer(OperationPhase::kBefore);
     if (!swap_edge_44_before(t)) return false;
+    phase_timer.start(OperationPhase::kExecute);
     auto v1_id = t.vid(*this);
     auto v2_id = switch_vertex(t).vid(*this);
     auto& nb1 = m_vertex_connectivity[v1_id];
@@ -332,7 +379,7 @@ bool wmtk::TetMesh::swap_edge_44(const Tuple& t, std::vector<Tuple>& new_tet_tup
 
     auto old_tets = record_old_tet_connectivity(m_tet_connectivity, affected);
     auto old_tets_conn = std::vector<std::array<size_t, 4>>();
-    for (auto& ti : old_tets) old_tets_conn.push_back(ti.m_indices);
+    for (auto& ti : old_tets) old_tets_conn.push_back(ti.vids());
 
     std::vector<size_t> new_tet_id;
     bool is_succeed = false;
@@ -391,7 +438,11 @@ bool wmtk::TetMesh::swap_edge_44(const Tuple& t, std::vector<Tuple>& new_tet_tup
 
         for (auto ti : new_tet_id) new_tet_tuples.emplace_back(tuple_from_tet(ti));
         start_protect_attributes();
-        if (!swap_edge_44_after(newt) || !invariants(new_tet_tuples)) { // rollback post-operation
+        phase_timer.start(OperationPhase::kAfter);
+        auto after_success = swap_edge_44_after(newt);
+        phase_timer.start(OperationPhase::kInvariants);
+        if (!after_success || !invariants(new_tet_tuples)) { // rollback post-operation
+            phase_timer.start(OperationPhase::kRollback);
             assert(affected.size() == old_tets.size());
             operation_failure_rollback_imp(rollback_vert_conn, affected, new_tet_id, old_tets);
             continue;
@@ -408,10 +459,12 @@ bool wmtk::TetMesh::swap_edge_44(const Tuple& t, std::vector<Tuple>& new_tet_tup
 
 bool wmtk::TetMesh::swap_face(const Tuple& t, std::vector<Tuple>& new_tet_tuples)
 {
+    auto phase_timer = OperationPhaseTimer(OperationPhase::kBefore);
     {
         if (t.is_boundary_face(*this)) return false;
         if (!swap_face_before(t)) return false;
     }
+    phase_timer.start(OperationPhase::kExecute);
 
     auto v0 = t.vid(*this);
     auto oppo = switch_vertex(t);
@@ -447,7 +500,7 @@ bool wmtk::TetMesh::swap_face(const Tuple& t, std::vector<Tuple>& new_tet_tuples
         auto u1 = find_other_v(m_tet_connectivity[t1].m_indices, tri);
         oppo_vid = {{u0, u1}};
         //
-        new_tets.resize(3, m_tet_connectivity[t0].m_indices);
+        new_tets.resize(3, m_tet_connectivity[t0].vids());
         for (auto i = 0; i < 3; i++) {
             replace(new_tets[i], tri[i], u1);
         }
@@ -496,7 +549,11 @@ bool wmtk::TetMesh::swap_face(const Tuple& t, std::vector<Tuple>& new_tet_tuples
         for (auto ti : new_tet_id) new_tet_tuples.emplace_back(tuple_from_tet(ti));
 
         start_protect_attributes();
-        if (!swap_face_after(newt) || !invariants(new_tet_tuples)) { // rollback post-operation
+        phase_timer.start(OperationPhase::kAfter);
+        auto after_success = swap_face_after(newt);
+        phase_timer.start(OperationPhase::kInvariants);
+        if (!after_success || !invariants(new_tet_tuples)) { // rollback post-operation
+            phase_timer.start(OperationPhase::kRollback);
 
             logger().trace("rolling back");
             operation_failure_rollback_imp(rollback_vert_conn, affected, new_tet_id, old_tets);
@@ -1,5 +1,6 @@
 
 #include <wmtk/TetMesh.h>
+#include <wmtk/ExecutionTelemetry.hpp>
 #include <wmtk/utils/TetMeshElementTopology.h>
 #include <wmtk/TetMeshCutTable.hpp>
 #include <wmtk/utils/TupleUtils.hpp>
@@ -104,6 +105,11 @@ void wmtk::TetMesh::triangle_insertion(
     }
     if (!triangle_insertion_before(old_faces)) return; // remember old_faces vids in cache
 
+    auto update = AdjacencyCacheUpdate();
+    if (m_use_adjacency_cache) {
+        for (size_t tid : intersected_tids) update.add_tet(m_tet_connectivity[tid].vids());
+    }
+
     ///subdivide
     std::map<std::array<size_t, 3>, std::vector<std::array<size_t, 5>>>
         new_face_vids; // note: vids of the face, tid, l_fid
@@ -117,6 +123,12 @@ void wmtk::TetMesh::triangle_insertion(
         new_center_vids,
         center_split_tets);
 
+    if (m_use_adjacency_cache) {
+        for (size_t tid : intersected_tids) update.add_tet(m_tet_connectivity[tid].vids());
+        for (size_t tid : new_tids) update.add_tet(m_tet_connectivity[tid].vids());
+        update_adjacency_cache(update);
+    }
+
     /// track surface after
     std::vector<std::vector<Tuple>> new_faces(old_faces.size() + 1);
     for (auto& info : new_face_vids) {
@@ -337,7 +349,7 @@ void wmtk::TetMesh::subdivide_a_tet(
                 auto vid = get_next_empty_slot_v();
                 new_center_vids.push_back(vid);
                 all_v_ids.push_back(vid);
-                center_split_tets.push_back(m_tet_connectivity[t_id].m_indices);
+                center_split_tets.push_back(m_tet_connectivity[t_id].vids());
 
                 is_add_centroid = true;
             }
@@ -347,6 +359,8 @@ void wmtk::TetMesh::subdivide_a_tet(
         if (i < config.size() - 1) {
             new_t_id = get_next_empty_slot_t();
             new_tids.push_back(new_t_id);
+            // the hash of a reused slot keeps increasing, to invalidate the tuples of its old tet
+            tet.hash = m_tet_connectivity[new_t_id].hash + 1;
         }
         m_tet_connectivity[new_t_id] = tet;
 
@@ -410,9 +424,14 @@ void wmtk::TetMesh::subdivide_a_tet(
 bool wmtk::TetMesh::insert_point(const Tuple& t, std::vector<Tuple>& new_tets)
 {
     ZoneScoped;
+    auto phase_timer = OperationPhaseTimer(OperationPhase::kBefore);
     if (!insert_point_before(t)) return false;
     start_protect_attributes();
-    if (!insert_point_after(new_tets) || !invariants(new_tets)) {
+    phase_timer.start(OperationPhase::kAfter);
+    auto after_success = insert_point_after(new_tets);
+    phase_timer.start(OperationPhase::kInvariants);
+    if (!after_success || !invariants(new_tets)) {
+        phase_timer.start(OperationPhase::kRollback);
         rollback_protected_attributes();
         return false;
     }
@@ -20,7 +20,10 @@ TetMeshTuple::TetMeshTuple(const TetMesh& m, size_t vid, size_t local_eid, size_
 
 bool TetMeshTuple::is_boundary_face(const TetMesh& m) const
 {
-    
+    if (m.m_use_adjacency_cache) {
+        return m.m_tet_adjacency[m_global_tid].tets[m_local_fid] == size_t(-1);
+    }
+
     auto v0 = this->vid(m);
     auto oppo = this->switch_vertex(m);
     auto v1 = oppo.vid(m);
@@ -117,15 +120,17 @@ size_t TetMeshTuple::vid(const TetMesh&) const
 size_t TetMeshTuple::eid(const TetMesh& m) const
 {
     ZoneScoped;
+    if (m.m_use_adjacency_cache) return m.m_tet_adjacency[m_global_tid].edges[m_local_eid];
+
     auto v1_id = m.m_tet_connectivity[m_global_tid][utils::tet_element_topology::local_edges[m_local_eid][0]];
     auto v2_id = m.m_tet_connectivity[m_global_tid][utils::tet_element_topology::local_edges[m_local_eid][1]];
     if (v1_id > v2_id) std::swap(v1_id, v2_id);
-    auto n12_t_ids = set_intersection(
-        m.m_vertex_connectivity[v1_id].m_conn_tets,
-        m.m_vertex_connectivity[v2_id].m_conn_tets);
-    assert(!n12_t_ids.empty());
+    // the edge is owned by its tet of smallest tid, the first one of the sorted one rings
+    const auto& n1_t_ids = m.m_vertex_connectivity[v1_id].m_conn_tets;
+    auto it = set_intersection_first(n1_t_ids, m.m_vertex_connectivity[v2_id].m_conn_tets);
+    assert(it != n1_t_ids.end());
 
-    auto tid = *std::min_element(n12_t_ids.begin(), n12_t_ids.end());
+    auto tid = *it;
     for (int j = 0; j < 6; j++) {
         auto tmp_v1_id = m.m_tet_connectivity[tid][utils::tet_element_topology::local_edges[j][0]];
         auto tmp_v2_id = m.m_tet_connectivity[tid][utils::tet_element_topology::local_edges[j][1]];
@@ -138,23 +143,26 @@ size_t TetMeshTuple::eid(const TetMesh& m) const
 
 size_t TetMeshTuple::fid(const TetMesh& m) const
 {
-    
+    if (m.m_use_adjacency_cache) return m.m_tet_adjacency[m_global_tid].faces[m_local_fid];
+
     std::array<size_t, 3> v_ids = {
         {m.m_tet_connectivity[m_global_tid][utils::tet_element_topology::local_faces[m_local_fid][0]],
          m.m_tet_connectivity[m_global_tid][utils::tet_element_topology::local_faces[m_local_fid][1]],
          m.m_tet_connectivity[m_global_tid][utils::tet_element_topology::local_faces[m_local_fid][2]]}};
-    auto tmp = set_intersection(
-        m.m_vertex_connectivity[v_ids[0]].m_conn_tets,
-        m.m_vertex_connectivity[v_ids[1]].m_conn_tets);
-    auto n12_t_ids = set_intersection(tmp, m.m_vertex_connectivity[v_ids[2]].m_conn_tets);
-    assert(n12_t_ids.size() == 1 || n12_t_ids.size() == 2);
-
-    if (n12_t_ids.size() == 1) {
+    // the face is owned by its tet of smallest tid, among the sorted tets of one of its edges
+    size_t n12_size = 0;
+    size_t tid = -1;
+    m.for_each_incident_tid_of_edge(v_ids[0], v_ids[1], [&](size_t t) {
+        if (m.m_tet_connectivity[t].find(v_ids[2]) == -1) return;
+        if (n12_size++ == 0) tid = t;
+    });
+    assert(n12_size == 1 || n12_size == 2);
+
+    if (n12_size == 1) {
         return m_global_tid * 4 + m_local_fid;
     }
 
     std::sort(v_ids.begin(), v_ids.end());
-    int tid = *std::min_element(n12_t_ids.begin(), n12_t_ids.end());
     for (int j = 0; j < 4; j++) {
         std::array<size_t, 3> tmp_v_ids = {
             {m.m_tet_connectivity[tid][utils::tet_element_topology::local_faces[j][0]],
@@ -231,17 +239,24 @@ std::optional<TetMeshTuple> TetMeshTuple::switch_tetrahedron(const TetMesh& m) c
     size_t v1_id = m.m_tet_connectivity[m_global_tid][utils::tet_element_topology::local_faces[m_local_fid][0]];
     size_t v2_id = m.m_tet_connectivity[m_global_tid][utils::tet_element_topology::local_faces[m_local_fid][1]];
     size_t v3_id = m.m_tet_connectivity[m_global_tid][utils::tet_element_topology::local_faces[m_local_fid][2]];
-    auto tmp = set_intersection(
-        m.m_vertex_connectivity[v1_id].m_conn_tets,
-        m.m_vertex_connectivity[v2_id].m_conn_tets);
-    auto n123_tids = set_intersection(tmp, m.m_vertex_connectivity[v3_id].m_conn_tets);
-    assert(n123_tids.size() == 1 || n123_tids.size() == 2);
+    size_t adj_tid = -1;
+    if (m.m_use_adjacency_cache) {
+        adj_tid = m.m_tet_adjacency[m_global_tid].tets[m_local_fid];
+    } else {
+        auto tmp = set_intersection(
+            m.m_vertex_connectivity[v1_id].m_conn_tets,
+            m.m_vertex_connectivity[v2_id].m_conn_tets);
+        auto n123_tids = set_intersection(tmp, m.m_vertex_connectivity[v3_id].m_conn_tets);
+        assert(n123_tids.size() == 1 || n123_tids.size() == 2);
+        if (n123_tids.size() == 2)
+            adj_tid = n123_tids[0] == m_global_tid ? n123_tids[1] : n123_tids[0];
+    }
 
-    if (n123_tids.size() == 1)
+    if (adj_tid == size_t(-1))
         return {};
     else {
         TetMeshTuple loc = *this;
-        loc.m_global_tid = n123_tids[0] == m_global_tid ? n123_tids[1] : n123_tids[0];
+        loc.m_global_tid = adj_tid;
 
         loc.m_local_eid = m.m_tet_connectivity[loc.m_global_tid].find_local_edge(
             m.m_tet_connectivity[m_global_tid][utils::tet_element_topology::local_edges[m_local_eid][0]],
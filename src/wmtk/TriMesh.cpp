@@ -4,6 +4,7 @@
 #include <wmtk/TriMeshOperation.h>
 #include <wmtk/AttributeCollection.hpp>
 #include <wmtk/utils/Logger.hpp>
+#include <wmtk/utils/ParallelCollect.hpp>
 #include <wmtk/utils/TupleUtils.hpp>
 #include "wmtk/utils/VectorUtils.h"
 
@@ -93,6 +94,16 @@ bool wmtk::TriMesh::check_mesh_connectivity_validity() const
     for (unsigned i = 0; i < vert_capacity(); ++i)
         std::sort(conn_tris[i].begin(), conn_tris[i].end());
 
+    // check the live counts, including the changes of the current operation
+    size_t n_vertices = 0, n_tris = 0;
+    for (size_t i = 0; i < vert_capacity(); i++)
+        if (!m_vertex_connectivity[i].m_is_removed) n_vertices++;
+    for (size_t i = 0; i < tri_capacity(); i++)
+        if (!m_tri_connectivity[i].m_is_removed) n_tris++;
+    assert(
+        n_vertices == vertex_size() + m_vertex_count.staged() && "vertex_size() is out of date");
+    assert(n_tris == tri_size() + m_tri_count.staged() && "tri_size() is out of date");
+
     // check conn_tets duplication, order, amount ...
     for (size_t i = 0; i < vert_capacity(); i++) {
         if (m_vertex_connectivity[i].m_is_removed) continue;
@@ -143,6 +154,13 @@ void TriMesh::consolidate_mesh()
     op(*this, TriMesh::Tuple{});
 }
 
+void TriMesh::consolidate_mesh(const std::function<Eigen::Vector3d(size_t)>& vertex_position)
+{
+    TriMeshConsolidateOperation op;
+    op.vertex_position = vertex_position;
+    op(*this, TriMesh::Tuple{});
+}
+
 
 std::vector<size_t> TriMesh::get_one_ring_vids_for_vertex_with_duplicates(const size_t& vid) const
 {
@@ -179,15 +197,11 @@ std::vector<wmtk::TriMesh::Tuple> TriMesh::get_one_ring_tris_for_vertex(
     const wmtk::TriMesh::Tuple& t) const
 {
     std::vector<TriMesh::Tuple> one_ring;
-    size_t vid = t.vid(*this);
-    auto& conn_tri = m_vertex_connectivity[vid].m_conn_tris;
-    one_ring.reserve(conn_tri.size());
-    for (size_t tri : conn_tri) {
-        int j = m_tri_connectivity[tri].find(vid);
-        one_ring.emplace_back(vid, (j + 2) % 3, tri, *this);
-        assert(one_ring[one_ring.size() - 1].is_valid(*this));
-    }
-
+    one_ring.reserve(m_vertex_connectivity[t.vid(*this)].m_conn_tris.size());
+    for_each_tri_around_vertex(t, [&](const Tuple& tri) {
+        assert(tri.is_valid(*this));
+        one_ring.push_back(tri);
+    });
     return one_ring;
 }
 
@@ -195,31 +209,25 @@ std::vector<wmtk::TriMesh::Tuple> TriMesh::get_one_ring_edges_for_vertex(
     const wmtk::TriMesh::Tuple& t) const
 {
     std::vector<Tuple> one_ring_edges;
-    std::vector<size_t> one_ring_vertices;
-    size_t vid = t.vid(*this);
-    auto one_ring_tris = get_one_ring_tris_for_vertex(t);
-    for (auto tri : one_ring_tris) {
-        // find the vertex
-        while (tri.vid(*this) != vid) {
-            tri = tri.switch_vertex(*this).switch_edge(*this);
-        }
-
-        // push first edge if not there
-        if (!vector_contains(one_ring_vertices, tri.switch_vertex(*this).vid(*this))) {
-            one_ring_vertices.push_back(tri.switch_vertex(*this).vid(*this));
-            one_ring_edges.push_back(tri.switch_vertex(*this));
-        }
-
-        // push second edge if not there
-        tri = tri.switch_edge(*this);
-        if (!vector_contains(one_ring_vertices, tri.switch_vertex(*this).vid(*this))) {
-            one_ring_vertices.push_back(tri.switch_vertex(*this).vid(*this));
-            one_ring_edges.push_back(tri.switch_vertex(*this));
-        }
-    }
+    for_each_edge_around_vertex(t, [&](const Tuple& e) { one_ring_edges.push_back(e); });
+    return one_ring_edges;
+}
 
-    assert(one_ring_vertices.size() == one_ring_edges.size());
+const std::vector<wmtk::TriMesh::Tuple>& TriMesh::get_one_ring_tris_for_vertex_scratch(
+    const wmtk::TriMesh::Tuple& t) const
+{
+    auto& one_ring = m_one_ring_tris_scratch.local();
+    one_ring.clear();
+    for_each_tri_around_vertex(t, [&](const Tuple& tri) { one_ring.push_back(tri); });
+    return one_ring;
+}
 
+const std::vector<wmtk::TriMesh::Tuple>& TriMesh::get_one_ring_edges_for_vertex_scratch(
+    const wmtk::TriMesh::Tuple& t) const
+{
+    auto& one_ring_edges = m_one_ring_edges_scratch.local();
+    one_ring_edges.clear();
+    for_each_edge_around_vertex(t, [&](const Tuple& e) { one_ring_edges.push_back(e); });
     return one_ring_edges;
 }
 
@@ -262,13 +270,14 @@ void TriMesh::create_mesh(size_t n_vertices, const std::vector<std::array<size_t
     for (int i = 0; i < tris.size(); i++) {
         m_tri_connectivity[i].m_is_removed = false;
 
-        m_tri_connectivity[i].m_indices = tris[i];
+        m_tri_connectivity[i].set_vids(tris[i]);
 
         m_tri_connectivity[i].hash = hash_cnt;
     }
     current_tri_size = tris.size();
 
     build_vertex_connectivity(n_vertices);
+    reset_element_counts();
 
     // Resize user class attributes
     if (p_vertex_attrs) p_vertex_attrs->grow_to_at_least(vert_capacity());
@@ -278,10 +287,20 @@ void TriMesh::create_mesh(size_t n_vertices, const std::vector<std::array<size_t
 
 void TriMesh::build_vertex_connectivity(size_t n_vertices)
 {
+    check_connectivity_index_range(n_vertices);
     m_vertex_connectivity.m_attributes.grow_to_at_least(n_vertices);
     for (int i = 0; i < n_vertices; i++) {
         m_vertex_connectivity[i].m_is_removed = false;
     }
+
+    // allocate each vertex list once, with the exact number of triangles
+    std::vector<size_t> valences(n_vertices, 0);
+    for (int i = 0; i < m_tri_connectivity.size(); i++) {
+        if (m_tri_connectivity[i].m_is_removed) continue;
+        for (auto v : m_tri_connectivity[i].m_indices) valences[v]++;
+    }
+    for (int i = 0; i < n_vertices; i++)
+        m_vertex_connectivity[i].m_conn_tris.reserve(valences[i]);
     for (int i = 0; i < m_tri_connectivity.size(); i++) {
         auto& tri_con = m_tri_connectivity[i];
         if (!tri_con.m_is_removed) {
@@ -295,76 +314,96 @@ void TriMesh::build_vertex_connectivity(size_t n_vertices)
     m_vertex_mutex.grow_to_at_least(n_vertices);
 }
 
+void TriMesh::reset_element_counts()
+{
+    size_t n_vertices = 0, n_tris = 0;
+    for (size_t i = 0; i < vert_capacity(); i++)
+        if (!m_vertex_connectivity[i].m_is_removed) n_vertices++;
+    for (size_t i = 0; i < tri_capacity(); i++)
+        if (!m_tri_connectivity[i].m_is_removed) n_tris++;
+    m_vertex_count.reset(n_vertices);
+    m_tri_count.reset(n_tris);
+    release_reserved_slots();
+}
+
 std::vector<TriMesh::Tuple> TriMesh::get_vertices() const
 {
-    const size_t n_vertices = vert_capacity();
     std::vector<Tuple> all_vertices_tuples;
-    all_vertices_tuples.reserve(n_vertices);
-
-    for (size_t i = 0; i < n_vertices; i++) {
-        if (m_vertex_connectivity[i].m_is_removed) continue;
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
+    arena.execute([&] {
+        all_vertices_tuples =
+            collect_in_order<Tuple>(vert_capacity(), [&](size_t i, std::vector<Tuple>& out) {
+                if (m_vertex_connectivity[i].m_is_removed) return;
 
-        const std::vector<size_t>& v_conn_fids = m_vertex_connectivity[i].m_conn_tris;
+                const std::vector<size_t>& v_conn_fids = m_vertex_connectivity[i].m_conn_tris;
 
-        assert(v_conn_fids.size() > 0);
-        size_t fid = *min_element(v_conn_fids.begin(), v_conn_fids.end());
+                assert(v_conn_fids.size() > 0);
+                size_t fid = *min_element(v_conn_fids.begin(), v_conn_fids.end());
 
-        // get the 3 vid
-        const std::array<size_t, 3> f_conn_verts = m_tri_connectivity[fid].m_indices;
-        assert(i == f_conn_verts[0] || i == f_conn_verts[1] || i == f_conn_verts[2]);
+                // get the 3 vid
+                const std::array<size_t, 3> f_conn_verts = m_tri_connectivity[fid].vids();
+                assert(i == f_conn_verts[0] || i == f_conn_verts[1] || i == f_conn_verts[2]);
 
-        size_t eid = -1;
+                size_t eid = -1;
 
-        // eid is the same as the lvid
-        if (i == f_conn_verts[0]) eid = 2;
-        if (i == f_conn_verts[1])
-            eid = 0;
-        else
-            eid = 1;
+                // eid is the same as the lvid
+                if (i == f_conn_verts[0]) eid = 2;
+                if (i == f_conn_verts[1])
+                    eid = 0;
+                else
+                    eid = 1;
 
-        Tuple v_tuple = Tuple(i, eid, fid, *this);
-        assert(v_tuple.is_valid(*this));
-        all_vertices_tuples.push_back(v_tuple);
-    }
+                Tuple v_tuple = Tuple(i, eid, fid, *this);
+                assert(v_tuple.is_valid(*this));
+                out.push_back(v_tuple);
+            });
+    });
     return all_vertices_tuples;
 }
 
 std::vector<TriMesh::Tuple> TriMesh::get_faces() const
 {
     std::vector<Tuple> all_faces_tuples;
-    all_faces_tuples.reserve(tri_capacity());
     assert(tri_capacity() <= m_tri_connectivity.size());
-    for (size_t i = 0; i < tri_capacity(); i++) {
-        const TriangleConnectivity& tri_con = m_tri_connectivity[i];
-        if (tri_con.m_is_removed) {
-            continue;
-        }
-        // get the 3 vid
-        const std::array<size_t, 3>& f_conn_verts = tri_con.m_indices;
-        size_t vid = f_conn_verts[0];
-        Tuple f_tuple = Tuple(vid, 2, i, *this);
-        assert(f_tuple.is_valid(*this));
-        all_faces_tuples.emplace_back(f_tuple);
-    }
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
+    arena.execute([&] {
+        all_faces_tuples =
+            collect_in_order<Tuple>(tri_capacity(), [&](size_t i, std::vector<Tuple>& out) {
+                const TriangleConnectivity& tri_con = m_tri_connectivity[i];
+                if (tri_con.m_is_removed) {
+                    return;
+                }
+                // get the 3 vid
+                const std::array<size_t, 3> f_conn_verts = tri_con.vids();
+                size_t vid = f_conn_verts[0];
+                Tuple f_tuple = Tuple(vid, 2, i, *this);
+                assert(f_tuple.is_valid(*this));
+                out.emplace_back(f_tuple);
+            });
+    });
     return all_faces_tuples;
 }
 
 std::vector<TriMesh::Tuple> TriMesh::get_edges() const
 {
+    // each edge is emitted once, by the tri of smallest fid around it
     std::vector<TriMesh::Tuple> all_edges_tuples;
-    all_edges_tuples.reserve(tri_capacity() * 3);
     assert(tri_capacity() <= m_tri_connectivity.size());
-    for (int i = 0; i < tri_capacity(); i++) {
-        const TriangleConnectivity& con = m_tri_connectivity[i];
-        if (con.m_is_removed) continue;
-        for (int j = 0; j < 3; j++) {
-            size_t l = (j + 2) % 3;
-            auto tup = Tuple(con.m_indices[j], l, i, *this);
-            if (tup.eid(*this) == 3 * i + l) {
-                all_edges_tuples.emplace_back(tup);
-            }
-        }
-    }
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
+    arena.execute([&] {
+        all_edges_tuples =
+            collect_in_order<Tuple>(tri_capacity(), [&](size_t i, std::vector<Tuple>& out) {
+                const TriangleConnectivity& con = m_tri_connectivity[i];
+                if (con.m_is_removed) return;
+                for (int j = 0; j < 3; j++) {
+                    size_t l = (j + 2) % 3;
+                    auto tup = Tuple(con.m_indices[j], l, i, *this);
+                    if (tup.eid(*this) == 3 * i + l) {
+                        out.emplace_back(tup);
+                    }
+                }
+            });
+    });
 
     return all_edges_tuples;
 }
@@ -379,50 +418,71 @@ TriMesh::Tuple TriMesh::init_from_edge(size_t vid1, size_t vid2, size_t fid) con
 }
 
 
+void TriMesh::reserve_tri_slab()
+{
+    tbb::spin_mutex::scoped_lock lock(tri_connectivity_lock);
+    const size_t begin = current_tri_size;
+    const size_t end = begin + (NUM_THREADS > 1 ? SlotFreeList::slab_size : 1);
+    if (end > m_tri_connectivity.size()) {
+        const size_t capacity = std::max(2 * m_tri_connectivity.size(), end);
+        if (p_edge_attrs) p_edge_attrs->grow_to_at_least(capacity * 3);
+        if (p_face_attrs) p_face_attrs->grow_to_at_least(capacity);
+        m_tri_connectivity.grow_to_at_least(capacity);
+    }
+
+    // the slots left past a consolidation are stale. They are reset without being recorded for
+    // rollback, as they are not part of the mesh before the operation
+    for (size_t i = begin; i < end; i++) {
+        m_tri_connectivity.m_attributes[i] = TriangleConnectivity();
+    }
+    current_tri_size = end;
+    m_tri_slabs.reserve(begin, end);
+}
+
 size_t TriMesh::get_next_empty_slot_t()
 {
-    while (current_tri_size + MAX_THREADS >= m_tri_connectivity.size() ||
-           tri_connectivity_synchronizing_flag) {
-        if (tri_connectivity_lock.try_lock()) {
-            if (current_tri_size + MAX_THREADS < m_tri_connectivity.size()) {
-                tri_connectivity_lock.unlock();
-                break;
-            }
-            tri_connectivity_synchronizing_flag = true;
-            auto current_capacity = m_tri_connectivity.size();
-            if (p_edge_attrs) p_edge_attrs->grow_to_at_least(2 * current_capacity * 3);
-            if (p_face_attrs) p_face_attrs->grow_to_at_least(2 * current_capacity);
-            m_tri_connectivity.grow_to_at_least(2 * current_capacity);
-            tri_connectivity_synchronizing_flag = false;
-            tri_connectivity_lock.unlock();
-            break;
-        }
+    auto fid = m_tri_slabs.pop();
+    if (!fid) {
+        reserve_tri_slab();
+        fid = m_tri_slabs.pop();
     }
+    return *fid;
+}
 
-    return current_tri_size++;
+void TriMesh::reserve_vertex_slab()
+{
+    tbb::spin_mutex::scoped_lock lock(vertex_connectivity_lock);
+    const size_t begin = current_vert_size;
+    const size_t end = begin + (NUM_THREADS > 1 ? SlotFreeList::slab_size : 1);
+    check_connectivity_index_range(end);
+    if (end > m_vertex_connectivity.size()) {
+        const size_t capacity = std::max(2 * m_vertex_connectivity.size(), end);
+        if (p_vertex_attrs) p_vertex_attrs->grow_to_at_least(capacity);
+        resize_mutex(capacity);
+        m_vertex_connectivity.grow_to_at_least(capacity);
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        m_vertex_connectivity.m_attributes[i] = VertexConnectivity();
+    }
+    current_vert_size = end;
+    m_vertex_slabs.reserve(begin, end);
 }
 
 size_t TriMesh::get_next_empty_slot_v()
 {
-    while (current_vert_size + MAX_THREADS >= m_vertex_connectivity.size() ||
-           vertex_connectivity_synchronizing_flag) {
-        if (vertex_connectivity_lock.try_lock()) {
-            if (current_vert_size + MAX_THREADS < m_vertex_connectivity.size()) {
-                vertex_connectivity_lock.unlock();
-                break;
-            }
-            vertex_connectivity_synchronizing_flag = true;
-            auto current_capacity = m_vertex_connectivity.size();
-            if (p_vertex_attrs) p_vertex_attrs->grow_to_at_least(2 * current_capacity);
-            resize_mutex(2 * current_capacity);
-            m_vertex_connectivity.grow_to_at_least(2 * current_capacity);
-            vertex_connectivity_synchronizing_flag = false;
-            vertex_connectivity_lock.unlock();
-            break;
-        }
+    auto vid = m_vertex_slabs.pop();
+    if (!vid) {
+        reserve_vertex_slab();
+        vid = m_vertex_slabs.pop();
     }
+    return *vid;
+}
 
-    return current_vert_size++;
+void TriMesh::release_reserved_slots()
+{
+    m_vertex_slabs.drop_slabs();
+    m_tri_slabs.drop_slabs();
 }
 
 
@@ -543,7 +603,7 @@ bool wmtk::TriMesh::try_set_vertex_mutex_one_ring(const Tuple& v, int threadid)
 
 void wmtk::TriMesh::for_each_edge(const std::function<void(const TriMesh::Tuple&)>& func)
 {
-    tbb::task_arena arena(NUM_THREADS);
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
     arena.execute([&] {
         tbb::parallel_for(
             tbb::blocked_range<int>(0, tri_capacity()),
@@ -563,7 +623,7 @@ void wmtk::TriMesh::for_each_edge(const std::function<void(const TriMesh::Tuple&
 
 void wmtk::TriMesh::for_each_vertex(const std::function<void(const TriMesh::Tuple&)>& func)
 {
-    tbb::task_arena arena(NUM_THREADS);
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
     arena.execute([&] {
         tbb::parallel_for(
             tbb::blocked_range<int>(0, vert_capacity()),
@@ -579,7 +639,7 @@ void wmtk::TriMesh::for_each_vertex(const std::function<void(const TriMesh::Tupl
 
 void wmtk::TriMesh::for_each_face(const std::function<void(const TriMesh::Tuple&)>& func)
 {
-    tbb::task_arena arena(NUM_THREADS);
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
     arena.execute([&] {
         tbb::parallel_for(
             tbb::blocked_range<int>(0, tri_capacity()),
@@ -595,6 +655,8 @@ void wmtk::TriMesh::for_each_face(const std::function<void(const TriMesh::Tuple&
 
 std::optional<size_t> TriMesh::release_protected_connectivity()
 {
+    m_vertex_count.commit();
+    m_tri_count.commit();
     m_vertex_connectivity.end_protect();
     return m_tri_connectivity.end_protect();
 }
@@ -628,6 +690,8 @@ void TriMesh::rollback_protected_connectivity()
 {
     m_vertex_connectivity.rollback();
     m_tri_connectivity.rollback();
+    m_vertex_count.discard();
+    m_tri_count.discard();
 }
 
 void TriMesh::rollback_protected()
@@ -1,7 +1,13 @@
 #pragma once
 
 #define USE_OPERATION_LOGGER
+#include <wmtk/ExecutionContext.hpp>
 #include <wmtk/TriMeshTuple.h>
+#include <wmtk/utils/ConnectivityIndex.hpp>
+#include <wmtk/utils/ElementCounter.hpp>
+#include <wmtk/utils/ParallelCollect.hpp>
+#include <wmtk/utils/SlotFreeList.hpp>
+#include <wmtk/utils/SmallVector.hpp>
 #include <wmtk/utils/VectorUtils.h>
 #include <wmtk/AttributeCollection.hpp>
 #include <wmtk/utils/Logger.hpp>
@@ -10,6 +16,7 @@
 #include <wmtk/utils/DisableWarnings.hpp>
 #include <tbb/concurrent_vector.h>
 #include <tbb/spin_mutex.h>
+#include <tbb/task_arena.h>
 #include <wmtk/utils/EnableWarnings.hpp>
 // clang-format on
 
@@ -82,7 +89,7 @@ public:
          * @brief incident vertices of a given triangle
          *
          */
-        std::array<size_t, 3> m_indices;
+        std::array<ConnectivityIndex, 3> m_indices;
         /**
          * @brief is the triangle removed
          *
@@ -95,7 +102,7 @@ public:
          */
         size_t hash = 0;
 
-        inline size_t& operator[](size_t index)
+        inline ConnectivityIndex& operator[](size_t index)
         {
             assert(index < 3);
             return m_indices[index];
@@ -118,6 +125,15 @@ public:
             }
             return -1;
         }
+        /**
+         * @brief the vids of the triangle, independently of the ConnectivityIndex they are stored
+         * as
+         */
+        std::array<size_t, 3> vids() const { return convert_indices<size_t>(m_indices); }
+        void set_vids(const std::array<size_t, 3>& vids)
+        {
+            m_indices = convert_indices<ConnectivityIndex>(vids);
+        }
     };
 
     friend class TriMeshOperation;
@@ -196,11 +212,15 @@ protected:
 protected:
     std::atomic_long current_vert_size;
     std::atomic_long current_tri_size;
+    // the number of slots below the capacities that are not removed. The operations stage their
+    // changes, which are committed with the connectivity
+    ElementCounter m_vertex_count;
+    ElementCounter m_tri_count;
+    // the slabs of new slots of each thread, and the lock guarding their reservation
+    SlotFreeList m_vertex_slabs;
+    SlotFreeList m_tri_slabs;
     tbb::spin_mutex vertex_connectivity_lock;
     tbb::spin_mutex tri_connectivity_lock;
-    bool vertex_connectivity_synchronizing_flag = false;
-    bool tri_connectivity_synchronizing_flag = false;
-    int MAX_THREADS = 128;
 
 #if defined(USE_OPERATION_LOGGER)
     tbb::enumerable_thread_specific<std::weak_ptr<TriMeshOperationRecorder>> p_operation_recorder{
@@ -218,6 +238,10 @@ protected:
      * @return size_t
      */
     size_t get_next_empty_slot_v();
+    // reserve the next slab of new slots for the calling thread, growing the mesh and the
+    // attributes if needed
+    void reserve_tri_slab();
+    void reserve_vertex_slab();
 
 public:
     /**
@@ -240,12 +264,37 @@ public:
      * @return size_t
      */
     size_t vert_capacity() const { return current_vert_size; }
+    /**
+     * @brief get the number of unremoved vertices, in constant time
+     *
+     * @note the changes of an operation are counted once it is done, not while it runs
+     */
+    size_t vertex_size() const { return m_vertex_count.get(); }
+    /**
+     * @brief get the number of unremoved triangles, in constant time
+     *
+     * @note the changes of an operation are counted once it is done, not while it runs
+     */
+    size_t tri_size() const { return m_tri_count.get(); }
     /**
      * @brief removing the elements that are removed
      *
      * @param bnd_output when turn on will write the boundary vertices to "bdn_table.dmat"
      */
     void consolidate_mesh();
+    /**
+     * @brief consolidate_mesh, that also renumbers the vertices along the Morton order of their
+     * positions, and the triangles along the order of their first vertex, so that the elements
+     * close in space are close in memory
+     *
+     * @param vertex_position the position of a vertex, given its id before the consolidation
+     */
+    void consolidate_mesh(const std::function<Eigen::Vector3d(size_t)>& vertex_position);
+    /**
+     * @brief drop the new slots that the threads reserved but did not use yet, so that the elements
+     * created from now on have ids past the current capacities. Not thread safe.
+     */
+    void release_reserved_slots();
     /**
      * @brief a duplicate of Tuple::switch_vertex funciton
      */
@@ -329,6 +378,60 @@ public:
      */
     std::vector<Tuple> get_one_ring_edges_for_vertex(const Tuple& t) const;
 
+    /**
+     * @brief visit the one ring tris of a vertex, without any allocation
+     *
+     * @param t tuple pointing to a vertex
+     * @param visit called with a Tuple of each tri that points to the vertex. It must not change
+     * the connectivity.
+     */
+    template <typename Visitor>
+    void for_each_tri_around_vertex(const Tuple& t, Visitor&& visit) const
+    {
+        const size_t vid = t.vid(*this);
+        for (size_t tri : m_vertex_connectivity[vid].m_conn_tris) {
+            int j = m_tri_connectivity[tri].find(vid);
+            visit(Tuple(vid, (j + 2) % 3, tri, *this));
+        }
+    }
+    /**
+     * @brief visit the edges incident to a vertex once each, in the order of
+     * get_one_ring_edges_for_vertex and without any allocation for the usual valences
+     *
+     * @param t tuple pointing to a vertex
+     * @param visit called with a Tuple of each edge that points to its other vertex. It must not
+     * change the connectivity.
+     */
+    template <typename Visitor>
+    void for_each_edge_around_vertex(const Tuple& t, Visitor&& visit) const
+    {
+        SmallVector<size_t, 16> one_ring_vertices;
+        for_each_tri_around_vertex(t, [&](Tuple tri) {
+            for (int k = 0; k < 2; k++) {
+                if (k == 1) tri = tri.switch_edge(*this);
+                auto e = tri.switch_vertex(*this);
+                if (vector_contains(one_ring_vertices, e.vid(*this))) continue;
+                one_ring_vertices.push_back(e.vid(*this));
+                visit(e);
+            }
+        });
+    }
+
+    /**
+     * @brief Get the one ring tris for a vertex, in a buffer of the calling thread
+     *
+     * @param t tuple pointing to a vertex
+     * @return one-ring tris, valid until the next call of this function by the same thread
+     */
+    const std::vector<Tuple>& get_one_ring_tris_for_vertex_scratch(const Tuple& t) const;
+    /**
+     * @brief Get the one ring edges for a vertex, in a buffer of the calling thread
+     *
+     * @param t tuple pointing to a vertex
+     * @return one-ring edges, valid until the next call of this function by the same thread
+     */
+    const std::vector<Tuple>& get_one_ring_edges_for_vertex_scratch(const Tuple& t) const;
+
     /**
      * @brief Get the incident vertices for a triangle
      *
@@ -389,6 +492,10 @@ protected:
      * @param n_vertices Input number of vertices
      */
     void build_vertex_connectivity(size_t n_vertices);
+    /**
+     * @brief recount the unremoved vertices and triangles, after the connectivity was rebuilt
+     */
+    void reset_element_counts();
     /**
      * @brief Start the phase where the attributes that will be modified can be recorded
      *
@@ -439,6 +546,10 @@ protected:
     // Moved code from concurrent TriMesh
 
 private:
+    // the buffers of the *_scratch queries, one per query so that they can be nested
+    mutable tbb::enumerable_thread_specific<std::vector<Tuple>> m_one_ring_tris_scratch;
+    mutable tbb::enumerable_thread_specific<std::vector<Tuple>> m_one_ring_edges_scratch;
+
     class VertexMutex;
     tbb::concurrent_vector<VertexMutex> m_vertex_mutex;
 
@@ -496,7 +607,60 @@ public:
      *
      */
     void for_each_vertex(const std::function<void(const Tuple&)>&);
+
+    /**
+     * @brief reduce a value over the faces in parallel, without any shared state
+     *
+     * @param identity the initial value of each accumulator
+     * @param accumulate called as accumulate(T& acc, const Tuple& t) to fold each face into the
+     * accumulator of its range of faces
+     * @param combine called as combine(const T& a, const T& b) to join two accumulators
+     * @return the reduced value, the same for any number of threads
+     */
+    template <typename T, typename Accumulate, typename Combine>
+    T reduce_face(const T& identity, Accumulate&& accumulate, Combine&& combine) const
+    {
+        return reduce_ids(tri_capacity(), identity, combine, [&](T& acc, size_t i) {
+            auto tup = tuple_from_tri(i);
+            if (tup.is_valid(*this)) accumulate(acc, tup);
+        });
+    }
+    /**
+     * @brief reduce a value over the vertices in parallel, see reduce_face
+     */
+    template <typename T, typename Accumulate, typename Combine>
+    T reduce_vertex(const T& identity, Accumulate&& accumulate, Combine&& combine) const
+    {
+        return reduce_ids(vert_capacity(), identity, combine, [&](T& acc, size_t i) {
+            auto tup = tuple_from_vertex(i);
+            if (tup.is_valid(*this)) accumulate(acc, tup);
+        });
+    }
+    /**
+     * @brief reduce a value over the edges in parallel, each edge being visited once by the face
+     * that owns it, see reduce_face
+     */
+    template <typename T, typename Accumulate, typename Combine>
+    T reduce_edge(const T& identity, Accumulate&& accumulate, Combine&& combine) const
+    {
+        return reduce_ids(tri_capacity(), identity, combine, [&](T& acc, size_t i) {
+            if (!tuple_from_tri(i).is_valid(*this)) return;
+            for (int j = 0; j < 3; j++) {
+                auto tup = tuple_from_edge(i, j);
+                if (tup.eid(*this) == 3 * i + j) accumulate(acc, tup);
+            }
+        });
+    }
     int NUM_THREADS = 0;
+
+private:
+    template <typename T, typename Combine, typename AccumulateId>
+    T reduce_ids(size_t n, const T& identity, Combine& combine, AccumulateId&& accumulate) const
+    {
+        return ExecutionContext::instance().execute(
+            NUM_THREADS,
+            [&] { return reduce_in_order(n, identity, accumulate, combine); });
+    }
 };
 
 } // namespace wmtk
@@ -1,5 +1,11 @@
 #include <wmtk/TriMeshOperation.h>
+#include <wmtk/utils/Compaction.hpp>
 #include <wmtk/utils/VectorUtils.h>
+#include <wmtk/utils/partition_utils.hpp>
+
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/task_arena.h>
 using namespace wmtk;
 
 
@@ -23,6 +29,14 @@ auto TriMeshOperation::tri_connectivity(const TriMesh& m)
 {
     return m.m_tri_connectivity;
 }
+ElementCounter& TriMeshOperation::vertex_count(TriMesh& m)
+{
+    return m.m_vertex_count;
+}
+ElementCounter& TriMeshOperation::tri_count(TriMesh& m)
+{
+    return m.m_tri_count;
+}
 size_t TriMeshOperation::get_next_empty_slot_t(TriMesh& m)
 {
     return m.get_next_empty_slot_t();
@@ -35,36 +49,13 @@ size_t TriMeshOperation::get_next_empty_slot_v(TriMesh& m)
 
 auto TriMeshOperation::operator()(TriMesh& m, const Tuple& t) -> ExecuteReturnData
 {
-    ExecuteReturnData retdata;
-    retdata.success = false;
-
-    m.start_protected_connectivity();
-    m.start_protected_attributes();
-
-    retdata.success = before(m, t);
-    if (!retdata.success) {
-        goto finish;
-    }
-
-    retdata = execute(m, t);
-    if (!retdata.success) {
-        goto finish;
-    }
-
-    retdata.success = after(m, retdata) && invariants(m, retdata);
-    if (!retdata.success) {
-        goto finish;
-    }
-
-    //
-finish:
-    if (!retdata.success) {
-        m.rollback_protected();
-    }
-    m.release_protected_connectivity();
-    m.release_protected_attributes();
-
-    return retdata;
+    return run(
+        m,
+        t,
+        [&]() { return before(m, t); },
+        [&]() { return execute(m, t); },
+        [&](ExecuteReturnData& ret_data) { return after(m, ret_data); },
+        [&](ExecuteReturnData& ret_data) { return invariants(m, ret_data); });
 }
 
 bool TriMeshOperation::invariants(TriMesh& m, ExecuteReturnData& ret_data)
@@ -158,6 +149,7 @@ auto TriMeshSplitEdgeOperation::execute(TriMesh& m, const Tuple& t) -> ExecuteRe
 
     // new_vid
     vertex_connectivity[new_vid].m_is_removed = false;
+    vertex_count(m).stage(1);
     vertex_connectivity[new_vid].m_conn_tris.push_back(fid1);
     vertex_connectivity[new_vid].m_conn_tris.push_back(new_fid1);
     if (fid2.has_value()) {
@@ -183,6 +175,7 @@ auto TriMeshSplitEdgeOperation::execute(TriMesh& m, const Tuple& t) -> ExecuteRe
     tri_connectivity[new_fid1].m_indices[k] = fid1_vid3;
     tri_connectivity[new_fid1].hash++;
     tri_connectivity[new_fid1].m_is_removed = false;
+    tri_count(m).stage(1);
     if (fid2.has_value()) {
         j = tri_connectivity[fid2.value()].find(vid2);
         tri_connectivity[fid2.value()].m_indices[j] = new_vid;
@@ -195,6 +188,7 @@ auto TriMeshSplitEdgeOperation::execute(TriMesh& m, const Tuple& t) -> ExecuteRe
         tri_connectivity[new_fid2.value()].m_indices[k] = fid2_vid3.value();
         tri_connectivity[new_fid2.value()].hash++;
         tri_connectivity[new_fid2.value()].m_is_removed = false;
+        tri_count(m).stage(1);
     }
     // make the new tuple
     size_t new_fid = std::min(fid1, new_fid1);
@@ -424,6 +418,8 @@ auto TriMeshEdgeCollapseOperation::execute(TriMesh& m, const Tuple& loc0) -> Exe
     for (size_t fid : n12_intersect_fids) {
         tri_connectivity[fid].m_is_removed = true;
     }
+    vertex_count(m).stage(-2);
+    tri_count(m).stage(-long(n12_intersect_fids.size()));
 
     std::vector<size_t> n12_union_fids;
     std::set_union(
@@ -470,6 +466,7 @@ auto TriMeshEdgeCollapseOperation::execute(TriMesh& m, const Tuple& loc0) -> Exe
             vertex_connectivity[new_vid].m_conn_tris.push_back(fid);
     }
     vertex_connectivity[new_vid].m_is_removed = false;
+    vertex_count(m).stage(1);
     // This is sorting too, and it is important to sort
     vector_unique(vertex_connectivity[new_vid].m_conn_tris);
 
@@ -612,59 +609,106 @@ auto TriMeshConsolidateOperation::execute(TriMesh& m, const Tuple& t) -> Execute
     auto& vertex_con = vertex_connectivity(m);
     auto& tri_con = tri_connectivity(m);
 
-    auto v_cnt = 0;
-    std::vector<size_t> map_v_ids(m.vert_capacity(), -1);
-    for (auto i = 0; i < m.vert_capacity(); i++) {
-        if (vertex_con[i].m_is_removed) continue;
-        map_v_ids[i] = v_cnt;
-        v_cnt++;
-    }
-    auto t_cnt = 0;
-    std::vector<size_t> map_t_ids(m.tri_capacity(), -1);
-    for (auto i = 0; i < m.tri_capacity(); i++) {
-        if (tri_con[i].m_is_removed) continue;
-        map_t_ids[i] = t_cnt;
-        t_cnt++;
-    }
-    v_cnt = 0;
-    for (auto i = 0; i < m.vert_capacity(); i++) {
-        if (vertex_con[i].m_is_removed) continue;
-        if (v_cnt != i) {
-            assert(v_cnt < i);
-            vertex_con[v_cnt] = vertex_con[i];
-            if (m.p_vertex_attrs) m.p_vertex_attrs->move(i, v_cnt);
-        }
-        for (size_t& t_id : vertex_con[v_cnt].m_conn_tris) {
-            t_id = map_t_ids[t_id];
+    std::vector<size_t> map_v_ids, map_t_ids;
+    size_t v_cnt = 0, t_cnt = 0;
+
+    auto& arena = ExecutionContext::instance().arena(m.NUM_THREADS);
+    arena.execute([&] {
+        auto new2old_v = compact_ids(
+            m.vert_capacity(),
+            [&](size_t i) { return !vertex_con.at(i).m_is_removed; },
+            map_v_ids);
+        auto new2old_t = compact_ids(
+            m.tri_capacity(),
+            [&](size_t i) { return !tri_con.at(i).m_is_removed; },
+            map_t_ids);
+        v_cnt = new2old_v.size();
+        t_cnt = new2old_t.size();
+
+        if (vertex_position) {
+            sort_vertices_morton(new2old_v, vertex_position);
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, v_cnt),
+                [&](tbb::blocked_range<size_t> r) {
+                    for (auto i = r.begin(); i < r.end(); i++) map_v_ids[new2old_v[i]] = i;
+                });
+
+            // the triangles are sorted by their smallest new vid, then by their old fid
+            auto keys = std::vector<std::pair<size_t, size_t>>(t_cnt);
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, t_cnt),
+                [&](tbb::blocked_range<size_t> r) {
+                    for (auto i = r.begin(); i < r.end(); i++) {
+                        auto& tri = tri_con.at(new2old_t[i]);
+                        keys[i] = {map_v_ids[tri.m_indices[0]], new2old_t[i]};
+                        for (auto j = 1; j < 3; j++)
+                            keys[i].first = std::min(keys[i].first, map_v_ids[tri.m_indices[j]]);
+                    }
+                });
+            tbb::parallel_sort(keys.begin(), keys.end());
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, t_cnt),
+                [&](tbb::blocked_range<size_t> r) {
+                    for (auto i = r.begin(); i < r.end(); i++) {
+                        new2old_t[i] = keys[i].second;
+                        map_t_ids[new2old_t[i]] = i;
+                    }
+                });
         }
-        v_cnt++;
-    }
-    t_cnt = 0;
-    for (int i = 0; i < m.tri_capacity(); i++) {
-        if (tri_con[i].m_is_removed) continue;
-
-        if (t_cnt != i) {
-            assert(t_cnt < i);
-            tri_con[t_cnt] = tri_con[i];
-            tri_con[t_cnt].hash = 0;
-            if (m.p_face_attrs) {
-                m.p_face_attrs->move(i, t_cnt);
-            }
 
-            for (auto j = 0; j < 3; j++) {
-                if (m.p_edge_attrs) {
-                    m.p_edge_attrs->move(i * 3 + j, t_cnt * 3 + j);
+        vertex_con.consolidate(new2old_v, 1);
+        tri_con.consolidate(new2old_t, 1);
+        if (m.p_vertex_attrs) m.p_vertex_attrs->consolidate(new2old_v, 1);
+        if (m.p_face_attrs) m.p_face_attrs->consolidate(new2old_t, 1);
+
+        // the ids are remapped through m_attributes, which is not recorded for rollback, as in
+        // AttributeCollection::move
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, v_cnt),
+            [&](tbb::blocked_range<size_t> r) {
+                for (auto i = r.begin(); i < r.end(); i++) {
+                    auto& conn_tris = vertex_con.m_attributes[i].m_conn_tris;
+                    for (size_t& t_id : conn_tris) {
+                        t_id = map_t_ids[t_id];
+                    }
+                    // the reordering does not keep the fids sorted
+                    std::sort(conn_tris.begin(), conn_tris.end());
                 }
-            }
-        }
-        for (size_t& v_id : tri_con[t_cnt].m_indices) {
-            v_id = map_v_ids[v_id];
+            });
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, t_cnt),
+            [&](tbb::blocked_range<size_t> r) {
+                for (auto i = r.begin(); i < r.end(); i++) {
+                    auto& tri = tri_con.m_attributes[i];
+                    if (new2old_t[i] != i) tri.hash = 0;
+                    for (auto& v_id : tri.m_indices) {
+                        v_id = map_v_ids[v_id];
+                    }
+                }
+            });
+
+        // a shared edge lives in the slot of its incident triangle of smallest fid, so the blocks
+        // of the triangles only keep it in place when the triangles keep their order
+        if (!m.p_edge_attrs) return;
+        if (std::is_sorted(new2old_t.begin(), new2old_t.end())) {
+            m.p_edge_attrs->consolidate(new2old_t, 3);
+            return;
         }
-        t_cnt++;
-    }
+        const auto new2old_e =
+            shared_slots_new2old(new2old_t, 3, [&](size_t i, size_t j) -> std::optional<size_t> {
+                const auto t = m.tuple_from_edge(i, j);
+                const auto t_opp = m.switch_face(t);
+                if (t_opp && new2old_t[t_opp->fid(m)] < new2old_t[i]) return {};
+                return t.eid(m);
+            });
+        m.p_edge_attrs->consolidate(new2old_e, 1);
+    });
 
     set_vertex_size(m, v_cnt);
     set_tri_size(m, t_cnt);
+    vertex_count(m).reset(v_cnt);
+    tri_count(m).reset(t_cnt);
+    m.release_reserved_slots();
 
     // Resize user class attributes
     if (m.p_vertex_attrs) m.p_vertex_attrs->grow_to_at_least(m.vert_capacity());
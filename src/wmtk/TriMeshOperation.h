@@ -1,4 +1,5 @@
 #pragma once
+#include <wmtk/ExecutionTelemetry.hpp>
 #include <wmtk/TriMesh.h>
 #include <type_traits>
 
@@ -31,6 +32,48 @@ protected:
     virtual bool after(TriMesh& m, ExecuteReturnData& ret_data) = 0;
     virtual bool invariants(TriMesh& m, ExecuteReturnData& ret_data);
 
+    /**
+     * @brief The body of operator(), with the steps of the operation passed as callables so that
+     * TriMeshOperationShim can run the derived operation without virtual calls.
+     */
+    template <typename BeforeFunc, typename ExecuteFunc, typename AfterFunc, typename InvariantsFunc>
+    ExecuteReturnData run(
+        TriMesh& m,
+        const Tuple& t,
+        BeforeFunc&& before_func,
+        ExecuteFunc&& execute_func,
+        AfterFunc&& after_func,
+        InvariantsFunc&& invariants_func)
+    {
+        ExecuteReturnData retdata;
+        retdata.success = false;
+
+        auto phase_timer = OperationPhaseTimer(OperationPhase::kBefore);
+
+        m.start_protected_connectivity();
+        m.start_protected_attributes();
+
+        if (before_func()) {
+            phase_timer.start(OperationPhase::kExecute);
+            retdata = execute_func();
+            if (retdata.success) {
+                phase_timer.start(OperationPhase::kAfter);
+                retdata.success = after_func(retdata);
+                phase_timer.start(OperationPhase::kInvariants);
+                retdata.success = retdata.success && invariants_func(retdata);
+            }
+        }
+
+        phase_timer.start(retdata.success ? OperationPhase::kExecute : OperationPhase::kRollback);
+        if (!retdata.success) {
+            m.rollback_protected();
+        }
+        m.release_protected_connectivity();
+        m.release_protected_attributes();
+
+        return retdata;
+    }
+
 
     // forwarding of operations in TriMesh
     static wmtk::AttributeCollection<VertexConnectivity>& vertex_connectivity(TriMesh& m);
@@ -39,6 +82,11 @@ protected:
         const TriMesh& m);
     static const wmtk::AttributeCollection<TriangleConnectivity>& tri_connectivity(
         const TriMesh& m);
+    /**
+     * @brief the live-element counters, where the operations stage their changes
+     */
+    static ElementCounter& vertex_count(TriMesh& m);
+    static ElementCounter& tri_count(TriMesh& m);
 
     /**
      * @brief Get the next avaiblie global index for the triangle
@@ -88,6 +136,22 @@ public:
         return static_cast<const DerivedOperationType&>(*this);
     }
 
+    using BaseOperationType::operator();
+    /**
+     * @brief Runs the operation calling the methods of DerivedOperationType directly, this is
+     * what ExecutePass uses for the operations of its compile-time operation list.
+     */
+    ExecuteReturnData operator()(MeshType& m, const Tuple& t)
+    {
+        return this->run(
+            m,
+            t,
+            [&]() { return derived().before(m, t); },
+            [&]() { return derived().execute(m, t); },
+            [&](ExecuteReturnData& ret_data) { return derived().after(m, ret_data); },
+            [&](ExecuteReturnData& ret_data) { return derived().invariants(m, ret_data); });
+    }
+
     ExecuteReturnData execute(TriMesh& m, const Tuple& t) override
     {
         return execute( static_cast<MeshType&>(m), t);
@@ -211,6 +275,12 @@ public:
 class TriMeshConsolidateOperation : public TriMeshOperation
 {
 public:
+    /**
+     * @brief when set, the vertices and the triangles are renumbered along the Morton order of
+     * the vertex positions, see TriMesh::consolidate_mesh
+     */
+    std::function<Eigen::Vector3d(size_t)> vertex_position;
+
     ExecuteReturnData execute(TriMesh& m, const Tuple& t) override;
     bool before(TriMesh& m, const Tuple& t) override;
     bool after(TriMesh& m, ExecuteReturnData& ret_data) override;
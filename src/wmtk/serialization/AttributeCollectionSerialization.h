@@ -245,7 +245,7 @@ HighFive::CompoundType AttributeCollectionSerialization<T>::datatype()
 template <typename T>
 AttributeCollectionUpdate AttributeCollectionSerialization<T>::record_value_changes()
 {
-    const std::map<size_t, T>& rollback_list = attribute_collection.m_rollback_list.local();
+    const auto& rollback_list = attribute_collection.m_rollback_list.local();
     const size_t old_size = attribute_collection.m_rollback_size.local();
     const auto& attributes = attribute_collection.m_attributes;
     // const tbb::concurrent_vector<T>& attributes = attribute_collection.m_attributes;
@@ -258,7 +258,7 @@ AttributeCollectionUpdate AttributeCollectionSerialization<T>::record_value_chan
             rollback_list.begin(),
             rollback_list.end(),
             std::back_inserter(data),
-            [&attributes](const std::pair<const size_t, T>& pr) -> UpdateData {
+            [&attributes](const std::pair<size_t, T>& pr) -> UpdateData {
                 const auto& [index, old_value] = pr;
                 if (index < attributes.size()) {
                     const T& new_value = attributes[index];
@@ -283,7 +283,7 @@ AttributeCollectionUpdate AttributeCollectionSerialization<T>::record_value_chan
 template <typename T>
 AttributeCollectionUpdate AttributeCollectionSerialization<T>::record_entire_state()
 {
-    const std::map<size_t, T>& rollback_list = attribute_collection.m_rollback_list.local();
+    const auto& rollback_list = attribute_collection.m_rollback_list.local();
     const size_t old_size = attribute_collection.m_rollback_size.local();
     const auto& attributes = attribute_collection.m_attributes;
     // const tbb::concurrent_vector<T>& attributes = attribute_collection.m_attributes;
@@ -1,55 +1,194 @@
 #include "AMIPS.h"
 
-namespace wmtk {
+// clang-format off
+#include <wmtk/utils/DisableWarnings.hpp>
+#include <tbb/enumerable_thread_specific.h>
+#include <wmtk/utils/EnableWarnings.hpp>
+// clang-format on
 
+#include <cstdint>
+#include <cstring>
+#include <limits>
 
+#if defined(__GNUC__)
+#define WMTK_AMIPS_INLINE inline __attribute__((always_inline))
+// the batches are evaluated with the vector extensions of GCC and clang, one tet per lane
+#define WMTK_AMIPS_VECTORS
+// the vector types are only passed between inlined functions
+#pragma GCC diagnostic ignored "-Wpsabi"
+#else
+#define WMTK_AMIPS_INLINE inline
+#endif
 
-double AMIPS_energy(const std::array<double, 12>& T)
+// the batched and the scalar functions must round alike, so no multiply-add is fused, neither in
+// the AVX-512 clones (avx512f implies FMA) nor when the whole build targets a CPU with FMA. The
+// build compiles this file with -ffp-contract=off, clang also gets the pragma.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+
+// the batched kernels are also compiled for AVX-512 and AVX2, and the loader picks the version
+// the CPU supports
+#if defined(WMTK_AMIPS_VECTORS) && defined(__x86_64__) && defined(__linux__) && \
+    defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define WMTK_AMIPS_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+#endif
+#ifndef WMTK_AMIPS_TARGET_CLONES
+#define WMTK_AMIPS_TARGET_CLONES
+#endif
+
+namespace {
+using wmtk::AMIPS_BATCH_SIZE;
+
+tbb::enumerable_thread_specific<wmtk::AMIPSCounters> amips_p3_counters;
+
+template <typename Scalar>
+struct BitsOf
+{
+    using type = std::int64_t;
+};
+
+#ifdef WMTK_AMIPS_VECTORS
+using Lanes = double __attribute__((vector_size(sizeof(double) * AMIPS_BATCH_SIZE)));
+using LaneBits = std::int64_t __attribute__((vector_size(sizeof(double) * AMIPS_BATCH_SIZE)));
+template <>
+struct BitsOf<Lanes>
+{
+    using type = LaneBits;
+};
+
+WMTK_AMIPS_INLINE std::array<Lanes, 12> load(const wmtk::AMIPSBatch& batch)
+{
+    std::array<Lanes, 12> T;
+    for (int k = 0; k < 12; k++) std::memcpy(&T[k], batch.T[k].data(), sizeof(Lanes));
+    return T;
+}
+
+WMTK_AMIPS_INLINE void store(const Lanes& x, wmtk::AMIPSLanes& out)
+{
+    std::memcpy(out.data(), &x, sizeof(Lanes));
+}
+
+struct LaneMatrix
+{
+    std::array<Lanes, 9> v;
+    Lanes& operator()(int i, int j) { return v[3 * i + j]; }
+};
+#endif
+
+template <typename To, typename From>
+WMTK_AMIPS_INLINE To bit_cast(const From& x)
 {
-    double helper_0[12];
-    helper_0[0] = T[0];
-    helper_0[1] = T[1];
-    helper_0[2] = T[2];
-    helper_0[3] = T[3];
-    helper_0[4] = T[4];
-    helper_0[5] = T[5];
-    helper_0[6] = T[6];
-    helper_0[7] = T[7];
-    helper_0[8] = T[8];
-    helper_0[9] = T[9];
-    helper_0[10] = T[10];
-    helper_0[11] = T[11];
-    double helper_1 = helper_0[2];
-    double helper_2 = helper_0[11];
-    double helper_3 = helper_0[0];
-    double helper_4 = helper_0[3];
-    double helper_5 = helper_0[9];
-    double helper_6 =
+    static_assert(sizeof(To) == sizeof(From), "bit_cast between types of different sizes");
+    To y;
+    std::memcpy(&y, &x, sizeof(To));
+    return y;
+}
+
+// (d^2)^(-1/3) with arithmetic only, which vectorizes unlike std::pow: an estimate from the bits of
+// d^2, within 4%, refined by Newton iterations that double its number of correct digits, to 3 ulp
+template <typename Scalar>
+WMTK_AMIPS_INLINE Scalar inv_cbrt_sq(const Scalar& d)
+{
+    using Bits = typename BitsOf<Scalar>::type;
+    constexpr double small = 0x1p-900, big = 0x1p900;
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    const Scalar y = d * d;
+    // the estimate needs a normal double
+    const Scalar y_scaled = y * (y < small ? big : (y > big ? small : 1.));
+    Scalar r = bit_cast<Scalar>(std::int64_t(0x553ef0ff289dd796) - bit_cast<Bits>(y_scaled) / 3);
+    for (int i = 0; i < 4; i++) r = r * (4. - y_scaled * r * r * r) * (1. / 3);
+    r = r * (y < small ? 0x1p300 : (y > big ? 0x1p-300 : 1.));
+    r = y == 0. ? inf : r;
+    return y == inf ? 0. : r;
+}
+
+template <typename Scalar>
+WMTK_AMIPS_INLINE Scalar abs_value(const Scalar& x)
+{
+    return x < 0. ? -x : x;
+}
+
+// the energy of AMIPS_energy_p3_filtered, and whether its error is within the tolerance
+template <typename Scalar, typename Mask>
+WMTK_AMIPS_INLINE Scalar
+AMIPS_energy_p3_filtered_kernel(const std::array<Scalar, 12>& T, Mask& valid)
+{
+    constexpr double eps = std::numeric_limits<double>::epsilon() / 2; // the unit roundoff
+    // Shewchuk's bound of orient3d on the error of the determinant, relative to its permanent
+    constexpr double det_error_bound = (7 + 56 * eps) * eps;
+    // the 18 squares are each rounded 2 times, then summed with 17 roundings
+    constexpr double sq_error_bound = 20 * eps / (1 - 20 * eps);
+    constexpr double max_error = 1e-9;
+
+    std::array<Scalar, 3> a, b, c;
+    for (int d = 0; d < 3; d++) {
+        a[d] = T[3 + d] - T[d];
+        b[d] = T[6 + d] - T[d];
+        c[d] = T[9 + d] - T[d];
+    }
+    const Scalar det = a[0] * (b[1] * c[2] - b[2] * c[1]) + a[1] * (b[2] * c[0] - b[0] * c[2]) +
+                       a[2] * (b[0] * c[1] - b[1] * c[0]);
+    const Scalar permanent =
+        abs_value(a[0]) * (abs_value(b[1] * c[2]) + abs_value(b[2] * c[1])) +
+        abs_value(a[1]) * (abs_value(b[2] * c[0]) + abs_value(b[0] * c[2])) +
+        abs_value(a[2]) * (abs_value(b[0] * c[1]) + abs_value(b[1] * c[0]));
+    const Scalar det_error = det_error_bound * permanent;
+
+    Scalar sq = T[0] * 0.;
+    for (int i = 0; i < 4; i++)
+        for (int j = i + 1; j < 4; j++)
+            for (int d = 0; d < 3; d++) {
+                const Scalar e = T[3 * j + d] - T[3 * i + d];
+                sq = sq + e * e;
+            }
+
+    // the bounds do not hold with underflows, and the energy would overflow
+    const Scalar det_rel_error = det_error / (abs_value(det) - det_error);
+    // sq^3 / det^2, to the first order, and 6 more roundings
+    valid = sq > 1e-100 && sq < 1e100 && abs_value(det) > det_error &&
+            3 * sq_error_bound + 3 * det_rel_error + 8 * eps < max_error;
+    return sq * sq * sq / (16 * det * det);
+}
+
+// The generated kernels, templated on the scalar, which is a double or holds a tet per lane.
+
+template <typename Scalar>
+WMTK_AMIPS_INLINE Scalar AMIPS_energy_kernel(const std::array<Scalar, 12>& helper_0)
+{
+    Scalar helper_1 = helper_0[2];
+    Scalar helper_2 = helper_0[11];
+    Scalar helper_3 = helper_0[0];
+    Scalar helper_4 = helper_0[3];
+    Scalar helper_5 = helper_0[9];
+    Scalar helper_6 =
         0.577350269189626 * helper_3 - 1.15470053837925 * helper_4 + 0.577350269189626 * helper_5;
-    double helper_7 = helper_0[1];
-    double helper_8 = helper_0[4];
-    double helper_9 = helper_0[7];
-    double helper_10 = helper_0[10];
-    double helper_11 = 0.408248290463863 * helper_10 + 0.408248290463863 * helper_7 +
+    Scalar helper_7 = helper_0[1];
+    Scalar helper_8 = helper_0[4];
+    Scalar helper_9 = helper_0[7];
+    Scalar helper_10 = helper_0[10];
+    Scalar helper_11 = 0.408248290463863 * helper_10 + 0.408248290463863 * helper_7 +
                        0.408248290463863 * helper_8 - 1.22474487139159 * helper_9;
-    double helper_12 =
+    Scalar helper_12 =
         0.577350269189626 * helper_10 + 0.577350269189626 * helper_7 - 1.15470053837925 * helper_8;
-    double helper_13 = helper_0[6];
-    double helper_14 = -1.22474487139159 * helper_13 + 0.408248290463863 * helper_3 +
+    Scalar helper_13 = helper_0[6];
+    Scalar helper_14 = -1.22474487139159 * helper_13 + 0.408248290463863 * helper_3 +
                        0.408248290463863 * helper_4 + 0.408248290463863 * helper_5;
-    double helper_15 = helper_0[5];
-    double helper_16 = helper_0[8];
-    double helper_17 = 0.408248290463863 * helper_1 + 0.408248290463863 * helper_15 -
+    Scalar helper_15 = helper_0[5];
+    Scalar helper_16 = helper_0[8];
+    Scalar helper_17 = 0.408248290463863 * helper_1 + 0.408248290463863 * helper_15 -
                        1.22474487139159 * helper_16 + 0.408248290463863 * helper_2;
-    double helper_18 =
+    Scalar helper_18 =
         0.577350269189626 * helper_1 - 1.15470053837925 * helper_15 + 0.577350269189626 * helper_2;
-    double helper_19 = 0.5 * helper_13 + 0.5 * helper_4;
-    double helper_20 = 0.5 * helper_8 + 0.5 * helper_9;
-    double helper_21 = 0.5 * helper_15 + 0.5 * helper_16;
-    double helper_22 = (helper_1 - helper_2) * (helper_11 * helper_6 - helper_12 * helper_14) -
+    Scalar helper_19 = 0.5 * helper_13 + 0.5 * helper_4;
+    Scalar helper_20 = 0.5 * helper_8 + 0.5 * helper_9;
+    Scalar helper_21 = 0.5 * helper_15 + 0.5 * helper_16;
+    Scalar helper_22 = (helper_1 - helper_2) * (helper_11 * helper_6 - helper_12 * helper_14) -
                        (-helper_10 + helper_7) * (-helper_14 * helper_18 + helper_17 * helper_6) +
                        (helper_3 - helper_5) * (-helper_11 * helper_18 + helper_12 * helper_17);
-    double res =
+    Scalar res =
         -(helper_1 * (-1.5 * helper_1 + 0.5 * helper_2 + helper_21) +
           helper_10 * (-1.5 * helper_10 + helper_20 + 0.5 * helper_7) +
           helper_13 * (-1.5 * helper_13 + 0.5 * helper_3 + 0.5 * helper_4 + 0.5 * helper_5) +
@@ -61,81 +200,65 @@ double AMIPS_energy(const std::array<double, 12>& T)
           helper_5 * (helper_19 + 0.5 * helper_3 - 1.5 * helper_5) +
           helper_7 * (0.5 * helper_10 + helper_20 - 1.5 * helper_7) +
           helper_8 * (0.5 * helper_10 + 0.5 * helper_7 - 1.5 * helper_8 + 0.5 * helper_9) +
-          helper_9 * (0.5 * helper_10 + 0.5 * helper_7 + 0.5 * helper_8 - 1.5 * helper_9)) /
-        std::cbrt(helper_22 * helper_22);
-    //                 * pow(pow((helper_1 - helper_2) * (helper_11 * helper_6 - helper_12 *
-    //                 helper_14) -
-    //                         (-helper_10 + helper_7) * (-helper_14 * helper_18 + helper_17 *
-    //                         helper_6) + (helper_3 - helper_5) * (-helper_11 * helper_18 +
-    //                         helper_12 * helper_17), 2),
-    //                     -0.333333333333333);
+          helper_9 * (0.5 * helper_10 + 0.5 * helper_7 + 0.5 * helper_8 - 1.5 * helper_9)) *
+        inv_cbrt_sq(helper_22);
     return res;
 }
 
-void AMIPS_jacobian(const std::array<double, 12>& T, Eigen::Vector3d& result_0)
+template <typename Scalar, typename Result>
+WMTK_AMIPS_INLINE void AMIPS_jacobian_kernel(
+    const std::array<Scalar, 12>& helper_0,
+    Result& result_0)
 {
-    double helper_0[12];
-    helper_0[0] = T[0];
-    helper_0[1] = T[1];
-    helper_0[2] = T[2];
-    helper_0[3] = T[3];
-    helper_0[4] = T[4];
-    helper_0[5] = T[5];
-    helper_0[6] = T[6];
-    helper_0[7] = T[7];
-    helper_0[8] = T[8];
-    helper_0[9] = T[9];
-    helper_0[10] = T[10];
-    helper_0[11] = T[11];
-    double helper_1 = helper_0[1];
-    double helper_2 = helper_0[10];
-    double helper_3 = helper_1 - helper_2;
-    double helper_4 = helper_0[0];
-    double helper_5 = helper_0[3];
-    double helper_6 = helper_0[9];
-    double helper_7 =
+    Scalar helper_1 = helper_0[1];
+    Scalar helper_2 = helper_0[10];
+    Scalar helper_3 = helper_1 - helper_2;
+    Scalar helper_4 = helper_0[0];
+    Scalar helper_5 = helper_0[3];
+    Scalar helper_6 = helper_0[9];
+    Scalar helper_7 =
         0.577350269189626 * helper_4 - 1.15470053837925 * helper_5 + 0.577350269189626 * helper_6;
-    double helper_8 = helper_0[2];
-    double helper_9 = 0.408248290463863 * helper_8;
-    double helper_10 = helper_0[5];
-    double helper_11 = 0.408248290463863 * helper_10;
-    double helper_12 = helper_0[8];
-    double helper_13 = 1.22474487139159 * helper_12;
-    double helper_14 = helper_0[11];
-    double helper_15 = 0.408248290463863 * helper_14;
-    double helper_16 = helper_11 - helper_13 + helper_15 + helper_9;
-    double helper_17 = 0.577350269189626 * helper_8;
-    double helper_18 = 1.15470053837925 * helper_10;
-    double helper_19 = 0.577350269189626 * helper_14;
-    double helper_20 = helper_17 - helper_18 + helper_19;
-    double helper_21 = helper_0[6];
-    double helper_22 = -1.22474487139159 * helper_21 + 0.408248290463863 * helper_4 +
+    Scalar helper_8 = helper_0[2];
+    Scalar helper_9 = 0.408248290463863 * helper_8;
+    Scalar helper_10 = helper_0[5];
+    Scalar helper_11 = 0.408248290463863 * helper_10;
+    Scalar helper_12 = helper_0[8];
+    Scalar helper_13 = 1.22474487139159 * helper_12;
+    Scalar helper_14 = helper_0[11];
+    Scalar helper_15 = 0.408248290463863 * helper_14;
+    Scalar helper_16 = helper_11 - helper_13 + helper_15 + helper_9;
+    Scalar helper_17 = 0.577350269189626 * helper_8;
+    Scalar helper_18 = 1.15470053837925 * helper_10;
+    Scalar helper_19 = 0.577350269189626 * helper_14;
+    Scalar helper_20 = helper_17 - helper_18 + helper_19;
+    Scalar helper_21 = helper_0[6];
+    Scalar helper_22 = -1.22474487139159 * helper_21 + 0.408248290463863 * helper_4 +
                        0.408248290463863 * helper_5 + 0.408248290463863 * helper_6;
-    double helper_23 = helper_16 * helper_7 - helper_20 * helper_22;
-    double helper_24 = -helper_14 + helper_8;
-    double helper_25 = 0.408248290463863 * helper_1;
-    double helper_26 = helper_0[4];
-    double helper_27 = 0.408248290463863 * helper_26;
-    double helper_28 = helper_0[7];
-    double helper_29 = 1.22474487139159 * helper_28;
-    double helper_30 = 0.408248290463863 * helper_2;
-    double helper_31 = helper_25 + helper_27 - helper_29 + helper_30;
-    double helper_32 = helper_31 * helper_7;
-    double helper_33 = 0.577350269189626 * helper_1;
-    double helper_34 = 1.15470053837925 * helper_26;
-    double helper_35 = 0.577350269189626 * helper_2;
-    double helper_36 = helper_33 - helper_34 + helper_35;
-    double helper_37 = helper_22 * helper_36;
-    double helper_38 = helper_4 - helper_6;
-    double helper_39 = helper_23 * helper_3 - helper_24 * (helper_32 - helper_37) -
+    Scalar helper_23 = helper_16 * helper_7 - helper_20 * helper_22;
+    Scalar helper_24 = -helper_14 + helper_8;
+    Scalar helper_25 = 0.408248290463863 * helper_1;
+    Scalar helper_26 = helper_0[4];
+    Scalar helper_27 = 0.408248290463863 * helper_26;
+    Scalar helper_28 = helper_0[7];
+    Scalar helper_29 = 1.22474487139159 * helper_28;
+    Scalar helper_30 = 0.408248290463863 * helper_2;
+    Scalar helper_31 = helper_25 + helper_27 - helper_29 + helper_30;
+    Scalar helper_32 = helper_31 * helper_7;
+    Scalar helper_33 = 0.577350269189626 * helper_1;
+    Scalar helper_34 = 1.15470053837925 * helper_26;
+    Scalar helper_35 = 0.577350269189626 * helper_2;
+    Scalar helper_36 = helper_33 - helper_34 + helper_35;
+    Scalar helper_37 = helper_22 * helper_36;
+    Scalar helper_38 = helper_4 - helper_6;
+    Scalar helper_39 = helper_23 * helper_3 - helper_24 * (helper_32 - helper_37) -
                        helper_38 * (helper_16 * helper_36 - helper_20 * helper_31);
-    double helper_40 = pow(pow(helper_39, 2), -0.333333333333333);
-    double helper_41 = 0.707106781186548 * helper_10 - 0.707106781186548 * helper_12;
-    double helper_42 = 0.707106781186548 * helper_26 - 0.707106781186548 * helper_28;
-    double helper_43 = 0.5 * helper_21 + 0.5 * helper_5;
-    double helper_44 = 0.5 * helper_26 + 0.5 * helper_28;
-    double helper_45 = 0.5 * helper_10 + 0.5 * helper_12;
-    double helper_46 =
+    Scalar helper_40 = inv_cbrt_sq(helper_39);
+    Scalar helper_41 = 0.707106781186548 * helper_10 - 0.707106781186548 * helper_12;
+    Scalar helper_42 = 0.707106781186548 * helper_26 - 0.707106781186548 * helper_28;
+    Scalar helper_43 = 0.5 * helper_21 + 0.5 * helper_5;
+    Scalar helper_44 = 0.5 * helper_26 + 0.5 * helper_28;
+    Scalar helper_45 = 0.5 * helper_10 + 0.5 * helper_12;
+    Scalar helper_46 =
         0.666666666666667 *
         (helper_1 * (-1.5 * helper_1 + 0.5 * helper_2 + helper_44) +
          helper_10 * (-1.5 * helper_10 + 0.5 * helper_12 + 0.5 * helper_14 + 0.5 * helper_8) +
@@ -150,7 +273,7 @@ void AMIPS_jacobian(const std::array<double, 12>& T, Eigen::Vector3d& result_0)
          helper_6 * (0.5 * helper_4 + helper_43 - 1.5 * helper_6) +
          helper_8 * (0.5 * helper_14 + helper_45 - 1.5 * helper_8)) /
         helper_39;
-    double helper_47 = -0.707106781186548 * helper_21 + 0.707106781186548 * helper_5;
+    Scalar helper_47 = -0.707106781186548 * helper_21 + 0.707106781186548 * helper_5;
     result_0[0] = -helper_40 * (1.0 * helper_21 - 3.0 * helper_4 +
                                 helper_46 * (helper_41 * (-helper_1 + helper_2) -
                                              helper_42 * (helper_14 - helper_8) -
@@ -169,135 +292,125 @@ void AMIPS_jacobian(const std::array<double, 12>& T, Eigen::Vector3d& result_0)
          3.0 * helper_8);
 }
 
-void AMIPS_hessian(const std::array<double, 12>& T, Eigen::Matrix3d& result_0)
+template <typename Scalar, typename Result>
+WMTK_AMIPS_INLINE void AMIPS_hessian_kernel(
+    const std::array<Scalar, 12>& helper_0,
+    Result& result_0)
 {
-    double helper_0[12];
-    helper_0[0] = T[0];
-    helper_0[1] = T[1];
-    helper_0[2] = T[2];
-    helper_0[3] = T[3];
-    helper_0[4] = T[4];
-    helper_0[5] = T[5];
-    helper_0[6] = T[6];
-    helper_0[7] = T[7];
-    helper_0[8] = T[8];
-    helper_0[9] = T[9];
-    helper_0[10] = T[10];
-    helper_0[11] = T[11];
-    double helper_1 = helper_0[2];
-    double helper_2 = helper_0[11];
-    double helper_3 = helper_1 - helper_2;
-    double helper_4 = helper_0[0];
-    double helper_5 = 0.577350269189626 * helper_4;
-    double helper_6 = helper_0[3];
-    double helper_7 = 1.15470053837925 * helper_6;
-    double helper_8 = helper_0[9];
-    double helper_9 = 0.577350269189626 * helper_8;
-    double helper_10 = helper_5 - helper_7 + helper_9;
-    double helper_11 = helper_0[1];
-    double helper_12 = 0.408248290463863 * helper_11;
-    double helper_13 = helper_0[4];
-    double helper_14 = 0.408248290463863 * helper_13;
-    double helper_15 = helper_0[7];
-    double helper_16 = 1.22474487139159 * helper_15;
-    double helper_17 = helper_0[10];
-    double helper_18 = 0.408248290463863 * helper_17;
-    double helper_19 = helper_12 + helper_14 - helper_16 + helper_18;
-    double helper_20 = helper_10 * helper_19;
-    double helper_21 = 0.577350269189626 * helper_11;
-    double helper_22 = 1.15470053837925 * helper_13;
-    double helper_23 = 0.577350269189626 * helper_17;
-    double helper_24 = helper_21 - helper_22 + helper_23;
-    double helper_25 = 0.408248290463863 * helper_4;
-    double helper_26 = 0.408248290463863 * helper_6;
-    double helper_27 = helper_0[6];
-    double helper_28 = 1.22474487139159 * helper_27;
-    double helper_29 = 0.408248290463863 * helper_8;
-    double helper_30 = helper_25 + helper_26 - helper_28 + helper_29;
-    double helper_31 = helper_24 * helper_30;
-    double helper_32 = helper_3 * (helper_20 - helper_31);
-    double helper_33 = helper_4 - helper_8;
-    double helper_34 = 0.408248290463863 * helper_1;
-    double helper_35 = helper_0[5];
-    double helper_36 = 0.408248290463863 * helper_35;
-    double helper_37 = helper_0[8];
-    double helper_38 = 1.22474487139159 * helper_37;
-    double helper_39 = 0.408248290463863 * helper_2;
-    double helper_40 = helper_34 + helper_36 - helper_38 + helper_39;
-    double helper_41 = helper_24 * helper_40;
-    double helper_42 = 0.577350269189626 * helper_1;
-    double helper_43 = 1.15470053837925 * helper_35;
-    double helper_44 = 0.577350269189626 * helper_2;
-    double helper_45 = helper_42 - helper_43 + helper_44;
-    double helper_46 = helper_19 * helper_45;
-    double helper_47 = helper_41 - helper_46;
-    double helper_48 = helper_33 * helper_47;
-    double helper_49 = helper_11 - helper_17;
-    double helper_50 = helper_10 * helper_40;
-    double helper_51 = helper_30 * helper_45;
-    double helper_52 = helper_50 - helper_51;
-    double helper_53 = helper_49 * helper_52;
-    double helper_54 = helper_32 + helper_48 - helper_53;
-    double helper_55 = pow(helper_54, 2);
-    double helper_56 = pow(helper_55, -0.333333333333333);
-    double helper_57 = 1.0 * helper_27 - 3.0 * helper_4 + 1.0 * helper_6 + 1.0 * helper_8;
-    double helper_58 = 0.707106781186548 * helper_13;
-    double helper_59 = 0.707106781186548 * helper_15;
-    double helper_60 = helper_58 - helper_59;
-    double helper_61 = helper_3 * helper_60;
-    double helper_62 = 0.707106781186548 * helper_35 - 0.707106781186548 * helper_37;
-    double helper_63 = helper_49 * helper_62;
-    double helper_64 = helper_47 + helper_61 - helper_63;
-    double helper_65 = 1.33333333333333 / helper_54;
-    double helper_66 = 1.0 / helper_55;
-    double helper_67 = 0.5 * helper_27 + 0.5 * helper_6;
-    double helper_68 = -1.5 * helper_4 + helper_67 + 0.5 * helper_8;
-    double helper_69 = 0.5 * helper_4 + helper_67 - 1.5 * helper_8;
-    double helper_70 = -1.5 * helper_27 + 0.5 * helper_4 + 0.5 * helper_6 + 0.5 * helper_8;
-    double helper_71 = 0.5 * helper_27 + 0.5 * helper_4 - 1.5 * helper_6 + 0.5 * helper_8;
-    double helper_72 = 0.5 * helper_13 + 0.5 * helper_15;
-    double helper_73 = -1.5 * helper_11 + 0.5 * helper_17 + helper_72;
-    double helper_74 = 0.5 * helper_11 - 1.5 * helper_17 + helper_72;
-    double helper_75 = 0.5 * helper_11 + 0.5 * helper_13 - 1.5 * helper_15 + 0.5 * helper_17;
-    double helper_76 = 0.5 * helper_11 - 1.5 * helper_13 + 0.5 * helper_15 + 0.5 * helper_17;
-    double helper_77 = 0.5 * helper_35 + 0.5 * helper_37;
-    double helper_78 = -1.5 * helper_1 + 0.5 * helper_2 + helper_77;
-    double helper_79 = 0.5 * helper_1 - 1.5 * helper_2 + helper_77;
-    double helper_80 = 0.5 * helper_1 + 0.5 * helper_2 + 0.5 * helper_35 - 1.5 * helper_37;
-    double helper_81 = 0.5 * helper_1 + 0.5 * helper_2 - 1.5 * helper_35 + 0.5 * helper_37;
-    double helper_82 = helper_1 * helper_78 + helper_11 * helper_73 + helper_13 * helper_76 +
+    Scalar helper_1 = helper_0[2];
+    Scalar helper_2 = helper_0[11];
+    Scalar helper_3 = helper_1 - helper_2;
+    Scalar helper_4 = helper_0[0];
+    Scalar helper_5 = 0.577350269189626 * helper_4;
+    Scalar helper_6 = helper_0[3];
+    Scalar helper_7 = 1.15470053837925 * helper_6;
+    Scalar helper_8 = helper_0[9];
+    Scalar helper_9 = 0.577350269189626 * helper_8;
+    Scalar helper_10 = helper_5 - helper_7 + helper_9;
+    Scalar helper_11 = helper_0[1];
+    Scalar helper_12 = 0.408248290463863 * helper_11;
+    Scalar helper_13 = helper_0[4];
+    Scalar helper_14 = 0.408248290463863 * helper_13;
+    Scalar helper_15 = helper_0[7];
+    Scalar helper_16 = 1.22474487139159 * helper_15;
+    Scalar helper_17 = helper_0[10];
+    Scalar helper_18 = 0.408248290463863 * helper_17;
+    Scalar helper_19 = helper_12 + helper_14 - helper_16 + helper_18;
+    Scalar helper_20 = helper_10 * helper_19;
+    Scalar helper_21 = 0.577350269189626 * helper_11;
+    Scalar helper_22 = 1.15470053837925 * helper_13;
+    Scalar helper_23 = 0.577350269189626 * helper_17;
+    Scalar helper_24 = helper_21 - helper_22 + helper_23;
+    Scalar helper_25 = 0.408248290463863 * helper_4;
+    Scalar helper_26 = 0.408248290463863 * helper_6;
+    Scalar helper_27 = helper_0[6];
+    Scalar helper_28 = 1.22474487139159 * helper_27;
+    Scalar helper_29 = 0.408248290463863 * helper_8;
+    Scalar helper_30 = helper_25 + helper_26 - helper_28 + helper_29;
+    Scalar helper_31 = helper_24 * helper_30;
+    Scalar helper_32 = helper_3 * (helper_20 - helper_31);
+    Scalar helper_33 = helper_4 - helper_8;
+    Scalar helper_34 = 0.408248290463863 * helper_1;
+    Scalar helper_35 = helper_0[5];
+    Scalar helper_36 = 0.408248290463863 * helper_35;
+    Scalar helper_37 = helper_0[8];
+    Scalar helper_38 = 1.22474487139159 * helper_37;
+    Scalar helper_39 = 0.408248290463863 * helper_2;
+    Scalar helper_40 = helper_34 + helper_36 - helper_38 + helper_39;
+    Scalar helper_41 = helper_24 * helper_40;
+    Scalar helper_42 = 0.577350269189626 * helper_1;
+    Scalar helper_43 = 1.15470053837925 * helper_35;
+    Scalar helper_44 = 0.577350269189626 * helper_2;
+    Scalar helper_45 = helper_42 - helper_43 + helper_44;
+    Scalar helper_46 = helper_19 * helper_45;
+    Scalar helper_47 = helper_41 - helper_46;
+    Scalar helper_48 = helper_33 * helper_47;
+    Scalar helper_49 = helper_11 - helper_17;
+    Scalar helper_50 = helper_10 * helper_40;
+    Scalar helper_51 = helper_30 * helper_45;
+    Scalar helper_52 = helper_50 - helper_51;
+    Scalar helper_53 = helper_49 * helper_52;
+    Scalar helper_54 = helper_32 + helper_48 - helper_53;
+    Scalar helper_55 = helper_54 * helper_54;
+    Scalar helper_56 = inv_cbrt_sq(helper_54);
+    Scalar helper_57 = 1.0 * helper_27 - 3.0 * helper_4 + 1.0 * helper_6 + 1.0 * helper_8;
+    Scalar helper_58 = 0.707106781186548 * helper_13;
+    Scalar helper_59 = 0.707106781186548 * helper_15;
+    Scalar helper_60 = helper_58 - helper_59;
+    Scalar helper_61 = helper_3 * helper_60;
+    Scalar helper_62 = 0.707106781186548 * helper_35 - 0.707106781186548 * helper_37;
+    Scalar helper_63 = helper_49 * helper_62;
+    Scalar helper_64 = helper_47 + helper_61 - helper_63;
+    Scalar helper_65 = 1.33333333333333 / helper_54;
+    Scalar helper_66 = 1.0 / helper_55;
+    Scalar helper_67 = 0.5 * helper_27 + 0.5 * helper_6;
+    Scalar helper_68 = -1.5 * helper_4 + helper_67 + 0.5 * helper_8;
+    Scalar helper_69 = 0.5 * helper_4 + helper_67 - 1.5 * helper_8;
+    Scalar helper_70 = -1.5 * helper_27 + 0.5 * helper_4 + 0.5 * helper_6 + 0.5 * helper_8;
+    Scalar helper_71 = 0.5 * helper_27 + 0.5 * helper_4 - 1.5 * helper_6 + 0.5 * helper_8;
+    Scalar helper_72 = 0.5 * helper_13 + 0.5 * helper_15;
+    Scalar helper_73 = -1.5 * helper_11 + 0.5 * helper_17 + helper_72;
+    Scalar helper_74 = 0.5 * helper_11 - 1.5 * helper_17 + helper_72;
+    Scalar helper_75 = 0.5 * helper_11 + 0.5 * helper_13 - 1.5 * helper_15 + 0.5 * helper_17;
+    Scalar helper_76 = 0.5 * helper_11 - 1.5 * helper_13 + 0.5 * helper_15 + 0.5 * helper_17;
+    Scalar helper_77 = 0.5 * helper_35 + 0.5 * helper_37;
+    Scalar helper_78 = -1.5 * helper_1 + 0.5 * helper_2 + helper_77;
+    Scalar helper_79 = 0.5 * helper_1 - 1.5 * helper_2 + helper_77;
+    Scalar helper_80 = 0.5 * helper_1 + 0.5 * helper_2 + 0.5 * helper_35 - 1.5 * helper_37;
+    Scalar helper_81 = 0.5 * helper_1 + 0.5 * helper_2 - 1.5 * helper_35 + 0.5 * helper_37;
+    Scalar helper_82 = helper_1 * helper_78 + helper_11 * helper_73 + helper_13 * helper_76 +
                        helper_15 * helper_75 + helper_17 * helper_74 + helper_2 * helper_79 +
                        helper_27 * helper_70 + helper_35 * helper_81 + helper_37 * helper_80 +
                        helper_4 * helper_68 + helper_6 * helper_71 + helper_69 * helper_8;
-    double helper_83 = 0.444444444444444 * helper_66 * helper_82;
-    double helper_84 = helper_66 * helper_82;
-    double helper_85 = -helper_32 - helper_48 + helper_53;
-    double helper_86 = 1.0 / helper_85;
-    double helper_87 = helper_86 * pow(pow(helper_85, 2), -0.333333333333333);
-    double helper_88 = 0.707106781186548 * helper_6;
-    double helper_89 = 0.707106781186548 * helper_27;
-    double helper_90 = helper_88 - helper_89;
-    double helper_91 =
+    Scalar helper_83 = 0.444444444444444 * helper_66 * helper_82;
+    Scalar helper_84 = helper_66 * helper_82;
+    Scalar helper_85 = -helper_32 - helper_48 + helper_53;
+    Scalar helper_86 = 1.0 / helper_85;
+    Scalar helper_87 = helper_86 * inv_cbrt_sq(helper_85);
+    Scalar helper_88 = 0.707106781186548 * helper_6;
+    Scalar helper_89 = 0.707106781186548 * helper_27;
+    Scalar helper_90 = helper_88 - helper_89;
+    Scalar helper_91 =
         0.666666666666667 * helper_10 * helper_40 + 0.666666666666667 * helper_3 * helper_90 -
         0.666666666666667 * helper_30 * helper_45 - 0.666666666666667 * helper_33 * helper_62;
-    double helper_92 = -3.0 * helper_11 + 1.0 * helper_13 + 1.0 * helper_15 + 1.0 * helper_17;
-    double helper_93 = -helper_11 + helper_17;
-    double helper_94 = -helper_1 + helper_2;
-    double helper_95 = -helper_21 + helper_22 - helper_23;
-    double helper_96 = -helper_34 - helper_36 + helper_38 - helper_39;
-    double helper_97 = -helper_42 + helper_43 - helper_44;
-    double helper_98 = -helper_12 - helper_14 + helper_16 - helper_18;
-    double helper_99 =
+    Scalar helper_92 = -3.0 * helper_11 + 1.0 * helper_13 + 1.0 * helper_15 + 1.0 * helper_17;
+    Scalar helper_93 = -helper_11 + helper_17;
+    Scalar helper_94 = -helper_1 + helper_2;
+    Scalar helper_95 = -helper_21 + helper_22 - helper_23;
+    Scalar helper_96 = -helper_34 - helper_36 + helper_38 - helper_39;
+    Scalar helper_97 = -helper_42 + helper_43 - helper_44;
+    Scalar helper_98 = -helper_12 - helper_14 + helper_16 - helper_18;
+    Scalar helper_99 =
         -0.666666666666667 * helper_60 * helper_94 + 0.666666666666667 * helper_62 * helper_93 +
         0.666666666666667 * helper_95 * helper_96 - 0.666666666666667 * helper_97 * helper_98;
-    double helper_100 = helper_3 * helper_90;
-    double helper_101 = helper_33 * helper_62;
-    double helper_102 = helper_100 - helper_101 + helper_52;
-    double helper_103 = -helper_60 * helper_94 + helper_62 * helper_93 + helper_95 * helper_96 -
+    Scalar helper_100 = helper_3 * helper_90;
+    Scalar helper_101 = helper_33 * helper_62;
+    Scalar helper_102 = helper_100 - helper_101 + helper_52;
+    Scalar helper_103 = -helper_60 * helper_94 + helper_62 * helper_93 + helper_95 * helper_96 -
                         helper_97 * helper_98;
-    double helper_104 = 0.444444444444444 * helper_102 * helper_103 * helper_82 * helper_86 +
+    Scalar helper_104 = 0.444444444444444 * helper_102 * helper_103 * helper_82 * helper_86 +
                         helper_57 * helper_91 - helper_92 * helper_99;
-    double helper_105 =
+    Scalar helper_105 =
         1.85037170770859e-17 * helper_1 * helper_78 + 1.85037170770859e-17 * helper_11 * helper_73 +
         1.85037170770859e-17 * helper_13 * helper_76 +
         1.85037170770859e-17 * helper_15 * helper_75 +
@@ -306,28 +419,28 @@ void AMIPS_hessian(const std::array<double, 12>& T, Eigen::Matrix3d& result_0)
         1.85037170770859e-17 * helper_35 * helper_81 +
         1.85037170770859e-17 * helper_37 * helper_80 + 1.85037170770859e-17 * helper_4 * helper_68 +
         1.85037170770859e-17 * helper_6 * helper_71 + 1.85037170770859e-17 * helper_69 * helper_8;
-    double helper_106 = helper_64 * helper_82 * helper_86;
-    double helper_107 =
+    Scalar helper_106 = helper_64 * helper_82 * helper_86;
+    Scalar helper_107 =
         -0.666666666666667 * helper_10 * helper_19 + 0.666666666666667 * helper_24 * helper_30 +
         0.666666666666667 * helper_33 * helper_60 - 0.666666666666667 * helper_49 * helper_90;
-    double helper_108 = -3.0 * helper_1 + 1.0 * helper_2 + 1.0 * helper_35 + 1.0 * helper_37;
-    double helper_109 = -helper_20 + helper_31 + helper_33 * helper_60 - helper_49 * helper_90;
-    double helper_110 = 0.444444444444444 * helper_109 * helper_82 * helper_86;
-    double helper_111 = helper_103 * helper_110 + helper_107 * helper_57 - helper_108 * helper_99;
-    double helper_112 = -helper_4 + helper_8;
-    double helper_113 = -helper_88 + helper_89;
-    double helper_114 = -helper_5 + helper_7 - helper_9;
-    double helper_115 = -helper_25 - helper_26 + helper_28 - helper_29;
-    double helper_116 = helper_82 * helper_86 *
+    Scalar helper_108 = -3.0 * helper_1 + 1.0 * helper_2 + 1.0 * helper_35 + 1.0 * helper_37;
+    Scalar helper_109 = -helper_20 + helper_31 + helper_33 * helper_60 - helper_49 * helper_90;
+    Scalar helper_110 = 0.444444444444444 * helper_109 * helper_82 * helper_86;
+    Scalar helper_111 = helper_103 * helper_110 + helper_107 * helper_57 - helper_108 * helper_99;
+    Scalar helper_112 = -helper_4 + helper_8;
+    Scalar helper_113 = -helper_88 + helper_89;
+    Scalar helper_114 = -helper_5 + helper_7 - helper_9;
+    Scalar helper_115 = -helper_25 - helper_26 + helper_28 - helper_29;
+    Scalar helper_116 = helper_82 * helper_86 *
                         (helper_112 * helper_62 + helper_113 * helper_94 + helper_114 * helper_96 -
                          helper_115 * helper_97);
-    double helper_117 = -helper_100 + helper_101 - helper_50 + helper_51;
-    double helper_118 = -helper_102 * helper_110 + helper_107 * helper_92 + helper_108 * helper_91;
-    double helper_119 = helper_82 * helper_86 *
+    Scalar helper_117 = -helper_100 + helper_101 - helper_50 + helper_51;
+    Scalar helper_118 = -helper_102 * helper_110 + helper_107 * helper_92 + helper_108 * helper_91;
+    Scalar helper_119 = helper_82 * helper_86 *
                         (helper_112 * (-helper_58 + helper_59) - helper_113 * helper_93 -
                          helper_114 * helper_98 + helper_115 * helper_95);
     result_0(0, 0) =
-        helper_56 * (helper_57 * helper_64 * helper_65 - pow(helper_64, 2) * helper_83 +
+        helper_56 * (helper_57 * helper_64 * helper_65 - (helper_64 * helper_64) * helper_83 +
                      0.666666666666667 * helper_64 * helper_84 *
                          (-helper_41 + helper_46 - helper_61 + helper_63) +
                      3.0);
@@ -335,14 +448,123 @@ void AMIPS_hessian(const std::array<double, 12>& T, Eigen::Matrix3d& result_0)
     result_0(0, 2) = helper_87 * (helper_106 * helper_107 + helper_111);
     result_0(1, 0) = helper_87 * (helper_104 + helper_116 * helper_99);
     result_0(1, 1) =
-        helper_56 * (-pow(helper_117, 2) * helper_83 + helper_117 * helper_65 * helper_92 +
+        helper_56 * (-(helper_117 * helper_117) * helper_83 + helper_117 * helper_65 * helper_92 +
                      helper_117 * helper_84 * helper_91 + 3.0);
     result_0(1, 2) = helper_87 * (-helper_105 * helper_6 - helper_107 * helper_116 + helper_118);
     result_0(2, 0) = helper_87 * (-helper_105 * helper_13 + helper_111 + helper_119 * helper_99);
     result_0(2, 1) = helper_87 * (helper_118 - helper_119 * helper_91);
     result_0(2, 2) = helper_56 * (-helper_108 * helper_109 * helper_65 -
-                                  1.11111111111111 * pow(helper_109, 2) * helper_84 + 3.0);
+                                  1.11111111111111 * (helper_109 * helper_109) * helper_84 + 3.0);
 }
+} // namespace
 
+namespace wmtk {
+
+double AMIPS_energy(const std::array<double, 12>& T)
+{
+    return AMIPS_energy_kernel(T);
+}
+
+void AMIPS_jacobian(const std::array<double, 12>& T, Eigen::Vector3d& result_0)
+{
+    AMIPS_jacobian_kernel(T, result_0);
+}
+
+void AMIPS_hessian(const std::array<double, 12>& T, Eigen::Matrix3d& result_0)
+{
+    AMIPS_hessian_kernel(T, result_0);
+}
+
+std::optional<double> AMIPS_energy_p3_filtered(const std::array<double, 12>& T)
+{
+    // the local counters of a thread are never destroyed, only reset
+    static thread_local AMIPSCounters& counters = amips_p3_counters.local();
+    counters.num_evaluations++;
+
+    bool valid = false;
+    const double energy = AMIPS_energy_p3_filtered_kernel(T, valid);
+    if (valid) return energy;
+    counters.num_escalations++;
+    return {};
+}
+
+WMTK_AMIPS_TARGET_CLONES
+void AMIPS_energy_batch(const AMIPSBatch& batch, AMIPSLanes& energy)
+{
+#ifdef WMTK_AMIPS_VECTORS
+    store(AMIPS_energy_kernel(load(batch)), energy);
+#else
+    for (int i = 0; i < AMIPS_BATCH_SIZE; i++) energy[i] = AMIPS_energy(batch.tet(i));
+#endif
+}
+
+WMTK_AMIPS_TARGET_CLONES
+void AMIPS_jacobian_batch(const AMIPSBatch& batch, std::array<AMIPSLanes, 3>& jacobian)
+{
+#ifdef WMTK_AMIPS_VECTORS
+    std::array<Lanes, 3> result;
+    AMIPS_jacobian_kernel(load(batch), result);
+    for (int k = 0; k < 3; k++) store(result[k], jacobian[k]);
+#else
+    for (int i = 0; i < AMIPS_BATCH_SIZE; i++) {
+        Eigen::Vector3d J;
+        AMIPS_jacobian(batch.tet(i), J);
+        for (int k = 0; k < 3; k++) jacobian[k][i] = J[k];
+    }
+#endif
+}
+
+WMTK_AMIPS_TARGET_CLONES
+void AMIPS_hessian_batch(const AMIPSBatch& batch, std::array<AMIPSLanes, 9>& hessian)
+{
+#ifdef WMTK_AMIPS_VECTORS
+    LaneMatrix result;
+    AMIPS_hessian_kernel(load(batch), result);
+    for (int k = 0; k < 9; k++) store(result.v[k], hessian[k]);
+#else
+    for (int i = 0; i < AMIPS_BATCH_SIZE; i++) {
+        Eigen::Matrix3d H;
+        AMIPS_hessian(batch.tet(i), H);
+        for (int k = 0; k < 9; k++) hessian[k][i] = H(k / 3, k % 3);
+    }
+#endif
+}
+
+WMTK_AMIPS_TARGET_CLONES
+int AMIPS_energy_p3_filtered_batch(const AMIPSBatch& batch, AMIPSLanes& energy)
+{
+    int escalated = 0;
+#ifdef WMTK_AMIPS_VECTORS
+    LaneBits valid;
+    store(AMIPS_energy_p3_filtered_kernel(load(batch), valid), energy);
+    for (int i = 0; i < batch.size; i++)
+        if (!valid[i]) escalated |= 1 << i;
+#else
+    for (int i = 0; i < batch.size; i++) {
+        bool valid = false;
+        energy[i] = AMIPS_energy_p3_filtered_kernel(batch.tet(i), valid);
+        if (!valid) escalated |= 1 << i;
+    }
+#endif
+    static thread_local AMIPSCounters& counters = amips_p3_counters.local();
+    counters.num_evaluations += batch.size;
+    for (int i = 0; i < batch.size; i++) counters.num_escalations += (escalated >> i) & 1;
+    return escalated;
+}
+
+AMIPSCounters AMIPS_p3_counters()
+{
+    AMIPSCounters sum;
+    for (auto& c : amips_p3_counters) {
+        sum.num_evaluations += c.num_evaluations;
+        sum.num_escalations += c.num_escalations;
+    }
+    return sum;
+}
+
+void reset_AMIPS_p3_counters()
+{
+    for (auto& c : amips_p3_counters) c = AMIPSCounters();
+}
 
-} // namespace wmtk
\ No newline at end of file
+} // namespace wmtk
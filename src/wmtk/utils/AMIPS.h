@@ -4,11 +4,87 @@
 
 #include <array>
 #include <cmath>
+#include <optional>
 
 namespace wmtk {
 double AMIPS_energy(const std::array<double, 12>& T);
 void AMIPS_jacobian(const std::array<double, 12>& T, Eigen::Vector3d& result_0);
 void AMIPS_hessian(const std::array<double, 12>& T, Eigen::Matrix3d& result_0);
+
+/**
+ * @brief The number of tets the batched AMIPS kernels evaluate at once, the doubles of an AVX-512
+ * register.
+ */
+constexpr int AMIPS_BATCH_SIZE = 8;
+using AMIPSLanes = std::array<double, AMIPS_BATCH_SIZE>;
+
+/**
+ * @brief Up to AMIPS_BATCH_SIZE tets in structure of arrays layout, as the batched kernels load
+ * them. The results of the lanes past size are unspecified.
+ */
+struct AMIPSBatch
+{
+    // T[k][i] is the coordinate k of the i-th tet, in the order of the scalar functions
+    alignas(64) std::array<AMIPSLanes, 12> T = {};
+    int size = 0;
+
+    void push_back(const std::array<double, 12>& tet)
+    {
+        for (int k = 0; k < 12; k++) T[k][size] = tet[k];
+        size++;
+    }
+    std::array<double, 12> tet(int i) const
+    {
+        std::array<double, 12> tet;
+        for (int k = 0; k < 12; k++) tet[k] = T[k][i];
+        return tet;
+    }
+    bool full() const { return size == AMIPS_BATCH_SIZE; }
+    void clear() { size = 0; }
+};
+
+/**
+ * @brief AMIPS_energy, AMIPS_jacobian and AMIPS_hessian of the tets of a batch, bit for bit. The
+ * i-th lane of each output is the one of the i-th tet, and the Hessians are row-major.
+ *
+ * The kernels are compiled for AVX-512, AVX2 and the baseline of the target, and the best version
+ * the CPU supports is chosen at runtime, on x86-64 Linux with GCC or clang. Elsewhere they loop
+ * over the scalar functions. AMIPS.cpp does not fuse multiply-adds, which AVX-512 would otherwise
+ * do, so that all the versions round like the scalar functions.
+ */
+void AMIPS_energy_batch(const AMIPSBatch& batch, AMIPSLanes& energy);
+void AMIPS_jacobian_batch(const AMIPSBatch& batch, std::array<AMIPSLanes, 3>& jacobian);
+void AMIPS_hessian_batch(const AMIPSBatch& batch, std::array<AMIPSLanes, 9>& hessian);
+
+/**
+ * @brief AMIPS_energy_rational_p3 evaluated in doubles, or nothing when the tet is too close to
+ * degenerate for the double evaluation to be within a relative error of 1e-9 of the exact energy.
+ *
+ * The energy is the cube of the sum of the squared edge lengths over 16 times the squared
+ * determinant of the edge vectors, so that its error follows from the error bound of the
+ * determinant (the one of the orient3d predicate) and the one of a sum of positive terms.
+ */
+std::optional<double> AMIPS_energy_p3_filtered(const std::array<double, 12>& T);
+
+/**
+ * @brief AMIPS_energy_p3_filtered of the tets of a batch, bit for bit, escalations included
+ * @return the bit mask of the tets that need the exact evaluation, whose energies are unspecified
+ */
+int AMIPS_energy_p3_filtered_batch(const AMIPSBatch& batch, AMIPSLanes& energy);
+
+/**
+ * @brief How many energies AMIPS_energy_p3_filtered evaluated, and how many of them it escalated
+ * to the exact evaluation, summed over the threads. Reading or resetting them while other threads
+ * evaluate energies gives approximate counts.
+ */
+struct AMIPSCounters
+{
+    size_t num_evaluations = 0;
+    size_t num_escalations = 0;
+};
+AMIPSCounters AMIPS_p3_counters();
+void reset_AMIPS_p3_counters();
+
 template <typename rational, typename dtype>
 double AMIPS_energy_rational_p3(const std::array<dtype, 12>& T){
      std::array<rational, 12> r_T;
@@ -56,13 +132,7 @@ double AMIPS_energy_rational_p3(const std::array<dtype, 12>& T){
 template <typename rational>
 double AMIPS_energy_stable_p3(const std::array<double, 12>& T)
 {
-    auto res = AMIPS_energy(T);
-
-    if (res < 1e8 && res > 2) {
-        return std::pow(res, 3);
-    } else {
-        return AMIPS_energy_rational_p3<rational>(T);
-    }
-   
+    if (auto res = AMIPS_energy_p3_filtered(T)) return *res;
+    return AMIPS_energy_rational_p3<rational>(T);
 }
 } // namespace wmtk
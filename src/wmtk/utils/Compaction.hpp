@@ -0,0 +1,127 @@
+#pragma once
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_scan.h>
+
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace wmtk {
+
+/**
+ * @brief computes the new ids of the kept elements among [0, n) with a parallel prefix sum,
+ * keeping their relative order.
+ *
+ * @param old2new receives the new id of each kept element, -1 for the others
+ * @return the old id of each new element, in increasing order
+ */
+template <typename IsKept>
+std::vector<size_t> compact_ids(size_t n, IsKept&& is_kept, std::vector<size_t>& old2new)
+{
+    old2new.assign(n, -1);
+    const size_t n_kept = tbb::parallel_scan(
+        tbb::blocked_range<size_t>(0, n),
+        size_t(0),
+        [&](const tbb::blocked_range<size_t>& r, size_t sum, bool is_final_scan) {
+            for (auto i = r.begin(); i < r.end(); i++) {
+                if (!is_kept(i)) continue;
+                if (is_final_scan) old2new[i] = sum;
+                sum++;
+            }
+            return sum;
+        },
+        std::plus<size_t>());
+
+    auto new2old = std::vector<size_t>(n_kept);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, n), [&](const tbb::blocked_range<size_t>& r) {
+        for (auto i = r.begin(); i < r.end(); i++)
+            if (old2new[i] != size_t(-1)) new2old[old2new[i]] = i;
+    });
+    return new2old;
+}
+
+/**
+ * @brief moves, in parallel, the blocks data[new2old[i] * stride, ... + stride) to
+ * data[i * stride, ... + stride). new2old must not repeat ids, but needs not be increasing. The
+ * size of data is not changed.
+ */
+template <typename Vector>
+void compact_in_place(Vector& data, const std::vector<size_t>& new2old, size_t stride = 1)
+{
+    using T = typename Vector::value_type;
+    assert(new2old.size() * stride <= data.size());
+
+    // the leading blocks that stay in place are skipped
+    size_t first_moved = 0;
+    while (first_moved < new2old.size() && new2old[first_moved] == first_moved) first_moved++;
+    const size_t n_moved = new2old.size() - first_moved;
+    if (n_moved == 0) return;
+
+    // the blocks overlap their sources, so they go through a buffer
+    auto buffer = std::unique_ptr<T[]>(new T[n_moved * stride]);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, n_moved),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (auto i = r.begin(); i < r.end(); i++)
+                for (size_t j = 0; j < stride; j++)
+                    buffer[i * stride + j] =
+                        std::move(data[new2old[first_moved + i] * stride + j]);
+        });
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, n_moved),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (auto i = r.begin(); i < r.end(); i++)
+                for (size_t j = 0; j < stride; j++)
+                    data[(first_moved + i) * stride + j] = std::move(buffer[i * stride + j]);
+        });
+}
+
+/**
+ * @brief the slot map, for compact_in_place with a stride of 1, of the sub-elements shared by the
+ * elements, such as the faces and edges of tets, when the elements are reordered by a new2old that
+ * is not increasing. A shared sub-element lives in the slot of its incident element of smallest
+ * id, which the reordering may change: its value moves from its old slot to its new slot. The
+ * slots of the other copies receive the remaining old slots.
+ *
+ * @param stride number of slots per element
+ * @param owned_slot called with (i, j) for the sub-element j of the new element i. It returns the
+ * new slot of the sub-element if its old slot is new2old[i] * stride + j, nothing otherwise.
+ */
+template <typename OwnedSlot>
+std::vector<size_t>
+shared_slots_new2old(const std::vector<size_t>& new2old, size_t stride, OwnedSlot&& owned_slot)
+{
+    const size_t n = new2old.size() * stride;
+    constexpr size_t none = std::numeric_limits<size_t>::max();
+    auto slots = std::vector<size_t>(n, none);
+    // is_owned[i * stride + j] tells if the old slot new2old[i] * stride + j is taken
+    auto is_owned = std::vector<char>(n, false);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, new2old.size()),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (auto i = r.begin(); i < r.end(); i++)
+                for (size_t j = 0; j < stride; j++) {
+                    const std::optional<size_t> slot = owned_slot(i, j);
+                    if (!slot) continue;
+                    assert(*slot < n && slots[*slot] == none);
+                    slots[*slot] = new2old[i] * stride + j;
+                    is_owned[i * stride + j] = true;
+                }
+        });
+
+    size_t k = 0;
+    for (auto& slot : slots) {
+        if (slot != none) continue;
+        while (is_owned[k]) k++;
+        slot = new2old[k / stride] * stride + k % stride;
+        k++;
+    }
+    return slots;
+}
+
+} // namespace wmtk
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+namespace wmtk {
+
+/**
+ * @brief The type of the vertex ids stored in the connectivity of the meshes. The compact
+ * connectivity (cmake option WMTK_COMPACT_CONNECTIVITY) stores them on 32 bits, which limits the
+ * number of vertex slots to 2^32 - 1.
+ */
+#if defined(WMTK_COMPACT_CONNECTIVITY)
+using ConnectivityIndex = std::uint32_t;
+#else
+using ConnectivityIndex = size_t;
+#endif
+
+/**
+ * @brief throws if the number of vertex slots does not fit in a ConnectivityIndex.
+ */
+inline void check_connectivity_index_range(size_t n_vertices)
+{
+    if constexpr (sizeof(ConnectivityIndex) < sizeof(size_t)) {
+        if (n_vertices > std::numeric_limits<ConnectivityIndex>::max())
+            throw std::overflow_error("too many vertices for the compact connectivity");
+    }
+}
+
+/**
+ * @brief copies an array of vertex ids into an array of another index type.
+ */
+template <typename To, typename From, size_t N>
+std::array<To, N> convert_indices(const std::array<From, N>& indices)
+{
+    std::array<To, N> result;
+    for (size_t i = 0; i < N; i++) result[i] = static_cast<To>(indices[i]);
+    return result;
+}
+
+} // namespace wmtk
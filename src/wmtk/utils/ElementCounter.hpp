@@ -0,0 +1,54 @@
+#pragma once
+
+#include <tbb/enumerable_thread_specific.h>
+
+#include <atomic>
+#include <cstddef>
+
+namespace wmtk {
+
+/**
+ * @brief (internal use) The number of live elements of a mesh, kept up to date by the operations so
+ * that it is read in constant time.
+ *
+ * A change is either applied right away with add, or staged in a delta of the calling thread, for
+ * the operations that can still be rolled back, and applied by commit or dropped by discard.
+ */
+class ElementCounter
+{
+public:
+    size_t get() const { return m_count.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief sets the count, and drops the staged deltas. Not thread safe.
+     */
+    void reset(size_t n)
+    {
+        m_count.store(n, std::memory_order_relaxed);
+        for (auto& d : m_delta) d = 0;
+    }
+
+    void add(long d)
+    {
+        if (d != 0) m_count.fetch_add(d, std::memory_order_relaxed);
+    }
+
+    void stage(long d) { m_delta.local() += d; }
+    /**
+     * @return the delta staged by the calling thread since its last commit or discard
+     */
+    long staged() const { return m_delta.local(); }
+    void commit()
+    {
+        auto& d = m_delta.local();
+        add(d);
+        d = 0;
+    }
+    void discard() { m_delta.local() = 0; }
+
+private:
+    std::atomic_long m_count{0};
+    mutable tbb::enumerable_thread_specific<long> m_delta{0};
+};
+
+} // namespace wmtk
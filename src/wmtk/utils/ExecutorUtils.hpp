@@ -5,10 +5,11 @@
 namespace wmtk {
 
 constexpr auto renewal_edges = [](const auto& m, auto op, const auto& newt) {
-    std::vector<std::pair<std::string, wmtk::TetMesh::Tuple>> op_tups;
+    std::vector<std::pair<decltype(op), wmtk::TetMesh::Tuple>> op_tups;
     auto new_edges = std::vector<wmtk::TetMesh::Tuple>();
+    new_edges.reserve(6 * newt.size());
     for (auto ti : newt) {
-        for (auto j = 0; j < 6; j++) new_edges.push_back(m.tuple_from_edge(ti.tid(m), j));
+        m.for_each_edge_of_tet(ti, [&](const auto& e) { new_edges.push_back(e); });
     };
     wmtk::unique_edge_tuples(m, new_edges);
     for (auto f : new_edges) op_tups.emplace_back(op, f);
@@ -16,7 +17,7 @@ constexpr auto renewal_edges = [](const auto& m, auto op, const auto& newt) {
 };
 
 constexpr auto renewal_faces = [](const auto& m, auto op, const auto& newtets) {
-    std::vector<std::pair<std::string, wmtk::TetMesh::Tuple>> op_tups;
+    std::vector<std::pair<decltype(op), wmtk::TetMesh::Tuple>> op_tups;
 
     auto new_faces = std::vector<wmtk::TetMesh::Tuple>();
     for (auto ti : newtets) {
@@ -28,7 +29,7 @@ constexpr auto renewal_faces = [](const auto& m, auto op, const auto& newtets) {
 };
 
 constexpr auto renewal_simple = [](const auto& m, auto op, const auto& newts) {
-    std::vector<std::pair<std::string, wmtk::TetMesh::Tuple>> op_tups;
+    std::vector<std::pair<decltype(op), wmtk::TetMesh::Tuple>> op_tups;
     for (auto t : newts) {
         op_tups.emplace_back(op, t);
     }
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <wmtk/utils/LazyRational.hpp>
+#include <wmtk/utils/Rational.hpp>
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <optional>
+
+namespace wmtk {
+
+/**
+ * @brief A closed interval of doubles that contains an exact value.
+ *
+ * Each operation rounds to nearest and then widens the bounds by one ulp, which encloses the exact
+ * result without changing the rounding mode of the thread.
+ */
+class Interval
+{
+public:
+    Interval() = default;
+    explicit Interval(double x)
+        : m_lo(x)
+        , m_hi(x)
+    {}
+    Interval(double lo, double hi)
+        : m_lo(lo)
+        , m_hi(hi)
+    {}
+
+    double lo() const { return m_lo; }
+    double hi() const { return m_hi; }
+
+    /**
+     * @return the sign of all the values in the interval, or nothing when it contains 0 or is
+     * not finite
+     */
+    std::optional<int> sign() const
+    {
+        if (!std::isfinite(m_lo) || !std::isfinite(m_hi)) return {};
+        if (m_lo > 0) return 1;
+        if (m_hi < 0) return -1;
+        return {};
+    }
+
+    friend Interval operator+(const Interval& a, const Interval& b)
+    {
+        return widened(a.m_lo + b.m_lo, a.m_hi + b.m_hi);
+    }
+    friend Interval operator-(const Interval& a, const Interval& b)
+    {
+        return widened(a.m_lo - b.m_hi, a.m_hi - b.m_lo);
+    }
+    friend Interval operator*(const Interval& a, const Interval& b)
+    {
+        const std::array<double, 4> p = {
+            {a.m_lo * b.m_lo, a.m_lo * b.m_hi, a.m_hi * b.m_lo, a.m_hi * b.m_hi}};
+        const auto [lo, hi] = std::minmax_element(p.begin(), p.end());
+        return widened(*lo, *hi);
+    }
+
+private:
+    static Interval widened(double lo, double hi)
+    {
+        constexpr double inf = std::numeric_limits<double>::infinity();
+        return Interval(std::nextafter(lo, -inf), std::nextafter(hi, inf));
+    }
+
+    double m_lo = 0;
+    double m_hi = 0;
+};
+
+using Vector3I = std::array<Interval, 3>;
+
+inline Interval to_interval(double x)
+{
+    return Interval(x);
+}
+
+inline Interval to_interval(const Rational& x)
+{
+    // mpq_get_d truncates, so the exact value is less than one ulp away
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    const double d = x.to_double();
+    return Interval(std::nextafter(d, -inf), std::nextafter(d, inf));
+}
+
+inline Interval to_interval(const LazyRational& x)
+{
+    if (x.is_double()) return Interval(x.to_double());
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    const double d = x.to_double();
+    return Interval(std::nextafter(d, -inf), std::nextafter(d, inf));
+}
+
+template <typename T>
+Vector3I to_interval(const Eigen::Matrix<T, 3, 1>& p)
+{
+    return {{to_interval(p[0]), to_interval(p[1]), to_interval(p[2])}};
+}
+
+/**
+ * @brief the sign of orient3d_t(p1, p2, p3, p4), when it can be decided from the intervals.
+ * Otherwise the caller falls back to the exact predicate.
+ */
+inline std::optional<int>
+orient3d_filtered(const Vector3I& p1, const Vector3I& p2, const Vector3I& p3, const Vector3I& p4)
+{
+    Vector3I a, b, c;
+    for (int d = 0; d < 3; d++) {
+        a[d] = p2[d] - p1[d];
+        b[d] = p3[d] - p1[d];
+        c[d] = p4[d] - p1[d];
+    }
+    const auto det = (a[1] * b[2] - a[2] * b[1]) * c[0] + (a[2] * b[0] - a[0] * b[2]) * c[1] +
+                     (a[0] * b[1] - a[1] * b[0]) * c[2];
+    return det.sign();
+}
+
+} // namespace wmtk
@@ -0,0 +1,104 @@
+#include "GmpMemoryPool.hpp"
+
+#include <gmp.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+// the limbs of the coordinates and of the intermediate results of the predicates are small
+constexpr size_t max_pooled_size = 512;
+constexpr size_t max_blocks_per_size = 1024;
+
+bool is_pooled(size_t size)
+{
+    return size > 0 && size <= max_pooled_size && size % sizeof(mp_limb_t) == 0;
+}
+
+struct Pool
+{
+    std::array<std::vector<void*>, max_pooled_size / sizeof(mp_limb_t) + 1> free_blocks;
+    size_t mallocs = 0;
+
+    Pool();
+    ~Pool();
+};
+
+// the pool can still be used by the destructors of other thread_local or static objects after it
+// is destroyed, which then fall back to malloc
+enum class PoolState { kUnused, kAlive, kDestroyed };
+thread_local PoolState pool_state = PoolState::kUnused;
+thread_local Pool pool;
+
+Pool::Pool()
+{
+    pool_state = PoolState::kAlive;
+}
+
+Pool::~Pool()
+{
+    pool_state = PoolState::kDestroyed;
+    for (auto& blocks : free_blocks)
+        for (auto b : blocks) std::free(b);
+}
+
+void* pool_allocate(size_t size)
+{
+    if (!is_pooled(size) || pool_state == PoolState::kDestroyed) return std::malloc(size);
+    auto& blocks = pool.free_blocks[size / sizeof(mp_limb_t)];
+    if (blocks.empty()) {
+        pool.mallocs++;
+        return std::malloc(size);
+    }
+    auto b = blocks.back();
+    blocks.pop_back();
+    return b;
+}
+
+void pool_free(void* ptr, size_t size)
+{
+    if (!is_pooled(size) || pool_state == PoolState::kDestroyed) return std::free(ptr);
+    auto& blocks = pool.free_blocks[size / sizeof(mp_limb_t)];
+    if (blocks.size() >= max_blocks_per_size) return std::free(ptr);
+    blocks.push_back(ptr);
+}
+
+void* pool_reallocate(void* ptr, size_t old_size, size_t new_size)
+{
+    if (!is_pooled(old_size) && !is_pooled(new_size)) return std::realloc(ptr, new_size);
+    auto new_ptr = pool_allocate(new_size);
+    std::memcpy(new_ptr, ptr, std::min(old_size, new_size));
+    pool_free(ptr, old_size);
+    return new_ptr;
+}
+
+// the functions of GMP take the block sizes, which malloc does not need
+void* malloc_allocate(size_t size)
+{
+    return std::malloc(size);
+}
+void malloc_free(void* ptr, size_t)
+{
+    std::free(ptr);
+}
+void* malloc_reallocate(void* ptr, size_t, size_t new_size)
+{
+    return std::realloc(ptr, new_size);
+}
+} // namespace
+
+void wmtk::use_gmp_memory_pool(bool enable)
+{
+    if (enable)
+        mp_set_memory_functions(pool_allocate, pool_reallocate, pool_free);
+    else
+        mp_set_memory_functions(malloc_allocate, malloc_reallocate, malloc_free);
+}
+
+size_t wmtk::gmp_memory_pool_mallocs()
+{
+    return pool_state == PoolState::kDestroyed ? 0 : pool.mallocs;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+namespace wmtk {
+
+/**
+ * @brief Makes GMP, and so Rational, take its limbs from per-thread pools of freed blocks instead
+ * of malloc, or gives them back to malloc.
+ *
+ * The blocks are pooled by exact size, so a block allocated before the switch can be freed after
+ * it. Not thread safe: call it before the threads use GMP, e.g. at the start of main.
+ */
+void use_gmp_memory_pool(bool enable = true);
+
+/**
+ * @return the number of blocks allocated with malloc by the pool of the calling thread
+ */
+size_t gmp_memory_pool_mallocs();
+
+} // namespace wmtk
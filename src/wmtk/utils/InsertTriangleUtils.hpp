@@ -1,6 +1,7 @@
 #pragma once
 
 #include "wmtk/TetMesh.h"
+#include "wmtk/utils/FilteredPredicates.hpp"
 #include "wmtk/utils/GeoUtils.h"
 
 // clang-format off
@@ -35,6 +36,14 @@ bool remove_duplicates(
 
 namespace wmtk {
 
+/**
+ * @brief Finds the tets and edges of the mesh cut by a triangle, and the points where the edges
+ * are cut.
+ *
+ * The orientation tests are filtered: they are first evaluated in interval arithmetic on doubles,
+ * and only evaluated on the rational positions when the sign is uncertain. The intersection points
+ * are only computed for the cut edges that are returned.
+ */
 template <typename rational>
 auto triangle_insert_prepare_info(
     const wmtk::TetMesh& m,
@@ -66,16 +75,16 @@ auto triangle_insert_prepare_info(
         vertex_pos_r(face_v[1]),
         vertex_pos_r(face_v[2])};
     //
-    Vector3r tri_normal = (tri[1] - tri[0]).cross(tri[2] - tri[0]);
+    const std::array<Vector3I, 3> tri_i = {
+        {to_interval(tri[0]), to_interval(tri[1]), to_interval(tri[2])}};
     //
     std::array<Vector2r, 3> tri2;
     int squeeze_to_2d_dir = wmtk::project_triangle_to_2d(tri, tri2);
 
     std::vector<Tuple> intersected_tets;
-    std::map<std::array<size_t, 2>, std::tuple<int, Vector3r, size_t, int>> map_edge2point;
+    std::map<std::array<size_t, 2>, std::tuple<int, size_t, int>> map_edge2point;
     std::map<std::array<size_t, 3>, bool> map_face2intersected;
-    // e = (e0, e1) ==> (intersection_status, intersection_point, edge's_tid,
-    // local_eid_in_tet)
+    // e = (e0, e1) ==> (intersection_status, edge's_tid, local_eid_in_tet)
     std::set<std::array<size_t, 2>> intersected_tet_edges;
     //
     std::queue<Tuple> tet_queue;
@@ -97,6 +106,29 @@ auto triangle_insert_prepare_info(
             visited.insert(t.tid(m));
         }
     }
+    // the positions of the visited vertices as intervals, converted once from the rationals
+    std::map<size_t, Vector3I> map_vertex2interval;
+    auto vertex_pos_i = [&](size_t vid) -> const Vector3I& {
+        auto it = map_vertex2interval.find(vid);
+        if (it == map_vertex2interval.end())
+            it = map_vertex2interval.emplace(vid, to_interval(vertex_pos_r(vid))).first;
+        return it->second;
+    };
+    // if the segment seg, whose endpoints are strictly on both sides of the plane of the triangle
+    // t, goes through the closed triangle: the orientations of seg with the edges of t do not have
+    // opposite signs. exact_orient(k) evaluates the orientation with the k-th edge exactly.
+    auto is_seg_cut_tri_3 = [](const std::array<Vector3I, 2>& seg,
+                               const std::array<Vector3I, 3>& t,
+                               const auto& exact_orient) {
+        bool has_pos = false, has_neg = false;
+        for (int k = 0; k < 3; k++) {
+            auto res = orient3d_filtered(seg[0], seg[1], t[k], t[(k + 1) % 3]);
+            int o = res ? *res : exact_orient(k);
+            if (o > 0) has_pos = true;
+            if (o < 0) has_neg = true;
+        }
+        return !(has_pos && has_neg);
+    };
     //
     constexpr auto is_seg_cut_tri_2 = [](const std::array<Vector2r, 2>& seg2d,
                                          const std::array<Vector2r, 3>& tri2d) {
@@ -146,8 +178,10 @@ auto triangle_insert_prepare_info(
         std::array<size_t, 4> vertex_vids;
         for (int j = 0; j < 4; j++) {
             vertex_vids[j] = vs[j].vid(m);
-            Vector3r dir = vertex_pos_r(vertex_vids[j]) - tri[0];
-            auto side = dir.dot(tri_normal);
+            const auto& p = vertex_pos_i(vertex_vids[j]);
+            auto res = orient3d_filtered(tri_i[0], tri_i[1], tri_i[2], p);
+            int side = res ? *res
+                           : orient3d_t(tri[0], tri[1], tri[2], vertex_pos_r(vertex_vids[j]));
             if (side > 0) {
                 cnt_pos++;
                 vertex_sides[vertex_vids[j]] = 1;
@@ -268,19 +302,14 @@ auto triangle_insert_prepare_info(
                 continue;
             }
 
-            std::array<Vector3r, 2> seg = {{vertex_pos_r(e[0]), vertex_pos_r(e[1])}};
-            Vector3r p(0, 0, 0);
-            int intersection_status = EMPTY_INTERSECTION;
-            bool is_inside_tri = false;
-            bool is_intersected_plane =
-                wmtk::open_segment_plane_intersection_3d(seg, tri, p, is_inside_tri);
-            if (is_intersected_plane && is_inside_tri) {
-                intersection_status = TRI_INTERSECTION;
-            } else if (is_intersected_plane) {
-                intersection_status = PLN_INTERSECTION;
-            }
+            // the endpoints are strictly on both sides, so the edge always cuts the plane
+            const std::array<Vector3I, 2> seg = {{vertex_pos_i(e[0]), vertex_pos_i(e[1])}};
+            bool is_inside_tri = is_seg_cut_tri_3(seg, tri_i, [&](int k) {
+                return orient3d_t(vertex_pos_r(e[0]), vertex_pos_r(e[1]), tri[k], tri[(k + 1) % 3]);
+            });
+            int intersection_status = is_inside_tri ? TRI_INTERSECTION : PLN_INTERSECTION;
 
-            map_edge2point[e] = std::make_tuple(intersection_status, p, tet.tid(m), l_eid);
+            map_edge2point[e] = std::make_tuple(intersection_status, tet.tid(m), l_eid);
             if (intersection_status == EMPTY_INTERSECTION) {
                 continue;
             } else if (intersection_status == TRI_INTERSECTION) {
@@ -328,20 +357,19 @@ auto triangle_insert_prepare_info(
                 if (cnt_pos1 == 0 || cnt_neg1 == 0) continue;
             }
 
-            std::array<Vector3r, 3> tet_tri = {
-                {vertex_pos_r(f[0]), vertex_pos_r(f[1]), vertex_pos_r(f[2])}};
+            const std::array<Vector3I, 3> tet_tri = {
+                {vertex_pos_i(f[0]), vertex_pos_i(f[1]), vertex_pos_i(f[2])}};
             //
             std::array<int, 3> tet_tri_v_sides;
-            Vector3r tet_tri_normal = (tet_tri[1] - tet_tri[0]).cross(tet_tri[2] - tet_tri[0]);
             for (int k = 0; k < 3; k++) {
-                Vector3r dir = tri[k] - tet_tri[0];
-                auto side = dir.dot(tet_tri_normal);
-                if (side == 0)
-                    tet_tri_v_sides[k] = 0;
-                else if (side > 0)
-                    tet_tri_v_sides[k] = 1;
-                else
-                    tet_tri_v_sides[k] = -1;
+                auto res = orient3d_filtered(tet_tri[0], tet_tri[1], tet_tri[2], tri_i[k]);
+                tet_tri_v_sides[k] =
+                    res ? *res
+                        : orient3d_t(
+                              vertex_pos_r(f[0]),
+                              vertex_pos_r(f[1]),
+                              vertex_pos_r(f[2]),
+                              tri[k]);
             }
 
             bool is_intersected = false;
@@ -349,11 +377,14 @@ auto triangle_insert_prepare_info(
                 if ((tet_tri_v_sides[k] >= 0 && tet_tri_v_sides[(k + 1) % 3] >= 0) ||
                     (tet_tri_v_sides[k] <= 0 && tet_tri_v_sides[(k + 1) % 3] <= 0))
                     continue;
-                Vector3r _p;
-                is_intersected = wmtk::open_segment_triangle_intersection_3d(
-                    {{tri[k], tri[(k + 1) % 3]}},
-                    tet_tri,
-                    _p);
+                const int k1 = (k + 1) % 3;
+                is_intersected = is_seg_cut_tri_3({{tri_i[k], tri_i[k1]}}, tet_tri, [&](int l) {
+                    return orient3d_t(
+                        tri[k],
+                        tri[k1],
+                        vertex_pos_r(f[l]),
+                        vertex_pos_r(f[(l + 1) % 3]));
+                });
                 if (is_intersected) {
                     need_subdivision = true; // is recorded
                     break;
@@ -397,9 +428,14 @@ auto triangle_insert_prepare_info(
     success_flag = true;
     std::vector<TetMesh::Tuple> intersected_edges;
     std::vector<Vector3r> intersected_pos;
-    for (auto& info : map_edge2point) {
-        auto& [_, p, tid, l_eid] = info.second;
+    for (auto& [e, info] : map_edge2point) {
+        auto& [_, tid, l_eid] = info;
         intersected_edges.push_back(m.tuple_from_edge(tid, l_eid));
+        // the edge cuts the plane, so the intersection is always found
+        std::array<Vector3r, 2> seg = {{vertex_pos_r(e[0]), vertex_pos_r(e[1])}};
+        Vector3r p(0, 0, 0);
+        bool is_inside_tri = false;
+        wmtk::open_segment_plane_intersection_3d(seg, tri, p, is_inside_tri);
         intersected_pos.push_back(p);
     }
     return std::tuple(success_flag, intersected_tets, intersected_edges, intersected_pos);
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <wmtk/utils/Rational.hpp>
+
+#include <gmp.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+
+namespace wmtk {
+
+/**
+ * @brief An exact rational number with the interface of Rational, which stays a double as long
+ * as its value is one.
+ *
+ * The sums, differences, products and quotients of doubles are checked for exactness with
+ * error-free transformations, and only materialize a GMP rational when they are not exact, so the
+ * rounded coordinates of a mesh and most of the arithmetic on them never allocate. A materialized
+ * rational is immutable and shared by the copies of the number, and keeps its double
+ * approximation next to it, so that most comparisons are decided without GMP.
+ */
+class LazyRational
+{
+public:
+    LazyRational() = default;
+    LazyRational(double d)
+        : m_approx(d)
+    {}
+    LazyRational(const Rational& r)
+    {
+        auto exact = std::make_shared<Rational>(r);
+        set_exact(std::move(exact));
+    }
+    LazyRational(const mpq_t& v)
+        : LazyRational(Rational(v))
+    {}
+
+    LazyRational& operator=(const double x)
+    {
+        m_approx = x;
+        m_exact.reset();
+        return *this;
+    }
+
+    void canonicalize() {} // the GMP operations keep the rationals canonical
+    int get_sign() const
+    {
+        if (!m_exact) return (m_approx > 0) - (m_approx < 0);
+        return mpq_sgn(m_exact->value);
+    }
+
+    /**
+     * @return if the value is stored as a double, without any GMP rational
+     */
+    bool is_double() const { return !m_exact; }
+    Rational to_rational() const { return m_exact ? *m_exact : Rational(m_approx); }
+
+    // to double, truncated like Rational::to_double
+    double to_double() const { return m_approx; }
+    explicit operator double() const { return to_double(); }
+
+    friend LazyRational operator+(const LazyRational& x, const LazyRational& y)
+    {
+        if (x.is_double() && y.is_double()) {
+            const double s = x.m_approx + y.m_approx;
+            // two-sum: the rounding error of s, computed exactly
+            const double bv = s - x.m_approx;
+            const double err = (x.m_approx - (s - bv)) + (y.m_approx - bv);
+            if (err == 0 && std::isfinite(s)) return s;
+        }
+        return apply(x, y, mpq_add);
+    }
+
+    friend LazyRational operator-(const LazyRational& x, const LazyRational& y)
+    {
+        if (x.is_double() && y.is_double()) {
+            const double s = x.m_approx - y.m_approx;
+            const double bv = s - x.m_approx;
+            const double err = (x.m_approx - (s - bv)) - (y.m_approx + bv);
+            if (err == 0 && std::isfinite(s)) return s;
+        }
+        return apply(x, y, mpq_sub);
+    }
+
+    friend LazyRational operator-(const LazyRational& x)
+    {
+        if (x.is_double()) return -x.m_approx;
+        auto exact = std::make_shared<Rational>();
+        mpq_neg(exact->value, x.m_exact->value);
+        LazyRational r;
+        r.m_approx = -x.m_approx;
+        r.m_exact = std::move(exact);
+        return r;
+    }
+
+    friend LazyRational pow(const LazyRational& x, int p)
+    {
+        LazyRational r_out = x;
+        for (int i = 1; i < std::abs(p); i++) {
+            r_out = r_out * x;
+        }
+        if (p < 0) return 1 / r_out;
+        return r_out;
+    }
+
+    friend LazyRational operator*(const LazyRational& x, const LazyRational& y)
+    {
+        if (x.is_double() && y.is_double()) {
+            const double a = x.m_approx, b = y.m_approx;
+            const double p = a * b;
+            if (p == 0 && (a == 0 || b == 0)) return p;
+            // two-product: the rounding error of p, exact when p is far enough from underflow
+            if (std::isfinite(p) && std::abs(p) >= min_exact() && std::fma(a, b, -p) == 0)
+                return p;
+        }
+        return apply(x, y, mpq_mul);
+    }
+
+    friend LazyRational operator/(const LazyRational& x, const LazyRational& y)
+    {
+        if (x.is_double() && y.is_double() && y.m_approx != 0) {
+            const double a = x.m_approx, b = y.m_approx;
+            const double q = a / b;
+            if (a == 0) return q;
+            // q is the exact quotient iff q * b gives back a without any rounding
+            if (std::isfinite(q) && std::abs(q) >= min_exact() && std::abs(a) >= min_exact() &&
+                std::fma(q, b, -a) == 0)
+                return q;
+        }
+        return apply(x, y, mpq_div);
+    }
+
+    //> < ==
+    friend bool operator<(const LazyRational& r, const LazyRational& r1)
+    {
+        return compare(r, r1) < 0;
+    }
+
+    friend bool operator>(const LazyRational& r, const LazyRational& r1)
+    {
+        return compare(r, r1) > 0;
+    }
+
+    friend bool operator<=(const LazyRational& r, const LazyRational& r1)
+    {
+        return compare(r, r1) <= 0;
+    }
+
+    friend bool operator>=(const LazyRational& r, const LazyRational& r1)
+    {
+        return compare(r, r1) >= 0;
+    }
+
+    friend bool operator==(const LazyRational& r, const LazyRational& r1)
+    {
+        return compare(r, r1) == 0;
+    }
+
+    friend bool operator!=(const LazyRational& r, const LazyRational& r1)
+    {
+        return compare(r, r1) != 0;
+    }
+
+    friend LazyRational abs(const LazyRational& r0) { return r0.get_sign() < 0 ? -r0 : r0; }
+
+    //<<
+    friend std::ostream& operator<<(std::ostream& os, const LazyRational& r)
+    {
+        os << r.m_approx;
+        return os;
+    }
+
+private:
+    // below this magnitude, the error-free transformations may lose bits to underflow
+    static double min_exact() { return std::ldexp(1., -969); }
+
+    // keeps the exact value as a double when it is one, which the results of the GMP operations
+    // often are, e.g. the midpoint of two rationals
+    void set_exact(std::shared_ptr<Rational> exact)
+    {
+        m_approx = exact->to_double();
+        const auto num = mpq_numref(exact->value), den = mpq_denref(exact->value);
+        if (mpz_popcount(den) == 1 && mpz_sizeinbase(num, 2) <= 53 &&
+            mpz_sizeinbase(den, 2) <= 1000)
+            m_exact.reset();
+        else
+            m_exact = std::move(exact);
+    }
+
+    // a read-only GMP rational equal to a double, with its limbs on the stack
+    class DoubleView
+    {
+    public:
+        explicit DoubleView(double d)
+        {
+            static_assert(GMP_NUMB_BITS == 64, "the mantissa of a double fits in one limb");
+            int e = 0;
+            auto m = static_cast<mp_limb_t>(std::ldexp(std::abs(std::frexp(d, &e)), 53));
+            e -= 53; // |d| = m * 2^e
+            mp_size_t num_size = 0, den_size = 1;
+            m_den[0] = 1;
+            if (m != 0) {
+                // canonical: m is odd when there is a denominator
+                for (; (m & 1) == 0; m >>= 1) e++;
+                if (e >= 0) {
+                    const int l = e / 64, s = e % 64;
+                    std::fill(m_num.begin(), m_num.begin() + l, 0);
+                    m_num[l] = m << s;
+                    m_num[l + 1] = s == 0 ? 0 : m >> (64 - s);
+                    num_size = l + 2;
+                } else {
+                    const int l = -e / 64, s = -e % 64;
+                    m_num[0] = m;
+                    num_size = 1;
+                    std::fill(m_den.begin(), m_den.begin() + l, 0);
+                    m_den[l] = mp_limb_t(1) << s;
+                    den_size = l + 1;
+                }
+            }
+            mpz_roinit_n(mpq_numref(m_q), m_num.data(), d < 0 ? -num_size : num_size);
+            mpz_roinit_n(mpq_denref(m_q), m_den.data(), den_size);
+        }
+        DoubleView(const DoubleView&) = delete;
+        DoubleView& operator=(const DoubleView&) = delete;
+
+        mpq_srcptr get() const { return m_q; }
+
+    private:
+        // |d| < 2^1024 and |d| >= 2^-1074 need at most 17 limbs
+        std::array<mp_limb_t, 18> m_num;
+        std::array<mp_limb_t, 18> m_den;
+        mpq_t m_q;
+    };
+
+    template <typename Op>
+    static LazyRational apply(const LazyRational& x, const LazyRational& y, Op&& op)
+    {
+        const DoubleView dx(x.is_double() ? x.m_approx : 0), dy(y.is_double() ? y.m_approx : 0);
+        auto exact = std::make_shared<Rational>();
+        op(exact->value,
+           x.is_double() ? dx.get() : x.m_exact->value,
+           y.is_double() ? dy.get() : y.m_exact->value);
+        LazyRational r;
+        r.set_exact(std::move(exact));
+        return r;
+    }
+
+    // the exact value is in [lo(), hi()]: mpq_get_d truncates, so it is less than one ulp away
+    double lo() const
+    {
+        return is_double() ? m_approx
+                           : std::nextafter(m_approx, -std::numeric_limits<double>::infinity());
+    }
+    double hi() const
+    {
+        return is_double() ? m_approx
+                           : std::nextafter(m_approx, std::numeric_limits<double>::infinity());
+    }
+
+    static int compare(const LazyRational& x, const LazyRational& y)
+    {
+        if (std::isfinite(x.m_approx) && std::isfinite(y.m_approx)) {
+            if (x.hi() < y.lo()) return -1;
+            if (x.lo() > y.hi()) return 1;
+            if (x.is_double() && y.is_double()) return 0;
+        }
+        const DoubleView dx(x.is_double() ? x.m_approx : 0), dy(y.is_double() ? y.m_approx : 0);
+        return mpq_cmp(
+            x.is_double() ? dx.get() : x.m_exact->value,
+            y.is_double() ? dy.get() : y.m_exact->value);
+    }
+
+    double m_approx = 0;
+    std::shared_ptr<const Rational> m_exact; // nullptr when the value is m_approx
+};
+
+} // namespace wmtk
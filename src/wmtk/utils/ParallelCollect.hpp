@@ -0,0 +1,71 @@
+#pragma once
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace wmtk {
+
+/**
+ * @brief collects in parallel the elements emitted for the ids [0, n), in the order of the ids.
+ *
+ * Each block of ids appends to its own buffer, and the buffers are concatenated in the order of
+ * the blocks, so that the result does not depend on the scheduling and needs no sort.
+ *
+ * @param emit called as emit(i, out) for each id i, to append the elements of i to out
+ */
+template <typename T, typename Emit>
+std::vector<T> collect_in_order(size_t n, Emit&& emit)
+{
+    constexpr size_t block_size = 1024;
+    const size_t n_blocks = (n + block_size - 1) / block_size;
+    auto blocks = std::vector<std::vector<T>>(n_blocks);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, n_blocks),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (auto b = r.begin(); b < r.end(); b++) {
+                const size_t end = std::min(n, (b + 1) * block_size);
+                for (size_t i = b * block_size; i < end; i++) emit(i, blocks[b]);
+            }
+        });
+
+    auto offsets = std::vector<size_t>(n_blocks + 1, 0);
+    for (size_t b = 0; b < n_blocks; b++) offsets[b + 1] = offsets[b] + blocks[b].size();
+    auto result = std::vector<T>(offsets.back());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, n_blocks),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (auto b = r.begin(); b < r.end(); b++)
+                std::copy(blocks[b].begin(), blocks[b].end(), result.begin() + offsets[b]);
+        });
+    return result;
+}
+
+/**
+ * @brief reduces in parallel the values folded over the ids [0, n).
+ *
+ * The ids are split in fixed blocks whose accumulators are joined in a fixed order, so that the
+ * result, floating point sums included, does not depend on the scheduling.
+ *
+ * @param identity the initial value of the accumulator of each block
+ * @param accumulate called as accumulate(acc, i) for each id i, to fold it into acc
+ * @param combine called as combine(a, b) to join the accumulators of consecutive blocks
+ */
+template <typename T, typename Accumulate, typename Combine>
+T reduce_in_order(size_t n, const T& identity, Accumulate&& accumulate, Combine&& combine)
+{
+    constexpr size_t block_size = 1024;
+    return tbb::parallel_deterministic_reduce(
+        tbb::blocked_range<size_t>(0, n, block_size),
+        identity,
+        [&](const tbb::blocked_range<size_t>& r, T acc) {
+            for (auto i = r.begin(); i < r.end(); i++) accumulate(acc, i);
+            return acc;
+        },
+        [&](const T& a, const T& b) { return combine(a, b); });
+}
+
+} // namespace wmtk
@@ -4,6 +4,7 @@
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_sort.h>
 #include <tbb/task_arena.h>
+#include <wmtk/ExecutionContext.hpp>
 #include <wmtk/utils/Partitioning.h>
 #include <wmtk/utils/Morton.h>
 
@@ -50,7 +51,7 @@ std::vector<size_t> partition_TetMesh(wmtk::TetMesh& m, int num_partition)
 std::vector<size_t> partition_morton(std::vector<Eigen::Vector3d> vertex_position, int NUM_THREADS)
 {
     std::vector<size_t> partition_id(vertex_position.size());
-    tbb::task_arena arena(NUM_THREADS);
+    auto& arena = ExecutionContext::instance().arena(NUM_THREADS);
     
     arena.execute([&] {
         std::vector<Eigen::Vector3d> V_v = vertex_position;
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <gmp.h>
+#include <cstdlib>
 #include <iostream>
+#include <utility>
 
 namespace wmtk {
 
@@ -38,14 +40,28 @@ public:
         mpq_set(value, other.value);
     }
 
+    // takes the limbs of other, which is left equal to 0
+    Rational(Rational&& other) noexcept
+    {
+        mpq_init(value);
+        mpq_swap(value, other.value);
+    }
+
     ~Rational() { mpq_clear(value); }
 
+    // The operators on temporaries compute their result in the limbs of a temporary, which GMP
+    // allows for all its operations, so that an expression such as a * b - c * d only allocates
+    // for its products.
+
     friend Rational operator+(const Rational& x, const Rational& y)
     {
         Rational r_out;
         mpq_add(r_out.value, x.value, y.value);
         return r_out;
     }
+    friend Rational operator+(Rational&& x, const Rational& y) { return std::move(x += y); }
+    friend Rational operator+(const Rational& x, Rational&& y) { return std::move(y += x); }
+    friend Rational operator+(Rational&& x, Rational&& y) { return std::move(x += y); }
 
     friend Rational operator-(const Rational& x, const Rational& y)
     {
@@ -53,6 +69,13 @@ public:
         mpq_sub(r_out.value, x.value, y.value);
         return r_out;
     }
+    friend Rational operator-(Rational&& x, const Rational& y) { return std::move(x -= y); }
+    friend Rational operator-(const Rational& x, Rational&& y)
+    {
+        mpq_sub(y.value, x.value, y.value);
+        return std::move(y);
+    }
+    friend Rational operator-(Rational&& x, Rational&& y) { return std::move(x -= y); }
 
 
     friend Rational operator-(const Rational& x)
@@ -61,14 +84,19 @@ public:
         mpq_neg(r_out.value, x.value);
         return r_out;
     }
+    friend Rational operator-(Rational&& x)
+    {
+        mpq_neg(x.value, x.value);
+        return std::move(x);
+    }
 
     friend Rational pow(const Rational& x, int p)
     {
         Rational r_out = x;
         for (int i = 1; i < std::abs(p); i++) {
-            r_out = r_out * x;
+            r_out *= x;
         }
-        if (p < 0) return 1 / r_out;
+        if (p < 0) return 1 / std::move(r_out);
         return r_out;
     }
 
@@ -78,6 +106,9 @@ public:
         mpq_mul(r_out.value, x.value, y.value);
         return r_out;
     }
+    friend Rational operator*(Rational&& x, const Rational& y) { return std::move(x *= y); }
+    friend Rational operator*(const Rational& x, Rational&& y) { return std::move(y *= x); }
+    friend Rational operator*(Rational&& x, Rational&& y) { return std::move(x *= y); }
 
     friend Rational operator/(const Rational& x, const Rational& y)
     {
@@ -85,6 +116,34 @@ public:
         mpq_div(r_out.value, x.value, y.value);
         return r_out;
     }
+    friend Rational operator/(Rational&& x, const Rational& y) { return std::move(x /= y); }
+    friend Rational operator/(const Rational& x, Rational&& y)
+    {
+        mpq_div(y.value, x.value, y.value);
+        return std::move(y);
+    }
+    friend Rational operator/(Rational&& x, Rational&& y) { return std::move(x /= y); }
+
+    Rational& operator+=(const Rational& x)
+    {
+        mpq_add(value, value, x.value);
+        return *this;
+    }
+    Rational& operator-=(const Rational& x)
+    {
+        mpq_sub(value, value, x.value);
+        return *this;
+    }
+    Rational& operator*=(const Rational& x)
+    {
+        mpq_mul(value, value, x.value);
+        return *this;
+    }
+    Rational& operator/=(const Rational& x)
+    {
+        mpq_div(value, value, x.value);
+        return *this;
+    }
 
     Rational& operator=(const Rational& x)
     {
@@ -93,6 +152,12 @@ public:
         return *this;
     }
 
+    Rational& operator=(Rational&& x) noexcept
+    {
+        mpq_swap(value, x.value);
+        return *this;
+    }
+
     Rational& operator=(const double x)
     {
         mpq_set_d(value, x);
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace wmtk {
+
+/**
+ * @brief (internal use) A set of indices that is cleared in constant time, by tagging the slots of
+ * an open-addressing table with the epoch they were inserted in.
+ */
+class EpochIndexSet
+{
+public:
+    /**
+     * @return true if i was not in the set yet
+     */
+    bool insert(size_t i)
+    {
+        if (2 * (m_count + 1) > m_keys.size()) grow();
+        const size_t mask = m_keys.size() - 1;
+        for (size_t h = hash(i) & mask;; h = (h + 1) & mask) {
+            if (m_epochs[h] != m_epoch) {
+                m_epochs[h] = m_epoch;
+                m_keys[h] = i;
+                m_count++;
+                return true;
+            }
+            if (m_keys[h] == i) return false;
+        }
+    }
+
+    void clear()
+    {
+        m_count = 0;
+        if (++m_epoch == 0) { // wrapped around, the old tags have to be erased
+            std::fill(m_epochs.begin(), m_epochs.end(), 0);
+            m_epoch = 1;
+        }
+    }
+
+    size_t size() const { return m_count; }
+
+private:
+    static size_t hash(size_t i) { return i * 0x9E3779B97F4A7C15ull >> 16; }
+
+    void grow()
+    {
+        auto keys = std::vector<size_t>();
+        for (size_t h = 0; h < m_keys.size(); h++)
+            if (m_epochs[h] == m_epoch) keys.push_back(m_keys[h]);
+        const size_t capacity = m_keys.empty() ? 32 : 2 * m_keys.size();
+        m_keys.assign(capacity, 0);
+        m_epochs.assign(capacity, 0);
+        m_epoch = 1;
+        m_count = 0;
+        for (auto i : keys) insert(i);
+    }
+
+    std::vector<size_t> m_keys;
+    std::vector<uint32_t> m_epochs;
+    uint32_t m_epoch = 1;
+    size_t m_count = 0;
+};
+
+/**
+ * @brief (internal use) The values of the elements of an AttributeCollection before their first
+ * modification in the current protected operation, in the order they were first modified. The
+ * entries are kept after clear, so that recording an element copies into the memory of a
+ * previous entry instead of allocating.
+ */
+template <typename T>
+class RollbackLog
+{
+public:
+    using value_type = std::pair<size_t, T>;
+
+    /**
+     * @brief records the value of the element i, unless it was already recorded since the last
+     * clear
+     */
+    void record(size_t i, const T& value)
+    {
+        if (!m_recorded.insert(i)) return;
+        if (m_size < m_entries.size()) {
+            m_entries[m_size].first = i;
+            m_entries[m_size].second = value;
+        } else {
+            m_entries.emplace_back(i, value);
+        }
+        m_size++;
+    }
+
+    void clear()
+    {
+        m_size = 0;
+        m_recorded.clear();
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    auto begin() { return m_entries.begin(); }
+    auto end() { return m_entries.begin() + m_size; }
+    auto begin() const { return m_entries.begin(); }
+    auto end() const { return m_entries.begin() + m_size; }
+
+private:
+    std::vector<value_type> m_entries;
+    size_t m_size = 0;
+    EpochIndexSet m_recorded;
+};
+
+} // namespace wmtk
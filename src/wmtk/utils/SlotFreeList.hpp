@@ -0,0 +1,109 @@
+#pragma once
+
+#include <tbb/enumerable_thread_specific.h>
+
+#include <cassert>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace wmtk {
+
+/**
+ * @brief (internal use) The removed slots of a mesh that can be reused before the next
+ * consolidation, in one free list per thread.
+ *
+ * The slots removed by an operation are staged, and only become free once it succeeds, since a
+ * rollback restores them. Each thread also owns a slab of new slots past the previous capacity,
+ * reserved in one go so that the threads do not contend on the growth of the mesh.
+ */
+class SlotFreeList
+{
+public:
+    /**
+     * @brief the number of new slots reserved at once by a thread, when several threads allocate
+     */
+    static constexpr size_t slab_size = 64;
+
+    /**
+     * @return a free slot, or else a slot of the slab of the calling thread
+     */
+    std::optional<size_t> pop()
+    {
+        auto& l = m_lists.local();
+        if (!l.free.empty()) {
+            auto i = l.free.back();
+            l.free.pop_back();
+            return i;
+        }
+        if (l.slab_begin < l.slab_end) return l.slab_begin++;
+        return {};
+    }
+
+    /**
+     * @brief hands the slots [begin, end) to the calling thread, once its slab is used up
+     */
+    void reserve(size_t begin, size_t end)
+    {
+        auto& l = m_lists.local();
+        assert(l.slab_begin == l.slab_end);
+        l.slab_begin = begin;
+        l.slab_end = end;
+    }
+    /**
+     * @brief forgets the rest of the slabs, so that the next slots are reserved past the current
+     * capacity. Not thread safe.
+     */
+    void drop_slabs()
+    {
+        for (auto& l : m_lists) l.slab_begin = l.slab_end;
+    }
+
+    /**
+     * @brief frees a slot right away
+     */
+    void release(size_t i) { m_lists.local().free.push_back(i); }
+
+    void stage(size_t i) { m_lists.local().staged.push_back(i); }
+    void commit()
+    {
+        auto& l = m_lists.local();
+        l.free.insert(l.free.end(), l.staged.begin(), l.staged.end());
+        l.staged.clear();
+    }
+    void discard() { m_lists.local().staged.clear(); }
+
+    /**
+     * @brief forgets all the slots, e.g. when they are renumbered. Not thread safe.
+     */
+    void clear()
+    {
+        for (auto& l : m_lists) {
+            l.free = {};
+            l.staged.clear();
+            l.slab_begin = l.slab_end;
+        }
+    }
+
+    /**
+     * @return the number of free and reserved slots over all the threads. Not thread safe.
+     */
+    size_t size() const
+    {
+        size_t n = 0;
+        for (auto& l : m_lists) n += l.free.size() + (l.slab_end - l.slab_begin);
+        return n;
+    }
+
+private:
+    struct Lists
+    {
+        std::vector<size_t> free;
+        std::vector<size_t> staged;
+        size_t slab_begin = 0;
+        size_t slab_end = 0;
+    };
+    tbb::enumerable_thread_specific<Lists> m_lists;
+};
+
+} // namespace wmtk
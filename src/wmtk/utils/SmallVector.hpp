@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <type_traits>
+#include <vector>
+
+namespace wmtk {
+
+/**
+ * @brief A vector that stores up to N elements inline, and only allocates past them.
+ *
+ * It has the subset of the interface of std::vector used by the connectivity, for trivially
+ * copyable elements.
+ */
+template <typename T, size_t N>
+class SmallVector
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SmallVector copies its elements bytewise");
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+    SmallVector(std::initializer_list<T> l) { assign(l.begin(), l.end()); }
+    template <typename It>
+    SmallVector(It first, It last)
+    {
+        assign(first, last);
+    }
+    explicit SmallVector(const std::vector<T>& v) { assign(v.begin(), v.end()); }
+    SmallVector(const SmallVector& o) { assign(o.begin(), o.end()); }
+    SmallVector(SmallVector&& o) noexcept { steal(o); }
+    ~SmallVector() { free(); }
+
+    SmallVector& operator=(const SmallVector& o)
+    {
+        if (this != &o) assign(o.begin(), o.end());
+        return *this;
+    }
+    SmallVector& operator=(SmallVector&& o) noexcept
+    {
+        if (this != &o) {
+            free();
+            steal(o);
+        }
+        return *this;
+    }
+    SmallVector& operator=(const std::vector<T>& v)
+    {
+        assign(v.begin(), v.end());
+        return *this;
+    }
+
+    template <typename It>
+    void assign(It first, It last)
+    {
+        const size_t n = std::distance(first, last);
+        m_size = 0;
+        reserve(n);
+        std::copy(first, last, m_data);
+        m_size = n;
+    }
+
+    iterator begin() { return m_data; }
+    iterator end() { return m_data + m_size; }
+    const_iterator begin() const { return m_data; }
+    const_iterator end() const { return m_data + m_size; }
+    T* data() { return m_data; }
+    const T* data() const { return m_data; }
+
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    bool empty() const { return m_size == 0; }
+    /**
+     * @return if the elements are stored inline, without any allocation
+     */
+    bool is_inline() const { return m_data == m_inline; }
+
+    T& operator[](size_t i)
+    {
+        assert(i < m_size);
+        return m_data[i];
+    }
+    const T& operator[](size_t i) const
+    {
+        assert(i < m_size);
+        return m_data[i];
+    }
+    T& front() { return (*this)[0]; }
+    const T& front() const { return (*this)[0]; }
+    T& back() { return (*this)[m_size - 1]; }
+    const T& back() const { return (*this)[m_size - 1]; }
+
+    void reserve(size_t n)
+    {
+        if (n <= m_capacity) return;
+        const size_t capacity = std::max(n, 2 * size_t(m_capacity));
+        T* data = new T[capacity];
+        std::copy(begin(), end(), data);
+        free();
+        m_data = data;
+        m_capacity = capacity;
+    }
+    void resize(size_t n, const T& val = T())
+    {
+        reserve(n);
+        if (n > m_size) std::fill(m_data + m_size, m_data + n, val);
+        m_size = n;
+    }
+    /**
+     * @brief empties the vector, keeping its storage
+     */
+    void clear() { m_size = 0; }
+
+    void push_back(const T& val)
+    {
+        if (m_size == m_capacity) {
+            const T copy = val; // val may live in the storage being reallocated
+            reserve(m_size + 1);
+            m_data[m_size++] = copy;
+        } else {
+            m_data[m_size++] = val;
+        }
+    }
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        push_back(T(std::forward<Args>(args)...));
+        return back();
+    }
+    void pop_back()
+    {
+        assert(m_size > 0);
+        m_size--;
+    }
+
+    iterator insert(const_iterator pos, const T& val)
+    {
+        const size_t i = pos - m_data;
+        assert(i <= m_size);
+        const T copy = val;
+        reserve(m_size + 1);
+        std::copy_backward(m_data + i, m_data + m_size, m_data + m_size + 1);
+        m_data[i] = copy;
+        m_size++;
+        return m_data + i;
+    }
+    iterator erase(const_iterator pos)
+    {
+        const size_t i = pos - m_data;
+        assert(i < m_size);
+        std::copy(m_data + i + 1, m_data + m_size, m_data + i);
+        m_size--;
+        return m_data + i;
+    }
+
+    friend bool operator==(const SmallVector& l, const SmallVector& r)
+    {
+        return std::equal(l.begin(), l.end(), r.begin(), r.end());
+    }
+    friend bool operator!=(const SmallVector& l, const SmallVector& r) { return !(l == r); }
+
+private:
+    void free()
+    {
+        if (!is_inline()) delete[] m_data;
+        m_data = m_inline;
+        m_capacity = N;
+    }
+    // takes the elements of o, which is left empty
+    void steal(SmallVector& o)
+    {
+        if (o.is_inline()) {
+            std::copy(o.begin(), o.end(), m_inline);
+            m_data = m_inline;
+            m_capacity = N;
+        } else {
+            m_data = o.m_data;
+            m_capacity = o.m_capacity;
+        }
+        m_size = o.m_size;
+        o.m_data = o.m_inline;
+        o.m_capacity = N;
+        o.m_size = 0;
+    }
+
+    T* m_data = m_inline;
+    uint32_t m_size = 0;
+    uint32_t m_capacity = N;
+    T m_inline[N];
+};
+
+} // namespace wmtk
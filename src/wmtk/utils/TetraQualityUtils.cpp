@@ -1,5 +1,6 @@
 #include "TetraQualityUtils.hpp"
 
+#include "AMIPS.h"
 #include "Logger.hpp"
 
 #include <Eigen/Core>
@@ -27,7 +28,20 @@ std::array<size_t, 4> wmtk::orient_preserve_tet_reorder(
     return newconn;
 }
 
-// TODO: These three functions should not be in global namespace
+// TODO: These functions should not be in global namespace
+auto newton_direction_from_sums = [](double total_energy,
+                                     const Eigen::Vector3d& total_jac,
+                                     const Eigen::Matrix3d& total_hess) -> Eigen::Vector3d {
+    Eigen::Vector3d x = total_hess.ldlt().solve(total_jac);
+    wmtk::logger().trace("energy {}", total_energy);
+    if (total_jac.isApprox(total_hess * x)) // a hacky PSD trick. TODO: change this.
+        return -x;
+    else {
+        wmtk::logger().trace("gradient descent instead.");
+        return -total_jac;
+    }
+};
+
 auto newton_direction = [](auto& compute_energy,
                            auto& compute_jacobian,
                            auto& compute_hessian,
@@ -54,14 +68,7 @@ auto newton_direction = [](auto& compute_energy,
         total_hess += hess;
         assert(!std::isnan(total_energy));
     }
-    Eigen::Vector3d x = total_hess.ldlt().solve(total_jac);
-    wmtk::logger().trace("energy {}", total_energy);
-    if (total_jac.isApprox(total_hess * x)) // a hacky PSD trick. TODO: change this.
-        return -x;
-    else {
-        wmtk::logger().trace("gradient descent instead.");
-        return -total_jac;
-    }
+    return newton_direction_from_sums(total_energy, total_jac, total_hess);
 };
 
 
@@ -99,6 +106,24 @@ auto linesearch = [](auto&& energy_from_point,
     return pos;
 };
 
+auto newton_iterations = [](auto&& energy_from_point,
+                            const Eigen::Vector3d& pos,
+                            auto&& direction_from_point) {
+    auto current_pos = pos;
+    auto line_search_iters = 12;
+    auto newton_iters = 10;
+    for (auto iter = 0; iter < newton_iters; iter++) {
+        auto dir = direction_from_point(current_pos);
+        auto newpos = linesearch(energy_from_point, current_pos, dir, line_search_iters);
+        if ((newpos - current_pos).norm() < 1e-9) // barely moves
+        {
+            break;
+        }
+        current_pos = newpos;
+    }
+    return current_pos;
+};
+
 Eigen::Vector3d wmtk::newton_method_from_stack(
     std::vector<std::array<double, 12>>& assembles,
     std::function<double(const std::array<double, 12>&)> compute_energy,
@@ -120,29 +145,59 @@ Eigen::Vector3d wmtk::newton_method_from_stack(
         return total_energy;
     };
 
-    auto compute_new_valid_pos =
-        [&energy_from_point, &assembles, &compute_energy, &compute_jacobian, &compute_hessian](
-            const Eigen::Vector3d& pos) {
-            auto current_pos = pos;
-            auto line_search_iters = 12;
-            auto newton_iters = 10;
-            for (auto iter = 0; iter < newton_iters; iter++) {
-                auto dir = newton_direction(
-                    compute_energy,
-                    compute_jacobian,
-                    compute_hessian,
-                    assembles,
-                    current_pos);
-                auto newpos = linesearch(energy_from_point, current_pos, dir, line_search_iters);
-                if ((newpos - current_pos).norm() < 1e-9) // barely moves
-                {
-                    break;
-                }
-                current_pos = newpos;
+    return newton_iterations(energy_from_point, old_pos, [&](const Eigen::Vector3d& pos) {
+        return newton_direction(compute_energy, compute_jacobian, compute_hessian, assembles, pos);
+    });
+}
+
+Eigen::Vector3d wmtk::AMIPS_newton_method_from_stack(
+    const std::vector<std::array<double, 12>>& assembles)
+{
+    assert(!assembles.empty());
+    auto& T0 = assembles.front();
+    Eigen::Vector3d old_pos(T0[0], T0[1], T0[2]);
+
+    std::vector<AMIPSBatch> batches((assembles.size() + AMIPS_BATCH_SIZE - 1) / AMIPS_BATCH_SIZE);
+    for (size_t i = 0; i < assembles.size(); i++)
+        batches[i / AMIPS_BATCH_SIZE].push_back(assembles[i]);
+    auto move_front_point = [&batches](const Eigen::Vector3d& pos) {
+        for (auto& b : batches)
+            for (auto j = 0; j < 3; j++) b.T[j].fill(pos[j]);
+    };
+
+    // the sums are accumulated in the order of the stack, like newton_method_from_stack
+    auto energy_from_point = [&](const Eigen::Vector3d& pos) -> double {
+        move_front_point(pos);
+        auto total_energy = 0.;
+        AMIPSLanes energy;
+        for (auto& b : batches) {
+            AMIPS_energy_batch(b, energy);
+            for (auto i = 0; i < b.size; i++) total_energy += energy[i];
+        }
+        return total_energy;
+    };
+    auto direction_from_point = [&](const Eigen::Vector3d& pos) -> Eigen::Vector3d {
+        move_front_point(pos);
+        auto total_energy = 0.;
+        Eigen::Vector3d total_jac = Eigen::Vector3d::Zero();
+        Eigen::Matrix3d total_hess = Eigen::Matrix3d::Zero();
+        AMIPSLanes energy;
+        std::array<AMIPSLanes, 3> jac;
+        std::array<AMIPSLanes, 9> hess;
+        for (auto& b : batches) {
+            AMIPS_energy_batch(b, energy);
+            AMIPS_jacobian_batch(b, jac);
+            AMIPS_hessian_batch(b, hess);
+            for (auto i = 0; i < b.size; i++) {
+                total_energy += energy[i];
+                for (auto k = 0; k < 3; k++) total_jac[k] += jac[k][i];
+                for (auto k = 0; k < 9; k++) total_hess(k / 3, k % 3) += hess[k][i];
             }
-            return current_pos;
-        };
-    return compute_new_valid_pos(old_pos);
+            assert(!std::isnan(total_energy));
+        }
+        return newton_direction_from_sums(total_energy, total_jac, total_hess);
+    };
+    return newton_iterations(energy_from_point, old_pos, direction_from_point);
 }
 
 Eigen::Vector3d wmtk::gradient_descent_from_stack(
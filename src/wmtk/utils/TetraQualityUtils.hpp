@@ -18,6 +18,12 @@ Eigen::Vector3d newton_method_from_stack(
     std::function<void(const std::array<double, 12>&, Eigen::Vector3d&)> jacobian,
     std::function<void(const std::array<double, 12>&, Eigen::Matrix3d&)> hessian);
 
+/**
+ * newton_method_from_stack with the AMIPS energy, evaluated with the batched kernels, which give
+ * the same position.
+ */
+Eigen::Vector3d AMIPS_newton_method_from_stack(const std::vector<std::array<double, 12>>& stack);
+
 Eigen::Vector3d gradient_descent_from_stack(
     std::vector<std::array<double, 12>>& stack,
     std::function<double(const std::array<double, 12>&)> energy,
@@ -12,16 +12,59 @@
 
 namespace wmtk {
 
-template <class T>
-inline std::vector<T> set_intersection(const std::vector<T>& v1, const std::vector<T>& v2)
+template <class A, class B>
+inline std::vector<typename A::value_type> set_intersection(const A& v1, const B& v2)
 {
     
-    std::vector<T> v;
+    std::vector<typename A::value_type> v;
     v.reserve(std::min(v1.size(), v2.size()));
     std::set_intersection(v1.begin(), v1.end(), v2.begin(), v2.end(), std::back_inserter(v));
     return v;
 }
 
+/**
+ * @brief visit the common elements of two sorted ranges in order, by merging them without any
+ * allocation
+ */
+template <class A, class B, typename Visitor>
+inline void set_intersection_for_each(const A& v1, const B& v2, Visitor&& visit)
+{
+    auto i1 = v1.begin();
+    auto i2 = v2.begin();
+    while (i1 != v1.end() && i2 != v2.end()) {
+        if (*i1 < *i2)
+            ++i1;
+        else if (*i2 < *i1)
+            ++i2;
+        else {
+            visit(*i1);
+            ++i1;
+            ++i2;
+        }
+    }
+}
+
+/**
+ * @brief the smallest common element of two sorted ranges, found by merging them up to it
+ *
+ * @return an iterator to it in v1, or v1.end() if there is none
+ */
+template <class A, class B>
+inline auto set_intersection_first(const A& v1, const B& v2)
+{
+    auto i1 = v1.begin();
+    auto i2 = v2.begin();
+    while (i1 != v1.end() && i2 != v2.end()) {
+        if (*i1 < *i2)
+            ++i1;
+        else if (*i2 < *i1)
+            ++i2;
+        else
+            return i1;
+    }
+    return v1.end();
+}
+
 template <class T>
 inline void vector_unique(std::vector<T>& v)
 {
@@ -51,8 +94,8 @@ inline void vector_sort(std::vector<T>& v)
     std::sort(v.begin(), v.end());
 }
 
-template <class T>
-inline bool vector_erase(std::vector<T>& v, const T& t)
+template <class V>
+inline bool vector_erase(V& v, const typename V::value_type& t)
 {
     
     auto it = std::find(v.begin(), v.end(), t);
@@ -61,8 +104,8 @@ inline bool vector_erase(std::vector<T>& v, const T& t)
     return true;
 }
 
-template <class T>
-inline bool vector_contains(std::vector<T>& v, const T& t)
+template <class V>
+inline bool vector_contains(const V& v, const typename V::value_type& t)
 {
     
 
@@ -71,8 +114,8 @@ inline bool vector_contains(std::vector<T>& v, const T& t)
     return true;
 }
 
-template <typename T>
-inline bool set_erase(std::vector<T>& v, const T& t)
+template <typename V>
+inline bool set_erase(V& v, const typename V::value_type& t)
 {
     
     auto it = std::lower_bound(v.begin(), v.end(), t);
@@ -81,8 +124,8 @@ inline bool set_erase(std::vector<T>& v, const T& t)
     return true;
 }
 
-template <typename T>
-inline bool set_insert(std::vector<T>& vec, const T& val)
+template <typename V>
+inline bool set_insert(V& vec, const typename V::value_type& val)
 {
     
     auto it = std::lower_bound(vec.begin(), vec.end(), val);
@@ -11,6 +11,7 @@
 #include <wmtk/utils/EnableWarnings.hpp>
 // clang-format on
 
+#include <wmtk/ExecutionContext.hpp>
 #include <wmtk/utils/Morton.h>
 
 void wmtk::partition_vertex_morton(
@@ -19,7 +20,7 @@ void wmtk::partition_vertex_morton(
     int num_partition,
     std::vector<size_t>& result)
 {
-    tbb::task_arena arena(num_partition);
+    auto& arena = ExecutionContext::instance().arena(num_partition);
 
     std::vector<Eigen::Vector3d> V_v(vert_size);
     arena.execute([&] {
@@ -107,4 +108,49 @@ void wmtk::partition_vertex_morton(
                 }
             });
     });
-}
\ No newline at end of file
+}
+
+void wmtk::sort_vertices_morton(
+    std::vector<size_t>& vids,
+    const std::function<Eigen::Vector3d(size_t)>& pos)
+{
+    if (vids.empty()) return;
+
+    std::vector<Eigen::Vector3d> V(vids.size());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, vids.size()),
+        [&](tbb::blocked_range<size_t> r) {
+            for (auto i = r.begin(); i < r.end(); i++) V[i] = pos(vids[i]);
+        });
+    Eigen::Vector3d vmin = V.front(), vmax = V.front();
+    for (auto& v : V) {
+        vmin = vmin.cwiseMin(v);
+        vmax = vmax.cwiseMax(v);
+    }
+
+    // the positions are quantized on 20 bits per axis, the 21st bit of the code is reserved for
+    // the sign. The aspect ratio is kept.
+    const double extent = (vmax - vmin).maxCoeff();
+    const double scale = extent > 0 ? ((1 << 20) - 1) / extent : 0.;
+    std::vector<std::pair<Resorting::MortonCode64, size_t>> list_v(vids.size());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, vids.size()),
+        [&](tbb::blocked_range<size_t> r) {
+            for (auto i = r.begin(); i < r.end(); i++) {
+                Eigen::Vector3d q = (V[i] - vmin) * scale;
+                list_v[i].first =
+                    Resorting::MortonCode64(uint32_t(q[0]), uint32_t(q[1]), uint32_t(q[2]));
+                list_v[i].second = vids[i];
+            }
+        });
+
+    // ties are broken by vid, so that the order is deterministic
+    tbb::parallel_sort(list_v.begin(), list_v.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first || (a.first == b.first && a.second < b.second);
+    });
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, vids.size()),
+        [&](tbb::blocked_range<size_t> r) {
+            for (auto i = r.begin(); i < r.end(); i++) vids[i] = list_v[i].second;
+        });
+}
@@ -9,4 +9,11 @@ void partition_vertex_morton(
     const std::function<Eigen::Vector3d(size_t)>& pos,
     int num_partition,
     std::vector<size_t>&);
+
+/**
+ * @brief sorts the vertex ids along the Morton order of their positions, in parallel.
+ */
+void sort_vertices_morton(
+    std::vector<size_t>& vids,
+    const std::function<Eigen::Vector3d(size_t)>& pos);
 }
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include <catch2/catch.hpp>
 #include <highfive/H5File.hpp>
 #include <iostream>
+#include <numeric>
+#include <random>
 
 
 // template <>
@@ -509,3 +511,216 @@ TEST_CASE("split_operation", "[test_2d_operation]")
     }
 }
 
+
+TEST_CASE("consolidate_ordering", "[test_2d_operation]")
+{
+    // each attribute stores the id of its element before the consolidation
+    class LabeledMesh : public TriMesh
+    {
+    public:
+        AttributeCollection<size_t> vertex_labels, edge_labels, face_labels;
+        LabeledMesh()
+        {
+            p_vertex_attrs = &vertex_labels;
+            p_edge_attrs = &edge_labels;
+            p_face_attrs = &face_labels;
+        }
+    };
+
+    const size_t n = 200;
+    std::vector<std::array<size_t, 3>> tris;
+    for (size_t i = 0; i < n; i++) tris.push_back({{i, i + 1, i + 2}});
+    LabeledMesh m;
+    m.NUM_THREADS = 4;
+    m.create_mesh(n + 2, tris);
+    m.vertex_labels.resize(m.vert_capacity());
+    m.edge_labels.resize(3 * m.tri_capacity());
+    m.face_labels.resize(m.tri_capacity());
+
+    wmtk::TriMeshEdgeCollapseOperation collapse_op;
+    auto edges = m.get_edges();
+    for (size_t i = 0; i < edges.size(); i += 7) {
+        if (edges[i].is_valid(m)) collapse_op(m, edges[i]);
+    }
+    REQUIRE(m.vert_capacity() > m.get_vertices().size());
+    REQUIRE(m.tri_capacity() > m.get_faces().size());
+
+    std::vector<size_t> old_vids;
+    for (auto& v : m.get_vertices()) old_vids.push_back(v.vid(m));
+    std::sort(old_vids.begin(), old_vids.end());
+    std::vector<std::pair<size_t, std::array<size_t, 3>>> old_tris;
+    for (auto& f : m.get_faces()) old_tris.emplace_back(f.fid(m), m.oriented_tri_vids(f));
+    std::sort(old_tris.begin(), old_tris.end());
+    for (size_t i = 0; i < m.vert_capacity(); i++) m.vertex_labels[i] = i;
+    for (size_t i = 0; i < 3 * m.tri_capacity(); i++) m.edge_labels[i] = i;
+    for (size_t i = 0; i < m.tri_capacity(); i++) m.face_labels[i] = i;
+
+    m.consolidate_mesh();
+    REQUIRE(m.vert_capacity() == old_vids.size());
+    REQUIRE(m.tri_capacity() == old_tris.size());
+    for (size_t i = 0; i < old_vids.size(); i++) REQUIRE(m.vertex_labels[i] == old_vids[i]);
+    for (size_t i = 0; i < old_tris.size(); i++) {
+        auto& [old_fid, old_tri] = old_tris[i];
+        REQUIRE(m.face_labels[i] == old_fid);
+        for (auto j = 0; j < 3; j++) REQUIRE(m.edge_labels[3 * i + j] == 3 * old_fid + j);
+        auto tri = m.oriented_tri_vids(m.tuple_from_tri(i));
+        for (auto j = 0; j < 3; j++) REQUIRE(m.vertex_labels[tri[j]] == old_tri[j]);
+    }
+    REQUIRE(m.check_mesh_connectivity_validity());
+}
+
+TEST_CASE("consolidate_morton", "[test_2d_operation]")
+{
+    // a grid of n x n vertices whose ids are shuffled
+    class PositionedMesh : public TriMesh
+    {
+    public:
+        AttributeCollection<Eigen::Vector3d> positions;
+        // the edges are labeled by the sorted grid indices of their vertices
+        AttributeCollection<std::array<size_t, 2>> edge_labels;
+        PositionedMesh()
+        {
+            p_vertex_attrs = &positions;
+            p_edge_attrs = &edge_labels;
+        }
+    };
+
+    const size_t n = 30;
+    std::vector<size_t> perm(n * n);
+    std::iota(perm.begin(), perm.end(), 0);
+    std::shuffle(perm.begin(), perm.end(), std::mt19937(0));
+    std::vector<std::array<size_t, 3>> tris;
+    for (size_t i = 0; i + 1 < n; i++) {
+        for (size_t j = 0; j + 1 < n; j++) {
+            const size_t v = i * n + j;
+            tris.push_back({{perm[v], perm[v + 1], perm[v + n + 1]}});
+            tris.push_back({{perm[v], perm[v + n + 1], perm[v + n]}});
+        }
+    }
+    PositionedMesh m;
+    m.NUM_THREADS = 4;
+    m.create_mesh(n * n, tris);
+    m.positions.resize(n * n);
+    for (size_t v = 0; v < n * n; v++) m.positions[perm[v]] = Eigen::Vector3d(v / n, v % n, 0);
+    auto edge_label = [&m](const TriMesh::Tuple& e) {
+        auto grid_index = [&m](size_t vid) {
+            return size_t(m.positions[vid][0]) * n + size_t(m.positions[vid][1]);
+        };
+        const size_t i0 = grid_index(e.vid(m)), i1 = grid_index(e.switch_vertex(m).vid(m));
+        return std::array<size_t, 2>{{std::min(i0, i1), std::max(i0, i1)}};
+    };
+    m.edge_labels.resize(3 * m.tri_capacity());
+    for (auto& e : m.get_edges()) m.edge_labels[e.eid(m)] = edge_label(e);
+
+    auto average_span = [&m]() {
+        double span = 0;
+        for (auto& f : m.get_faces()) {
+            auto tri = m.oriented_tri_vids(f);
+            span += *std::max_element(tri.begin(), tri.end()) -
+                    *std::min_element(tri.begin(), tri.end());
+        }
+        return span / m.tri_capacity();
+    };
+    const double span_before = average_span();
+    m.consolidate_mesh([&m](size_t i) { return m.positions[i]; });
+    REQUIRE(m.check_mesh_connectivity_validity());
+    REQUIRE(average_span() * 5 < span_before);
+    for (auto& f : m.get_faces()) {
+        auto tri = m.oriented_tri_vids(f);
+        const Eigen::Vector3d e0 = m.positions[tri[1]] - m.positions[tri[0]];
+        const Eigen::Vector3d e1 = m.positions[tri[2]] - m.positions[tri[0]];
+        REQUIRE(std::abs(e0[0] * e1[1] - e0[1] * e1[0]) == 1); // the triangles are unchanged
+    }
+    // a shared edge keeps its value in the slot of its triangle of smallest new fid
+    for (size_t i = 0; i < m.tri_capacity(); i++) {
+        for (size_t j = 0; j < 3; j++) {
+            auto e = m.tuple_from_edge(i, j);
+            REQUIRE(m.edge_labels[e.eid(m)] == edge_label(e));
+        }
+    }
+}
+
+TEST_CASE("tri_element_counts", "[test_2d_operation]")
+{
+    // rejects every third operation, so that the counts are also rolled back
+    class RejectingMesh : public TriMesh
+    {
+    public:
+        int cnt = 0;
+        bool invariants(const std::vector<Tuple>&) override { return cnt++ % 3 != 0; }
+    };
+
+    // a grid of n x n squares, each split into two triangles
+    const size_t n = 10;
+    std::vector<std::array<size_t, 3>> tris;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++) {
+            const size_t v = i * (n + 1) + j;
+            tris.push_back({{v, v + 1, v + n + 2}});
+            tris.push_back({{v, v + n + 2, v + n + 1}});
+        }
+    RejectingMesh m;
+    m.create_mesh((n + 1) * (n + 1), tris);
+    auto check_counts = [&m]() {
+        REQUIRE(m.vertex_size() == m.get_vertices().size());
+        REQUIRE(m.tri_size() == m.get_faces().size());
+    };
+    check_counts();
+
+    wmtk::TriMeshSplitEdgeOperation split_op;
+    wmtk::TriMeshEdgeCollapseOperation collapse_op;
+    auto rng = std::mt19937(7);
+    for (auto round = 0; round < 4; round++) {
+        auto edges = m.get_edges();
+        std::shuffle(edges.begin(), edges.end(), rng);
+        for (auto& e : edges) {
+            if (!e.is_valid(m)) continue;
+            if (rng() % 2 == 0)
+                split_op(m, e);
+            else
+                collapse_op(m, e);
+        }
+        check_counts();
+    }
+
+    m.consolidate_mesh();
+    REQUIRE(m.vertex_size() == m.vert_capacity());
+    REQUIRE(m.tri_size() == m.tri_capacity());
+    check_counts();
+}
+
+TEST_CASE("one_ring_visitors", "[test_2d_operation]")
+{
+    // a fan of 4 tris around vertex 0, open along the edges 0-1 and 0-5
+    TriMesh m;
+    m.create_mesh(6, {{{0, 1, 2}}, {{0, 2, 3}}, {{0, 3, 4}}, {{0, 4, 5}}});
+    auto v = m.tuple_from_vertex(0);
+
+    std::vector<size_t> tris;
+    m.for_each_tri_around_vertex(v, [&](const TriMesh::Tuple& t) {
+        REQUIRE(t.vid(m) == 0);
+        tris.push_back(t.fid(m));
+    });
+    REQUIRE(tris == std::vector<size_t>{{0, 1, 2, 3}});
+
+    auto edges = m.get_one_ring_edges_for_vertex(v);
+    REQUIRE(edges.size() == 5);
+    const auto& scratch = m.get_one_ring_edges_for_vertex_scratch(v);
+    REQUIRE(scratch.size() == edges.size());
+    for (size_t i = 0; i < edges.size(); i++) REQUIRE(scratch[i].vid(m) == edges[i].vid(m));
+    REQUIRE(m.get_one_ring_tris_for_vertex_scratch(v).size() == 4);
+}
+
+TEST_CASE("reduce_2d_elements", "[test_2d_operation]")
+{
+    TriMesh m;
+    m.create_mesh(6, {{{0, 1, 2}}, {{0, 2, 3}}, {{0, 3, 4}}, {{0, 4, 5}}});
+    auto count = [](size_t& cnt, auto&) { cnt++; };
+    auto add = [](size_t a, size_t b) { return a + b; };
+    for (int n_threads : {1, 4}) {
+        m.NUM_THREADS = n_threads;
+        REQUIRE(m.reduce_face(size_t(0), count, add) == 4);
+        REQUIRE(m.reduce_vertex(size_t(0), count, add) == 6);
+        REQUIRE(m.reduce_edge(size_t(0), count, add) == 9);
+    }
+}
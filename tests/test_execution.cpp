@@ -0,0 +1,325 @@
+#include <wmtk/ExecutionScheduler.hpp>
+#include <wmtk/TetMesh.h>
+#include <wmtk/TriMesh.h>
+#include <wmtk/TriMeshOperation.h>
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <limits>
+
+using namespace wmtk;
+
+namespace {
+// a strip of tets where all vertices are put into a single partition, leaving the other
+// partitions empty.
+class UnbalancedTetMesh : public TetMesh
+{
+public:
+    std::atomic_int cnt_smooth = 0;
+    bool reject_smooth = false;
+    std::vector<size_t> partition_ids;
+
+    UnbalancedTetMesh(size_t n_tets, int num_threads)
+    {
+        NUM_THREADS = num_threads;
+        std::vector<std::array<size_t, 4>> tets;
+        for (size_t i = 0; i < n_tets; i++) tets.push_back({{i, i + 1, i + 2, i + 3}});
+        init(n_tets + 3, tets);
+        partition_ids.resize(n_tets + 3, 0);
+    }
+
+    size_t get_partition_id(const Tuple& loc) const { return partition_ids[loc.vid(*this)]; }
+
+    bool smooth_after(const Tuple&) override
+    {
+        cnt_smooth++;
+        return !reject_smooth;
+    }
+};
+
+// records whether two operations with overlapping one-rings ever run at the same time
+class ConflictCheckingTetMesh : public UnbalancedTetMesh
+{
+public:
+    std::vector<std::atomic_bool> in_use;
+    std::atomic_bool overlapped = false;
+
+    ConflictCheckingTetMesh(size_t n_tets, int num_threads)
+        : UnbalancedTetMesh(n_tets, num_threads)
+        , in_use(n_tets + 3)
+    {}
+
+    std::vector<size_t> closed_one_ring(const Tuple& t) const
+    {
+        auto vids = get_one_ring_vids_for_vertex(t.vid(*this));
+        vids.push_back(t.vid(*this));
+        return vids;
+    }
+
+    bool smooth_before(const Tuple& t) override
+    {
+        for (auto v : closed_one_ring(t))
+            if (in_use[v].exchange(true)) overlapped = true;
+        return true;
+    }
+
+    bool smooth_after(const Tuple& t) override
+    {
+        UnbalancedTetMesh::smooth_after(t);
+        for (auto v : closed_one_ring(t)) in_use[v] = false;
+        return true;
+    }
+};
+
+class CountingTriMesh : public TriMesh
+{
+public:
+    int cnt_static_smooth = 0;
+};
+
+// smoothing that is run through the compile-time operation list of ExecutePass
+class CountingSmoothOperation : public TriMeshOperationShim<
+                                    CountingTriMesh,
+                                    CountingSmoothOperation,
+                                    TriMeshSmoothVertexOperation>
+{
+public:
+    ExecuteReturnData execute(CountingTriMesh& m, const Tuple& t)
+    {
+        return TriMeshSmoothVertexOperation::execute(m, t);
+    }
+    bool before(CountingTriMesh& m, const Tuple& t)
+    {
+        m.cnt_static_smooth++;
+        return TriMeshSmoothVertexOperation::before(m, t);
+    }
+    bool after(CountingTriMesh& m, ExecuteReturnData& ret_data)
+    {
+        return TriMeshSmoothVertexOperation::after(m, ret_data);
+    }
+    bool invariants(CountingTriMesh& m, ExecuteReturnData& ret_data)
+    {
+        return TriMeshSmoothVertexOperation::invariants(m, ret_data);
+    }
+};
+
+template <ExecutionPolicy policy>
+void smooth_all(UnbalancedTetMesh& m)
+{
+    auto ops = std::vector<std::pair<std::string, TetMesh::Tuple>>();
+    for (auto& v : m.get_vertices()) ops.emplace_back("vertex_smooth", v);
+    auto executor = ExecutePass<UnbalancedTetMesh, policy>();
+    executor.num_threads = m.NUM_THREADS;
+    executor.lock_vertices = [](auto& m, const auto& e, int task_id) -> bool {
+        return m.try_set_vertex_mutex_one_ring(e, task_id);
+    };
+    executor(m, ops);
+}
+} // namespace
+
+TEST_CASE("execute_pass_work_stealing", "[scheduler]")
+{
+    UnbalancedTetMesh m(200, 4);
+    smooth_all<ExecutionPolicy::kStealing>(m);
+    REQUIRE(m.cnt_smooth == m.vertex_size());
+    REQUIRE(m.check_mesh_connectivity_validity());
+}
+
+TEST_CASE("execute_pass_work_stealing_single_thread", "[scheduler]")
+{
+    UnbalancedTetMesh m(20, 1);
+    smooth_all<ExecutionPolicy::kStealing>(m);
+    REQUIRE(m.cnt_smooth == m.vertex_size());
+}
+
+TEST_CASE("execute_pass_color", "[scheduler]")
+{
+    ConflictCheckingTetMesh m(200, 4);
+    auto ops = std::vector<std::pair<std::string, TetMesh::Tuple>>();
+    for (auto& v : m.get_vertices()) ops.emplace_back("vertex_smooth", v);
+    auto executor = ExecutePass<ConflictCheckingTetMesh, ExecutionPolicy::kColor>();
+    executor.num_threads = m.NUM_THREADS;
+    SECTION("default two-ring conflict region") {}
+    SECTION("one-ring conflict region")
+    {
+        executor.conflict_vertices = [](auto& m, auto, const auto& e) {
+            return m.closed_one_ring(e);
+        };
+    }
+    executor(m, ops);
+    REQUIRE(m.cnt_smooth == m.vertex_size());
+    REQUIRE_FALSE(m.overlapped);
+}
+
+TEST_CASE("execute_pass_color_split", "[scheduler]")
+{
+    UnbalancedTetMesh m(50, 4);
+    auto ops = std::vector<std::pair<std::string, TetMesh::Tuple>>();
+    for (auto& e : m.get_edges()) ops.emplace_back("edge_split", e);
+    auto executor = ExecutePass<UnbalancedTetMesh, ExecutionPolicy::kColor>();
+    executor.num_threads = m.NUM_THREADS;
+    executor(m, ops);
+    REQUIRE(m.vertex_size() > 53);
+    REQUIRE(m.check_mesh_connectivity_validity());
+}
+
+TEST_CASE("execute_pass_retry_rounds", "[scheduler]")
+{
+    UnbalancedTetMesh m(200, 4);
+    for (size_t i = 0; i < m.partition_ids.size(); i++)
+        m.partition_ids[i] = i * 4 / m.partition_ids.size();
+    auto ops = std::vector<std::pair<std::string, TetMesh::Tuple>>();
+    for (auto& v : m.get_vertices()) ops.emplace_back("vertex_smooth", v);
+
+    // every first locking attempt fails, so all the operations end up in the retry queue
+    auto attempts = std::vector<std::atomic_int>(m.vert_capacity());
+    auto executor = ExecutePass<UnbalancedTetMesh, ExecutionPolicy::kPartition>();
+    executor.num_threads = m.NUM_THREADS;
+    executor.max_retry_limit = 1;
+    executor.lock_vertices = [&attempts](auto& m, const auto& e, int task_id) -> bool {
+        return attempts[e.vid(m)]++ > 0;
+    };
+    executor(m, ops);
+    REQUIRE(m.cnt_smooth == m.vertex_size());
+}
+
+TEST_CASE("execute_pass_telemetry", "[scheduler]")
+{
+    UnbalancedTetMesh m(100, 2);
+    for (size_t i = 0; i < m.partition_ids.size(); i++)
+        m.partition_ids[i] = i * 2 / m.partition_ids.size();
+    auto ops = std::vector<std::pair<std::string, TetMesh::Tuple>>();
+    for (auto& v : m.get_vertices()) ops.emplace_back("vertex_smooth", v);
+
+    auto attempts = std::vector<std::atomic_int>(m.vert_capacity());
+    auto executor = ExecutePass<UnbalancedTetMesh, ExecutionPolicy::kPartition>();
+    executor.num_threads = m.NUM_THREADS;
+    executor.collect_telemetry = true;
+    executor.telemetry_sampling_frequency = 10;
+    executor.lock_vertices = [&attempts](auto& m, const auto& e, int task_id) -> bool {
+        return attempts[e.vid(m)]++ > 0;
+    };
+    executor(m, ops);
+
+    const auto& telemetry = executor.telemetry;
+    REQUIRE(telemetry.operations.at("vertex_smooth").success == m.vertex_size());
+    REQUIRE(telemetry.operations.at("vertex_smooth").lock_fail == m.vertex_size());
+    size_t lock_failures = 0;
+    for (auto n : telemetry.lock_failures_per_partition) lock_failures += n;
+    REQUIRE(lock_failures == m.vertex_size());
+    REQUIRE(telemetry.retry_histogram.size() == 2);
+    REQUIRE(telemetry.retry_histogram[1] == m.vertex_size());
+    REQUIRE(telemetry.queue_depths.size() == 2 * m.vertex_size() / 10);
+    REQUIRE(telemetry.busy_time.size() == 2);
+    REQUIRE(telemetry.idle_time.size() == 2);
+    REQUIRE(telemetry.phase_time[size_t(OperationPhase::kAfter)] > 0);
+    REQUIRE(telemetry.phase_time[size_t(OperationPhase::kRollback)] == 0);
+    REQUIRE(telemetry.total_time > 0);
+    REQUIRE(telemetry.to_json().find("\"vertex_smooth\"") != std::string::npos);
+
+    // the rejected operations are billed to the rollback phase
+    m.reject_smooth = true;
+    executor.lock_vertices = [](auto&, const auto&, int) { return true; };
+    executor(m, ops);
+    REQUIRE(executor.telemetry.operations.at("vertex_smooth").fail == m.vertex_size());
+    REQUIRE(executor.telemetry.phase_time[size_t(OperationPhase::kRollback)] > 0);
+}
+
+TEST_CASE("execute_pass_batched_renewal", "[scheduler]")
+{
+    UnbalancedTetMesh m(100, 4);
+    auto cnt_visits = std::vector<std::atomic_int>(m.vert_capacity());
+    // an operation that renews its own vertex until it has been visited 3 times
+    using Tuple = TetMesh::Tuple;
+    auto visit = [&cnt_visits](auto& m, const auto& t) -> std::optional<std::vector<Tuple>> {
+        cnt_visits[t.vid(m)]++;
+        return std::vector<Tuple>{t};
+    };
+    auto ops = std::vector<std::pair<std::string, TetMesh::Tuple>>();
+    for (auto& v : m.get_vertices()) ops.emplace_back("visit", v);
+
+    using Executor = ExecutePass<UnbalancedTetMesh, ExecutionPolicy::kStealing>;
+    auto executor = Executor({{"visit", visit}});
+    executor.num_threads = m.NUM_THREADS;
+    executor.renewal_batch_size = GENERATE(0, 2, 64);
+    const bool renew_with_names = GENERATE(true, false);
+    executor.renew_neighbor_tuples = [&cnt_visits, renew_with_names](
+                                         auto& m,
+                                         auto op,
+                                         const auto& tups) -> Executor::RenewedTuples {
+        // renewing with the interned operation skips the name lookup, with the same results
+        auto renewed_names = std::vector<std::pair<std::string, Tuple>>();
+        auto renewed_ops = std::vector<std::pair<InternedOp, Tuple>>();
+        for (auto& t : tups) {
+            if (cnt_visits[t.vid(m)] >= 3) continue;
+            if (renew_with_names)
+                renewed_names.emplace_back(op, t);
+            else
+                renewed_ops.emplace_back(op, t);
+        }
+        if (renew_with_names) return renewed_names;
+        return renewed_ops;
+    };
+    // the initial elements are interned from their names, the renewed ones keep the id
+    auto visit_id = std::atomic<size_t>(std::numeric_limits<size_t>::max());
+    auto cnt_wrong_ops = std::atomic_int(0);
+    auto kept_op = std::optional<InternedOp>();
+    executor.priority = [&visit_id, &cnt_wrong_ops, &kept_op](auto&, InternedOp op, const auto&) {
+        auto expected = std::numeric_limits<size_t>::max();
+        if (visit_id.compare_exchange_strong(expected, op.id())) kept_op = op;
+        if (op != "visit" || op.id() != visit_id) cnt_wrong_ops++;
+        return 0.;
+    };
+    executor.lock_vertices = [](auto& m, const auto& e, int task_id) -> bool {
+        return m.try_set_vertex_mutex_one_ring(e, task_id);
+    };
+    executor(m, ops);
+    for (auto& v : m.get_vertices()) REQUIRE(cnt_visits[v.vid(m)] == 3);
+    REQUIRE(cnt_wrong_ops == 0);
+    // the name of a copied InternedOp outlives the pass
+    REQUIRE(kept_op.has_value());
+    REQUIRE(kept_op->name() == "visit");
+
+    ops = {{"unknown", m.get_vertices().front()}};
+    REQUIRE_THROWS(executor(m, ops));
+}
+
+TEST_CASE("execute_pass_static_operations", "[scheduler]")
+{
+    CountingTriMesh m;
+    m.create_mesh(5, {{{0, 1, 2}}, {{0, 2, 3}}, {{0, 3, 4}}});
+    auto ops = std::vector<std::pair<std::string, TriMesh::Tuple>>();
+    for (auto& v : m.get_vertices()) ops.emplace_back("vertex_smooth", v);
+
+    // the compile-time operation takes precedence over the registered one of the same name
+    auto executor = ExecutePass<CountingTriMesh, ExecutionPolicy::kSeq, CountingSmoothOperation>();
+    executor.collect_telemetry = true;
+    executor(m, ops);
+    REQUIRE(m.cnt_static_smooth == 5);
+    REQUIRE(executor.telemetry.operations.at("vertex_smooth").success == 5);
+
+    // the virtual path of the shim still works
+    auto op = CountingSmoothOperation();
+    REQUIRE(op(static_cast<TriMesh&>(m), m.get_vertices().front()).success);
+    REQUIRE(m.cnt_static_smooth == 6);
+}
+
+TEST_CASE("execution_context_reuses_arenas", "[scheduler]")
+{
+    auto& context = ExecutionContext::instance();
+    REQUIRE(&context.arena(3) == &context.arena(3));
+
+    UnbalancedTetMesh m(200, 3);
+    const auto n_arenas = context.num_arenas();
+    for (bool pin : {false, true}) {
+        context.set_thread_pinning(pin);
+        std::atomic_int cnt = 0;
+        m.for_each_vertex([&](auto&) { cnt++; });
+        REQUIRE(cnt == 203);
+        REQUIRE(m.reduce_tetra(0, [](int& n, auto&) { n++; }, std::plus<int>()) == 200);
+    }
+    context.set_thread_pinning(false);
+    // the passes ran in the arena created above
+    REQUIRE(context.num_arenas() == n_arenas);
+}
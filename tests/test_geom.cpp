@@ -1,7 +1,15 @@
+#include <wmtk/utils/AMIPS.h>
+#include <wmtk/utils/FilteredPredicates.hpp>
 #include <wmtk/utils/GeoUtils.h>
+#include <wmtk/utils/GmpMemoryPool.hpp>
+#include <wmtk/utils/InsertTriangleUtils.hpp>
+#include <wmtk/utils/LazyRational.hpp>
+#include <wmtk/utils/TetraQualityUtils.hpp>
 
 #include <catch2/catch.hpp>
 
+#include <random>
+
 using namespace wmtk;
 using namespace Eigen;
 
@@ -213,4 +221,486 @@ TEST_CASE("segment_triangle_coplanar_3d", "[test_geom]")
 
     const auto res = segment_triangle_coplanar_3d(seg, tri);
     REQUIRE(res);
-}
\ No newline at end of file
+}
+TEST_CASE("orient3d_filtered", "[test_geom]")
+{
+    using Vector3r = Eigen::Matrix<Rational, 3, 1>;
+    auto point = [](double x, double y, double z) { return Vector3r(x, y, z); };
+    const Vector3r a = point(0, 0, 0), b = point(1, 0, 0), c = point(0, 1, 0);
+
+    // decided in doubles
+    for (double z : {1e-3, -1e-3, 1e3}) {
+        auto res = orient3d_filtered(
+            to_interval(a),
+            to_interval(b),
+            to_interval(c),
+            to_interval(point(0.3, 0.3, z)));
+        REQUIRE(res.has_value());
+        REQUIRE(*res == orient3d_t(a, b, c, point(0.3, 0.3, z)));
+    }
+
+    // a point at 1/3 of an edge is coplanar, which only the exact predicate can tell
+    Vector3r p = b * Rational(1. / 3) + c * (Rational(1) - Rational(1. / 3));
+    p[2] = Rational(1) / Rational(3) - Rational(1) / Rational(3);
+    REQUIRE(!orient3d_filtered(to_interval(a), to_interval(b), to_interval(c), to_interval(p)));
+    REQUIRE(orient3d_t(a, b, c, p) == 0);
+
+    // a point very slightly above the plane is left to the exact predicate as well
+    Vector3r q = point(0.25, 0.25, 0);
+    q[2] = Rational(1e-300) * Rational(1e-300);
+    REQUIRE(!orient3d_filtered(to_interval(a), to_interval(b), to_interval(c), to_interval(q)));
+    REQUIRE(orient3d_t(a, b, c, q) == 1);
+}
+
+TEST_CASE("lazy_rational", "[test_geom]")
+{
+    // the exact operations on doubles stay doubles
+    REQUIRE((LazyRational(0.5) + LazyRational(0.25)).is_double());
+    REQUIRE((LazyRational(3) * LazyRational(0.5)).is_double());
+    REQUIRE((LazyRational(3) / LazyRational(4)).is_double());
+    REQUIRE(!(LazyRational(1) / LazyRational(3)).is_double());
+    REQUIRE(!(LazyRational(1) + LazyRational(1e-30)).is_double());
+    // and the rationals that are doubles again become doubles
+    auto third = LazyRational(1) / LazyRational(3);
+    REQUIRE((third * LazyRational(3)).is_double());
+    REQUIRE((third - third).get_sign() == 0);
+
+    // the same values as Rational on random expressions
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> dist(-10, 10);
+    for (int i = 0; i < 1000; i++) {
+        const double a = dist(gen), b = dist(gen), c = std::round(dist(gen));
+        const LazyRational la = a, lb = b, lc = c;
+        const Rational ra = a, rb = b, rc = c;
+        const LazyRational l = (la - lb) * (la + lc) / (lc == 0 ? LazyRational(1) : lc);
+        const Rational r = (ra - rb) * (ra + rc) / (rc == 0 ? Rational(1) : rc);
+        REQUIRE(l.to_rational() == r);
+        REQUIRE(l.to_double() == r.to_double());
+        REQUIRE(l.get_sign() == Rational(r).get_sign());
+        REQUIRE((l < la) == (r < ra));
+        REQUIRE((l == l * LazyRational(1)) == true);
+        REQUIRE(pow(l, -2).to_rational() == pow(r, -2));
+    }
+    // doubles of any exponent mixed with rationals
+    std::uniform_int_distribution<int> exponent(-1070, 1000);
+    const Rational r_third = Rational(1) / Rational(3);
+    for (int i = 0; i < 1000; i++) {
+        const double d = std::ldexp(dist(gen), exponent(gen));
+        REQUIRE((LazyRational(d) + third).to_rational() == Rational(d) + r_third);
+        REQUIRE((third / LazyRational(d)).to_rational() == r_third / Rational(d));
+        REQUIRE((LazyRational(d) < third) == (Rational(d) < r_third));
+    }
+}
+
+namespace {
+// a grid of n^3 cubes split in 6 tets each, with a third of the vertices moved off the doubles
+template <typename rational>
+struct InsertionGrid
+{
+    using Vector3r = Eigen::Matrix<rational, 3, 1>;
+    TetMesh m;
+    std::vector<Vector3r> pos;
+
+    InsertionGrid(int n)
+    {
+        auto vid = [&](int i, int j, int k) { return size_t((i * (n + 1) + j) * (n + 1) + k); };
+        pos.resize((n + 1) * (n + 1) * (n + 1));
+        for (int i = 0; i <= n; i++)
+            for (int j = 0; j <= n; j++)
+                for (int k = 0; k <= n; k++) {
+                    Vector3r p(i, j, k);
+                    if ((i + j + k) % 3 == 0) p[0] = p[0] + rational(1) / rational(7);
+                    pos[vid(i, j, k)] = p;
+                }
+        std::vector<std::array<size_t, 4>> tets;
+        const std::array<int, 6> cycle = {{1, 3, 2, 6, 4, 5}};
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++)
+                for (int k = 0; k < n; k++) {
+                    std::array<size_t, 8> v;
+                    for (int c = 0; c < 8; c++)
+                        v[c] = vid(i + (c & 1), j + ((c >> 1) & 1), k + (c >> 2));
+                    for (int t = 0; t < 6; t++) {
+                        std::array<size_t, 4> tet = {
+                            {v[0], v[cycle[t]], v[cycle[(t + 1) % 6]], v[7]}};
+                        if (orient3d_t(pos[tet[0]], pos[tet[1]], pos[tet[2]], pos[tet[3]]) < 0)
+                            std::swap(tet[1], tet[2]);
+                        tets.push_back(tet);
+                    }
+                }
+        m.init(pos.size(), tets);
+    }
+
+    size_t insert_triangles(const std::vector<std::array<size_t, 3>>& faces)
+    {
+        size_t n_cut = 0;
+        for (auto& f : faces) {
+            std::vector<std::array<size_t, 3>> marked;
+            auto [flag, tets, edges, points] = triangle_insert_prepare_info<rational>(
+                m,
+                f,
+                marked,
+                [](auto&) { return true; },
+                [](auto&) { return true; },
+                [&](size_t i) { return pos[i]; });
+            n_cut += points.size();
+        }
+        return n_cut;
+    }
+
+    double tet_energies()
+    {
+        double sum = 0;
+        for (auto& t : m.get_tets()) {
+            std::array<rational, 12> T;
+            auto vids = m.oriented_tet_vids(t);
+            for (int k = 0; k < 4; k++)
+                for (int j = 0; j < 3; j++) T[k * 3 + j] = pos[vids[k]][j];
+            sum += AMIPS_energy_rational_p3<rational>(T);
+        }
+        return sum;
+    }
+};
+} // namespace
+
+TEST_CASE("benchmark_lazy_rational", "[test_geom][!benchmark]")
+{
+    InsertionGrid<Rational> grid(6);
+    InsertionGrid<LazyRational> lazy_grid(6);
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<size_t> pick(0, grid.pos.size() - 1);
+    std::vector<std::array<size_t, 3>> faces;
+    while (faces.size() < 50) {
+        std::array<size_t, 3> f = {{pick(gen), pick(gen), pick(gen)}};
+        if (f[0] != f[1] && f[1] != f[2] && f[0] != f[2]) faces.push_back(f);
+    }
+    REQUIRE(grid.insert_triangles(faces) == lazy_grid.insert_triangles(faces));
+    REQUIRE(grid.tet_energies() == Approx(lazy_grid.tet_energies()));
+
+    BENCHMARK("triangle insertion, Rational")
+    {
+        return grid.insert_triangles(faces);
+    };
+    BENCHMARK("triangle insertion, LazyRational")
+    {
+        return lazy_grid.insert_triangles(faces);
+    };
+    BENCHMARK("tet energies, Rational")
+    {
+        return grid.tet_energies();
+    };
+    BENCHMARK("tet energies, LazyRational")
+    {
+        return lazy_grid.tet_energies();
+    };
+}
+
+namespace {
+// the determinant of orient3d on the 4 points in p, with the operations on temporaries
+Rational orient3d_det(const std::array<Rational, 12>& p)
+{
+    return ((p[3] - p[0]) * (p[7] - p[1]) - (p[4] - p[1]) * (p[6] - p[0])) * (p[11] - p[2]) +
+           ((p[4] - p[1]) * (p[8] - p[2]) - (p[5] - p[2]) * (p[7] - p[1])) * (p[9] - p[0]) +
+           ((p[5] - p[2]) * (p[6] - p[0]) - (p[3] - p[0]) * (p[8] - p[2])) * (p[10] - p[1]);
+}
+
+// the same determinant, with each operation allocating its result like without the move-aware
+// operators
+Rational orient3d_det_copying(const std::array<Rational, 12>& p)
+{
+    auto add = [](const Rational& x, const Rational& y) { return x + y; };
+    auto sub = [](const Rational& x, const Rational& y) { return x - y; };
+    auto mul = [](const Rational& x, const Rational& y) { return x * y; };
+    auto u = [&](int d) { return sub(p[3 + d], p[d]); };
+    auto v = [&](int d) { return sub(p[6 + d], p[d]); };
+    auto w = [&](int d) { return sub(p[9 + d], p[d]); };
+    auto term = [&](int d) {
+        const int d1 = (d + 1) % 3, d2 = (d + 2) % 3;
+        return mul(sub(mul(u(d1), v(d2)), mul(u(d2), v(d1))), w(d));
+    };
+    return add(add(term(0), term(1)), term(2));
+}
+
+std::vector<std::array<Rational, 12>> random_rational_points(size_t n)
+{
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> coord(-1, 1);
+    std::vector<std::array<Rational, 12>> points(n);
+    for (auto& p : points)
+        for (auto& x : p) x = Rational(coord(gen)) / Rational(3);
+    return points;
+}
+} // namespace
+
+TEST_CASE("rational_move_operators", "[test_geom]")
+{
+    Rational a(0.5), b(0.25);
+    REQUIRE(Rational(a) + Rational(b) == Rational(0.75));
+    REQUIRE(a - Rational(b) == Rational(0.25));
+    REQUIRE(Rational(a) - b == Rational(0.25));
+    REQUIRE(Rational(1) / Rational(a) == Rational(2));
+    REQUIRE(-Rational(a) == Rational(-0.5));
+    REQUIRE(pow(a, -2) == Rational(4));
+
+    Rational c = std::move(a);
+    REQUIRE(c == Rational(0.5));
+    REQUIRE(a == Rational(0)); // the moved-from rational is still valid
+    a = std::move(b);
+    REQUIRE(a == Rational(0.25));
+
+    for (auto& p : random_rational_points(100)) {
+        const Rational det = orient3d_det(p);
+        REQUIRE(det == orient3d_det_copying(p));
+        Vector3d p0(p[0].to_double(), p[1].to_double(), p[2].to_double());
+        Vector3d p1(p[3].to_double(), p[4].to_double(), p[5].to_double());
+        Vector3d p2(p[6].to_double(), p[7].to_double(), p[8].to_double());
+        Vector3d p3(p[9].to_double(), p[10].to_double(), p[11].to_double());
+        REQUIRE(det.to_double() == Approx((p1 - p0).cross(p2 - p0).dot(p3 - p0)).margin(1e-12));
+    }
+}
+
+TEST_CASE("gmp_memory_pool", "[test_geom]")
+{
+    const auto points = random_rational_points(100);
+    std::vector<Rational> dets;
+    for (auto& p : points) dets.push_back(orient3d_det(p));
+
+    use_gmp_memory_pool();
+    for (int i = 0; i < 2; i++)
+        for (size_t k = 0; k < points.size(); k++) REQUIRE(orient3d_det(points[k]) == dets[k]);
+    // once the pool is warm, the predicates do not allocate anymore
+    const size_t mallocs = gmp_memory_pool_mallocs();
+    for (size_t k = 0; k < points.size(); k++) REQUIRE(orient3d_det(points[k]) == dets[k]);
+    REQUIRE(gmp_memory_pool_mallocs() == mallocs);
+    use_gmp_memory_pool(false);
+
+    // the rationals allocated by the pool are freed by malloc
+    dets.clear();
+}
+
+TEST_CASE("benchmark_rational_allocation", "[test_geom][!benchmark]")
+{
+    const auto points = random_rational_points(1000);
+    auto sum_signs = [&](auto&& det) {
+        int sum = 0;
+        for (auto& p : points) sum += det(p).get_sign();
+        return sum;
+    };
+
+    BENCHMARK("orient3d, copying operators")
+    {
+        return sum_signs(orient3d_det_copying);
+    };
+    BENCHMARK("orient3d, move-aware operators")
+    {
+        return sum_signs(orient3d_det);
+    };
+    use_gmp_memory_pool();
+    BENCHMARK("orient3d, copying operators, memory pool")
+    {
+        return sum_signs(orient3d_det_copying);
+    };
+    BENCHMARK("orient3d, move-aware operators, memory pool")
+    {
+        return sum_signs(orient3d_det);
+    };
+    use_gmp_memory_pool(false);
+}
+
+TEST_CASE("AMIPS_energy_p3_filtered", "[test_geom]")
+{
+    // a regular tet has the minimal energy
+    const double h = std::sqrt(2.) / 2;
+    std::array<double, 12> regular = {{1, 0, -h, -1, 0, -h, 0, 1, h, 0, -1, h}};
+    REQUIRE(AMIPS_energy_p3_filtered(regular).value() == Approx(27));
+
+    reset_AMIPS_p3_counters();
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> coord(-1, 1);
+    for (int k = 0; k < 1000; k++) {
+        std::array<double, 12> T;
+        for (auto& x : T) x = coord(gen);
+        const double exact = AMIPS_energy_rational_p3<Rational>(T);
+        REQUIRE(AMIPS_energy_p3_filtered(T).value() == Approx(exact).epsilon(1e-9));
+        REQUIRE(AMIPS_energy_stable_p3<Rational>(T) == Approx(exact).epsilon(1e-9));
+    }
+    REQUIRE(AMIPS_p3_counters().num_evaluations == 2000);
+    REQUIRE(AMIPS_p3_counters().num_escalations == 0);
+
+    // the double evaluation of a well-conditioned sliver is accurate, but the rounded centroid
+    // of a face cancels the determinant, which is escalated to rationals
+    std::array<double, 12> sliver = {{0, 0, 0, 1, 0, 0, 0, 1, 0, 0.5, 0.5, 1e-12}};
+    REQUIRE(AMIPS_energy_p3_filtered(sliver).value() ==
+            Approx(AMIPS_energy_rational_p3<Rational>(sliver)).epsilon(1e-9));
+    std::array<double, 12> flat = {{0.1, 0.2, 0.3, 1.3, 0.7, 0.1, 0.4, 1.9, 0.6}};
+    for (int d = 0; d < 3; d++) flat[9 + d] = (flat[d] + flat[3 + d] + flat[6 + d]) / 3;
+    REQUIRE(!AMIPS_energy_p3_filtered(flat).has_value());
+    REQUIRE(AMIPS_energy_stable_p3<Rational>(flat) == AMIPS_energy_rational_p3<Rational>(flat));
+    REQUIRE(AMIPS_p3_counters().num_escalations == 2);
+}
+
+TEST_CASE("benchmark_amips_p3", "[test_geom][!benchmark]")
+{
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> coord(-1, 1);
+    std::vector<std::array<double, 12>> tets(10000);
+    for (auto& T : tets)
+        for (auto& x : T) x = coord(gen);
+
+    BENCHMARK("AMIPS p3, cube of AMIPS_energy")
+    {
+        double sum = 0;
+        for (auto& T : tets) sum += std::pow(AMIPS_energy(T), 3);
+        return sum;
+    };
+    BENCHMARK("AMIPS p3, filtered")
+    {
+        double sum = 0;
+        for (auto& T : tets) sum += AMIPS_energy_stable_p3<Rational>(T);
+        return sum;
+    };
+}
+
+namespace {
+std::vector<std::array<double, 12>> random_tets(size_t n)
+{
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> coord(-1, 1);
+    std::vector<std::array<double, 12>> tets(n);
+    for (auto& T : tets)
+        for (auto& x : T) x = coord(gen);
+    return tets;
+}
+} // namespace
+
+TEST_CASE("AMIPS_batch", "[test_geom]")
+{
+    const auto tets = random_tets(AMIPS_BATCH_SIZE * 10 + 3);
+    for (size_t first = 0; first < tets.size(); first += AMIPS_BATCH_SIZE) {
+        AMIPSBatch batch;
+        for (size_t i = first; i < tets.size() && !batch.full(); i++) batch.push_back(tets[i]);
+        AMIPSLanes energy, energy_p3;
+        std::array<AMIPSLanes, 3> jacobian;
+        std::array<AMIPSLanes, 9> hessian;
+        AMIPS_energy_batch(batch, energy);
+        AMIPS_jacobian_batch(batch, jacobian);
+        AMIPS_hessian_batch(batch, hessian);
+        const int escalated = AMIPS_energy_p3_filtered_batch(batch, energy_p3);
+
+        // the same bits as the scalar functions
+        for (int i = 0; i < batch.size; i++) {
+            const auto& T = tets[first + i];
+            Eigen::Vector3d J;
+            Eigen::Matrix3d H;
+            AMIPS_jacobian(T, J);
+            AMIPS_hessian(T, H);
+            REQUIRE(energy[i] == AMIPS_energy(T));
+            for (int k = 0; k < 3; k++) REQUIRE(jacobian[k][i] == J[k]);
+            for (int k = 0; k < 9; k++) REQUIRE(hessian[k][i] == H(k / 3, k % 3));
+            const auto p3 = AMIPS_energy_p3_filtered(T);
+            REQUIRE(((escalated >> i) & 1) == !p3.has_value());
+            if (p3) REQUIRE(energy_p3[i] == *p3);
+        }
+    }
+
+    // the derivatives are the ones of the energy, whose constants have 15 digits
+    for (auto T : random_tets(100)) {
+        REQUIRE(std::pow(AMIPS_energy(T), 3) ==
+                Approx(AMIPS_energy_rational_p3<Rational>(T)).epsilon(1e-9));
+        Eigen::Vector3d J;
+        Eigen::Matrix3d H;
+        AMIPS_jacobian(T, J);
+        AMIPS_hessian(T, H);
+        const double h = 1e-6;
+        for (int k = 0; k < 3; k++) {
+            auto Tp = T, Tm = T;
+            Tp[k] += h;
+            Tm[k] -= h;
+            Eigen::Vector3d Jp, Jm;
+            AMIPS_jacobian(Tp, Jp);
+            AMIPS_jacobian(Tm, Jm);
+            const double scale = 1 + J.norm();
+            REQUIRE((AMIPS_energy(Tp) - AMIPS_energy(Tm)) / (2 * h) / scale ==
+                    Approx(J[k] / scale).margin(1e-5));
+            for (int j = 0; j < 3; j++)
+                REQUIRE((Jp[j] - Jm[j]) / (2 * h) / (1 + H.norm()) ==
+                        Approx(H(j, k) / (1 + H.norm())).margin(1e-5));
+        }
+    }
+}
+
+TEST_CASE("AMIPS_newton_method_from_stack", "[test_geom]")
+{
+    // the one-ring of the vertex of a grid, moved off its optimal position
+    std::vector<std::array<double, 12>> stack;
+    InsertionGrid<Rational> grid(2);
+    const size_t center = 13;
+    for (auto& t : grid.m.get_one_ring_tets_for_vertex(grid.m.tuple_from_vertex(center))) {
+        auto vids = orient_preserve_tet_reorder(grid.m.oriented_tet_vids(t), center);
+        std::array<double, 12> T;
+        for (int k = 0; k < 4; k++)
+            for (int j = 0; j < 3; j++) T[k * 3 + j] = grid.pos[vids[k]][j].to_double();
+        stack.push_back(T);
+    }
+    for (auto& T : stack) {
+        T[0] += 0.2;
+        T[1] -= 0.1;
+    }
+    REQUIRE(stack.size() > AMIPS_BATCH_SIZE);
+
+    auto scalar_stack = stack;
+    const Vector3d p =
+        newton_method_from_stack(scalar_stack, AMIPS_energy, AMIPS_jacobian, AMIPS_hessian);
+    REQUIRE(AMIPS_newton_method_from_stack(stack) == p);
+    REQUIRE(p != Vector3d(stack[0][0], stack[0][1], stack[0][2]));
+}
+
+TEST_CASE("benchmark_amips_batch", "[test_geom][!benchmark]")
+{
+    const auto tets = random_tets(AMIPS_BATCH_SIZE * 1000);
+    std::vector<AMIPSBatch> batches(1000);
+    for (size_t i = 0; i < tets.size(); i++) batches[i / AMIPS_BATCH_SIZE].push_back(tets[i]);
+
+    BENCHMARK("AMIPS energy, jacobian and hessian, scalar")
+    {
+        double sum = 0;
+        Eigen::Vector3d J;
+        Eigen::Matrix3d H;
+        for (auto& T : tets) {
+            AMIPS_jacobian(T, J);
+            AMIPS_hessian(T, H);
+            sum += AMIPS_energy(T) + J[0] + H(0, 0);
+        }
+        return sum;
+    };
+    BENCHMARK("AMIPS energy, jacobian and hessian, batched")
+    {
+        double sum = 0;
+        AMIPSLanes E;
+        std::array<AMIPSLanes, 3> J;
+        std::array<AMIPSLanes, 9> H;
+        for (auto& b : batches) {
+            AMIPS_energy_batch(b, E);
+            AMIPS_jacobian_batch(b, J);
+            AMIPS_hessian_batch(b, H);
+            for (int i = 0; i < b.size; i++) sum += E[i] + J[0][i] + H[0][i];
+        }
+        return sum;
+    };
+    BENCHMARK("AMIPS p3 filtered, scalar")
+    {
+        double sum = 0;
+        for (auto& T : tets) sum += AMIPS_energy_p3_filtered(T).value_or(0);
+        return sum;
+    };
+    BENCHMARK("AMIPS p3 filtered, batched")
+    {
+        double sum = 0;
+        AMIPSLanes E;
+        for (auto& b : batches) {
+            const int escalated = AMIPS_energy_p3_filtered_batch(b, E);
+            for (int i = 0; i < b.size; i++) sum += (escalated >> i) & 1 ? 0 : E[i];
+        }
+        return sum;
+    };
+}
@@ -2,8 +2,36 @@
 #include <catch2/catch.hpp>
 #include "wmtk/utils/Logger.hpp"
 
+#include <numeric>
+#include <random>
+
 using namespace wmtk;
 
+namespace {
+// a grid of (n-1)^3 cubes, each split into 6 tets around its diagonal
+std::vector<std::array<size_t, 4>> grid_tets(size_t n)
+{
+    auto vid = [n](size_t i, size_t j, size_t k) { return i + n * (j + n * k); };
+    auto tets = std::vector<std::array<size_t, 4>>();
+    for (size_t i = 0; i + 1 < n; i++)
+        for (size_t j = 0; j + 1 < n; j++)
+            for (size_t k = 0; k + 1 < n; k++) {
+                std::array<int, 3> axes = {{0, 1, 2}};
+                do {
+                    std::array<size_t, 3> p = {{i, j, k}};
+                    std::array<size_t, 4> tet;
+                    tet[0] = vid(p[0], p[1], p[2]);
+                    for (int a = 0; a < 3; a++) {
+                        p[axes[a]]++;
+                        tet[a + 1] = vid(p[0], p[1], p[2]);
+                    }
+                    tets.push_back(tet);
+                } while (std::next_permutation(axes.begin(), axes.end()));
+            }
+    return tets;
+}
+} // namespace
+
 TEST_CASE("edge_splitting", "[tuple_operation]")
 {
     auto mesh = TetMesh();
@@ -98,7 +126,8 @@ TEST_CASE("tet_mesh_swap", "[tuple_operation]")
         REQUIRE(mesh.get_tets().size() == 3);
     }
 
-    REQUIRE(mesh.tet_capacity() == 4);
+    // the 2-3 swap reuses the slot freed by the 3-2 swap
+    REQUIRE(mesh.tet_capacity() == 3);
     mesh.consolidate_mesh();
     REQUIRE(mesh.tet_capacity() == 3);
 }
@@ -136,6 +165,72 @@ TEST_CASE("rollback_operation", "[tuple_operation]")
     }
 }
 
+TEST_CASE("attribute_rollback", "[tuple_operation]")
+{
+    auto attrs = AttributeCollection<std::vector<int>>();
+    attrs.resize(100);
+    for (int i = 0; i < 100; i++) attrs[i] = {i};
+
+    // several operations reuse the same log, only the first modification of an element is kept
+    for (int op = 0; op < 3; op++) {
+        attrs.begin_protect();
+        for (int i = 0; i < 100; i += 3) {
+            attrs[i].push_back(op);
+            attrs[i].push_back(op);
+        }
+        attrs.grow_to_at_least(120);
+        attrs[110] = {-1};
+        REQUIRE(attrs.m_rollback_list.local().size() == 35);
+        attrs.rollback();
+    }
+    for (int i = 0; i < 100; i++) REQUIRE(attrs[i] == std::vector<int>{i});
+
+    // the log is emptied at the end of a successful operation
+    attrs.begin_protect();
+    attrs[0].push_back(0);
+    attrs.end_protect();
+    REQUIRE(attrs.m_rollback_list.local().empty());
+    REQUIRE(attrs[0] == std::vector<int>{0, 0});
+}
+
+TEST_CASE("attribute_columns", "[tuple_operation]")
+{
+    // a position column, and a column that is expensive to copy
+    class ColumnMesh : public TetMesh
+    {
+    public:
+        AttributeColumns<double, std::vector<int>> vertex_attrs;
+        bool split_edge_after(const TetMesh::Tuple& t) override
+        {
+            auto& pos = vertex_attrs.column<0>();
+            pos[t.vid(*this)] = (pos[0] + pos[1]) / 2;
+            REQUIRE(pos.m_rollback_list.local().size() == 3);
+            REQUIRE(vertex_attrs.column<1>().m_rollback_list.local().empty());
+            return false;
+        };
+    };
+    auto mesh = ColumnMesh();
+    mesh.init(5, {{{0, 1, 2, 3}}, {{0, 1, 2, 4}}});
+    mesh.p_vertex_attrs = &mesh.vertex_attrs;
+    mesh.vertex_attrs.resize(5);
+    for (int i = 0; i < 5; i++) {
+        mesh.vertex_attrs.column<0>()[i] = i;
+        mesh.vertex_attrs.column<1>()[i] = std::vector<int>(100, i);
+    }
+
+    std::vector<TetMesh::Tuple> dummy;
+    REQUIRE_FALSE(mesh.split_edge(mesh.tuple_from_edge(0, 0), dummy));
+    REQUIRE(mesh.vertex_attrs.size() >= 6);
+    for (int i = 0; i < 5; i++) {
+        REQUIRE(mesh.vertex_attrs.column<0>().at(i) == i);
+        REQUIRE(mesh.vertex_attrs.column<1>().at(i) == std::vector<int>(100, i));
+    }
+
+    mesh.vertex_attrs.move(4, 0);
+    REQUIRE(mesh.vertex_attrs.column<0>().at(0) == 4);
+    REQUIRE(mesh.vertex_attrs.column<1>().at(0) == std::vector<int>(100, 4));
+}
+
 TEST_CASE("forbidden-face-swap", "[tuple_operation]")
 {
     /// https://i.imgur.com/aVCsOvf.png and 0,2,3 should not be swapped.
@@ -224,4 +319,442 @@ TEST_CASE("divide-tet-customized")
     auto op = DivideTet(mesh);
     mesh.customized_operation(op, tuple, new_tups);
     CHECK(mesh.tet_size() == 5);
-}
\ No newline at end of file
+}
+TEST_CASE("adjacency_cache", "[tuple_operation]")
+{
+    // rejects every other operation, so that the cache is also rolled back
+    class AlternatingMesh : public TetMesh
+    {
+    public:
+        int cnt = 0;
+        bool split_edge_after(const TetMesh::Tuple& locs) override { return cnt++ % 2 == 0; };
+        bool collapse_edge_after(const TetMesh::Tuple& locs) override { return cnt++ % 2 == 0; };
+        bool swap_edge_after(const TetMesh::Tuple& locs) override { return cnt++ % 2 == 0; };
+        bool swap_face_after(const TetMesh::Tuple& locs) override { return cnt++ % 2 == 0; };
+    };
+
+    const size_t n = 4;
+    auto mesh = AlternatingMesh();
+    mesh.init(n * n * n, grid_tets(n));
+    mesh.enable_adjacency_cache();
+    REQUIRE(mesh.has_adjacency_cache());
+    REQUIRE(mesh.check_adjacency_cache_validity());
+
+    std::vector<TetMesh::Tuple> dummy;
+    auto edges = mesh.get_edges();
+    for (size_t i = 0; i < edges.size(); i += 3) {
+        if (!edges[i].is_valid(mesh)) continue;
+        dummy.clear();
+        mesh.split_edge(edges[i], dummy);
+    }
+    REQUIRE(mesh.check_adjacency_cache_validity());
+    for (auto& f : mesh.get_faces()) {
+        if (!f.is_valid(mesh)) continue;
+        dummy.clear();
+        mesh.swap_face(f, dummy);
+    }
+    REQUIRE(mesh.check_adjacency_cache_validity());
+    for (auto& e : mesh.get_edges()) {
+        if (!e.is_valid(mesh)) continue;
+        dummy.clear();
+        mesh.swap_edge(e, dummy);
+    }
+    REQUIRE(mesh.check_adjacency_cache_validity());
+    for (auto& e : mesh.get_edges()) {
+        if (!e.is_valid(mesh)) continue;
+        dummy.clear();
+        mesh.collapse_edge(e, dummy);
+    }
+    REQUIRE(mesh.check_adjacency_cache_validity());
+    REQUIRE(mesh.check_mesh_connectivity_validity());
+
+    // the cached navigation matches the one intersecting the one-ring tets
+    auto navigate = [&mesh]() {
+        auto result = std::vector<size_t>();
+        for (auto& t : mesh.get_tets()) {
+            for (auto j = 0; j < 4; j++) {
+                auto f = mesh.tuple_from_face(t.tid(mesh), j);
+                auto adj = f.switch_tetrahedron(mesh);
+                result.push_back(f.fid(mesh));
+                result.push_back(adj.has_value() ? adj->tid(mesh) : -1);
+                result.push_back(f.is_boundary_face(mesh));
+            }
+            for (auto j = 0; j < 6; j++)
+                result.push_back(mesh.tuple_from_edge(t.tid(mesh), j).eid(mesh));
+        }
+        return result;
+    };
+    auto cached = navigate();
+    mesh.enable_adjacency_cache(false);
+    REQUIRE(cached == navigate());
+
+    mesh.enable_adjacency_cache();
+    mesh.consolidate_mesh();
+    REQUIRE(mesh.check_adjacency_cache_validity());
+    auto faces = mesh.get_faces();
+    auto cnt_boundary = std::count_if(faces.begin(), faces.end(), [&mesh](auto& f) {
+        return f.is_boundary_face(mesh);
+    });
+    REQUIRE(faces.size() * 2 == mesh.tet_size() * 4 + cnt_boundary);
+}
+
+TEST_CASE("element_counts", "[tuple_operation]")
+{
+    // rejects every third operation, so that the counts are also rolled back
+    class RejectingMesh : public TetMesh
+    {
+    public:
+        int cnt = 0;
+        bool split_edge_after(const TetMesh::Tuple& locs) override { return cnt++ % 3 != 0; };
+        bool collapse_edge_after(const TetMesh::Tuple& locs) override { return cnt++ % 3 != 0; };
+        bool swap_edge_after(const TetMesh::Tuple& locs) override { return cnt++ % 3 != 0; };
+        bool swap_face_after(const TetMesh::Tuple& locs) override { return cnt++ % 3 != 0; };
+    };
+
+    const size_t n = 5;
+    auto mesh = RejectingMesh();
+    mesh.init(n * n * n, grid_tets(n));
+    auto check_counts = [&mesh]() {
+        REQUIRE(mesh.vertex_size() == mesh.get_vertices().size());
+        REQUIRE(mesh.tet_size() == mesh.get_tets().size());
+    };
+    check_counts();
+
+    std::vector<TetMesh::Tuple> dummy;
+    auto rng = std::mt19937(7);
+    for (auto round = 0; round < 4; round++) {
+        auto edges = mesh.get_edges();
+        std::shuffle(edges.begin(), edges.end(), rng);
+        for (size_t i = 0; i < edges.size(); i++) {
+            if (!edges[i].is_valid(mesh)) continue;
+            dummy.clear();
+            switch (rng() % 4) {
+            case 0: mesh.split_edge(edges[i], dummy); break;
+            case 1: mesh.collapse_edge(edges[i], dummy); break;
+            case 2: mesh.swap_edge(edges[i], dummy); break;
+            default: mesh.swap_face(edges[i], dummy);
+            }
+        }
+        check_counts();
+    }
+
+    auto tets = mesh.get_tets();
+    auto tids = std::vector<size_t>();
+    for (size_t i = 0; i < tets.size(); i += 5) tids.push_back(tets[i].tid(mesh));
+    mesh.remove_tets_by_ids(tids);
+    check_counts();
+
+    mesh.consolidate_mesh();
+    REQUIRE(mesh.vertex_size() == mesh.vert_capacity());
+    REQUIRE(mesh.tet_size() == mesh.tet_capacity());
+    check_counts();
+}
+
+TEST_CASE("slot_reuse", "[tuple_operation]")
+{
+    const size_t n = 5;
+    auto mesh = TetMesh();
+    mesh.init(n * n * n, grid_tets(n));
+
+    std::vector<TetMesh::Tuple> dummy;
+    auto split_all = [&]() {
+        auto edges = mesh.get_edges();
+        for (size_t i = 0; i < edges.size(); i += 2) {
+            if (!edges[i].is_valid(mesh)) continue;
+            dummy.clear();
+            mesh.split_edge(edges[i], dummy);
+        }
+    };
+    auto collapse_all = [&]() {
+        for (auto& e : mesh.get_edges()) {
+            if (!e.is_valid(mesh)) continue;
+            dummy.clear();
+            mesh.collapse_edge(e, dummy);
+        }
+    };
+
+    split_all();
+    const size_t tet_capacity = mesh.tet_capacity();
+    const auto old_tets = mesh.get_tets();
+    collapse_all();
+    REQUIRE(mesh.tet_size() < tet_capacity);
+    auto removed_tets = std::vector<TetMesh::Tuple>();
+    for (auto& t : old_tets)
+        if (!t.is_valid(mesh)) removed_tets.push_back(t);
+
+    // the splits fill all the slots freed by the collapses before growing the mesh
+    split_all();
+    REQUIRE(mesh.tet_capacity() > tet_capacity);
+    REQUIRE(mesh.tet_size() == mesh.tet_capacity());
+    REQUIRE(mesh.vertex_size() == mesh.vert_capacity());
+    REQUIRE(mesh.check_mesh_connectivity_validity());
+    REQUIRE(mesh.vertex_size() == mesh.get_vertices().size());
+    REQUIRE(mesh.tet_size() == mesh.get_tets().size());
+
+    // the tuples of the removed tets are not revived by the reuse of their slots
+    for (auto& t : removed_tets) REQUIRE_FALSE(t.is_valid(mesh));
+
+    mesh.consolidate_mesh();
+    REQUIRE(mesh.tet_capacity() == mesh.tet_size());
+    REQUIRE(mesh.check_mesh_connectivity_validity());
+}
+
+TEST_CASE("slab_allocation", "[tuple_operation]")
+{
+    const size_t n = 4;
+    auto mesh = TetMesh();
+    mesh.init(n * n * n, grid_tets(n));
+    mesh.NUM_THREADS = 4;
+    const size_t n_vertices = mesh.vert_capacity();
+    const size_t n_tets = mesh.tet_capacity();
+
+    // the first split reserves a whole slab of vertices and tets, the next ones take from it
+    std::vector<TetMesh::Tuple> dummy;
+    auto edges = mesh.get_edges();
+    REQUIRE(mesh.split_edge(edges[0], dummy));
+    REQUIRE(mesh.vert_capacity() == n_vertices + SlotFreeList::slab_size);
+    REQUIRE(mesh.tet_capacity() == n_tets + SlotFreeList::slab_size);
+    for (size_t i = 1; i < edges.size(); i++) {
+        if (!edges[i].is_valid(mesh)) continue;
+        dummy.clear();
+        mesh.split_edge(edges[i], dummy);
+    }
+    REQUIRE((mesh.vert_capacity() - n_vertices) % SlotFreeList::slab_size == 0);
+    REQUIRE((mesh.tet_capacity() - n_tets) % SlotFreeList::slab_size == 0);
+
+    // the unused slots of the slabs are holes until the consolidation
+    REQUIRE(mesh.check_mesh_connectivity_validity());
+    REQUIRE(mesh.vertex_size() == mesh.get_vertices().size());
+    REQUIRE(mesh.tet_size() == mesh.get_tets().size());
+    mesh.consolidate_mesh();
+    REQUIRE(mesh.vert_capacity() == mesh.vertex_size());
+    REQUIRE(mesh.tet_capacity() == mesh.tet_size());
+    REQUIRE(mesh.check_mesh_connectivity_validity());
+}
+
+TEST_CASE("consolidate_mesh_ordering", "[tuple_operation]")
+{
+    // each attribute stores the id of its element before the consolidation
+    class LabeledMesh : public TetMesh
+    {
+    public:
+        AttributeCollection<size_t> vertex_labels, edge_labels, tet_labels;
+        LabeledMesh()
+        {
+            p_vertex_attrs = &vertex_labels;
+            p_edge_attrs = &edge_labels;
+            p_tet_attrs = &tet_labels;
+        }
+    };
+
+    const size_t n = 200;
+    auto tets = std::vector<std::array<size_t, 4>>();
+    for (size_t i = 0; i < n; i++) tets.push_back({{i, i + 1, i + 2, i + 3}});
+    auto mesh = LabeledMesh();
+    mesh.NUM_THREADS = 4;
+    mesh.init(n + 3, tets);
+    mesh.vertex_labels.resize(mesh.vert_capacity());
+    mesh.edge_labels.resize(6 * mesh.tet_capacity());
+    mesh.tet_labels.resize(mesh.tet_capacity());
+
+    std::vector<TetMesh::Tuple> dummy;
+    auto edges = mesh.get_edges();
+    for (size_t i = 0; i < edges.size(); i += 5) {
+        if (!edges[i].is_valid(mesh)) continue;
+        dummy.clear();
+        mesh.split_edge(edges[i], dummy);
+    }
+    edges = mesh.get_edges();
+    for (size_t i = 0; i < edges.size(); i += 7) {
+        if (!edges[i].is_valid(mesh)) continue;
+        dummy.clear();
+        mesh.collapse_edge(edges[i], dummy);
+    }
+    REQUIRE(mesh.vertex_size() < mesh.vert_capacity());
+    REQUIRE(mesh.tet_size() < mesh.tet_capacity());
+
+    auto old_vids = std::vector<size_t>();
+    for (auto& v : mesh.get_vertices()) old_vids.push_back(v.vid(mesh));
+    std::sort(old_vids.begin(), old_vids.end());
+    auto old_tets = std::vector<std::pair<size_t, std::array<size_t, 4>>>();
+    for (auto& t : mesh.get_tets()) old_tets.emplace_back(t.tid(mesh), mesh.oriented_tet_vids(t));
+    std::sort(old_tets.begin(), old_tets.end());
+    for (size_t i = 0; i < mesh.vert_capacity(); i++) mesh.vertex_labels[i] = i;
+    for (size_t i = 0; i < 6 * mesh.tet_capacity(); i++) mesh.edge_labels[i] = i;
+    for (size_t i = 0; i < mesh.tet_capacity(); i++) mesh.tet_labels[i] = i;
+
+    mesh.consolidate_mesh();
+    REQUIRE(mesh.vert_capacity() == old_vids.size());
+    REQUIRE(mesh.tet_capacity() == old_tets.size());
+    for (size_t i = 0; i < old_vids.size(); i++) REQUIRE(mesh.vertex_labels[i] == old_vids[i]);
+    for (size_t i = 0; i < old_tets.size(); i++) {
+        auto& [old_tid, old_tet] = old_tets[i];
+        REQUIRE(mesh.tet_labels[i] == old_tid);
+        for (auto j = 0; j < 6; j++) REQUIRE(mesh.edge_labels[6 * i + j] == 6 * old_tid + j);
+        auto tet = mesh.oriented_tet_vids(mesh.tuple_from_tet(i));
+        for (auto j = 0; j < 4; j++) REQUIRE(mesh.vertex_labels[tet[j]] == old_tet[j]);
+    }
+    REQUIRE(mesh.check_mesh_connectivity_validity());
+}
+
+namespace {
+// a grid whose vertices and tets are numbered randomly, with the vertex positions as attribute
+class ShuffledGridMesh : public TetMesh
+{
+public:
+    AttributeCollection<Eigen::Vector3d> positions;
+
+    ShuffledGridMesh(size_t n)
+    {
+        auto perm = std::vector<size_t>(n * n * n);
+        std::iota(perm.begin(), perm.end(), 0);
+        std::mt19937 gen(0);
+        std::shuffle(perm.begin(), perm.end(), gen);
+        auto tets = grid_tets(n);
+        for (auto& tet : tets)
+            for (auto& v : tet) v = perm[v];
+        std::shuffle(tets.begin(), tets.end(), gen);
+
+        NUM_THREADS = 4;
+        init(n * n * n, tets);
+        p_vertex_attrs = &positions;
+        positions.resize(n * n * n);
+        for (size_t i = 0; i < n * n * n; i++)
+            positions[perm[i]] = Eigen::Vector3d(i % n, (i / n) % n, i / (n * n));
+    }
+
+    // the average distance between the ids of the vertices of a tet
+    double average_span() const
+    {
+        double span = 0;
+        for (size_t i = 0; i < tet_capacity(); i++) {
+            auto tet = oriented_tet_vids(tuple_from_tet(i));
+            span += *std::max_element(tet.begin(), tet.end()) -
+                    *std::min_element(tet.begin(), tet.end());
+        }
+        return span / tet_capacity();
+    }
+
+    // a pass that reads the positions of the one-ring of every vertex
+    double smooth_pass() const
+    {
+        double sum = 0;
+        for (size_t i = 0; i < vert_capacity(); i++) {
+            for (auto v : get_one_ring_vids_for_vertex(i)) sum += positions.at(v).sum();
+        }
+        return sum;
+    }
+};
+} // namespace
+
+TEST_CASE("consolidate_mesh_morton", "[tuple_operation]")
+{
+    auto mesh = ShuffledGridMesh(8);
+    auto sorted_tets = [&mesh]() {
+        auto result = std::vector<std::array<std::array<double, 3>, 4>>();
+        for (auto& t : mesh.get_tets()) {
+            auto tet = std::array<std::array<double, 3>, 4>();
+            auto vids = mesh.oriented_tet_vids(t);
+            for (auto j = 0; j < 4; j++) {
+                auto& p = mesh.positions[vids[j]];
+                tet[j] = {{p[0], p[1], p[2]}};
+            }
+            result.push_back(tet);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    };
+    const auto tets_before = sorted_tets();
+    const auto span_before = mesh.average_span();
+
+    mesh.consolidate_mesh([&mesh](size_t i) { return mesh.positions[i]; });
+    REQUIRE(mesh.check_mesh_connectivity_validity());
+    REQUIRE(sorted_tets() == tets_before);
+    REQUIRE(mesh.average_span() * 3 < span_before);
+    // the tets follow the order of their first vertex
+    for (size_t i = 1; i < mesh.tet_capacity(); i++) {
+        auto t0 = mesh.oriented_tet_vids(mesh.tuple_from_tet(i - 1));
+        auto t1 = mesh.oriented_tet_vids(mesh.tuple_from_tet(i));
+        REQUIRE(
+            *std::min_element(t0.begin(), t0.end()) <= *std::min_element(t1.begin(), t1.end()));
+    }
+}
+
+TEST_CASE("consolidate_mesh_morton_shared_slots", "[tuple_operation]")
+{
+    // the faces and edges are labeled by the sorted grid indices of their vertices
+    class LabeledGridMesh : public ShuffledGridMesh
+    {
+    public:
+        AttributeCollection<std::array<size_t, 3>> face_labels;
+        AttributeCollection<std::array<size_t, 2>> edge_labels;
+        const size_t n;
+        LabeledGridMesh(size_t n_)
+            : ShuffledGridMesh(n_)
+            , n(n_)
+        {
+            p_face_attrs = &face_labels;
+            p_edge_attrs = &edge_labels;
+            face_labels.resize(4 * tet_capacity());
+            edge_labels.resize(6 * tet_capacity());
+        }
+        size_t grid_index(size_t vid) const
+        {
+            auto& p = positions.at(vid);
+            return size_t(p[0]) + n * size_t(p[1]) + n * n * size_t(p[2]);
+        }
+        std::array<size_t, 3> face_label(const Tuple& t) const
+        {
+            auto vs = get_face_vertices(t);
+            auto label = std::array<size_t, 3>();
+            for (auto j = 0; j < 3; j++) label[j] = grid_index(vs[j].vid(*this));
+            std::sort(label.begin(), label.end());
+            return label;
+        }
+        std::array<size_t, 2> edge_label(const Tuple& t) const
+        {
+            const size_t i0 = grid_index(t.vid(*this));
+            const size_t i1 = grid_index(t.switch_vertex(*this).vid(*this));
+            return {{std::min(i0, i1), std::max(i0, i1)}};
+        }
+    };
+
+    auto mesh = LabeledGridMesh(6);
+    for (size_t i = 0; i < mesh.tet_capacity(); i++) {
+        for (auto j = 0; j < 4; j++) {
+            auto t = mesh.tuple_from_face(i, j);
+            mesh.face_labels[t.fid(mesh)] = mesh.face_label(t);
+        }
+        for (auto j = 0; j < 6; j++) {
+            auto t = mesh.tuple_from_edge(i, j);
+            mesh.edge_labels[t.eid(mesh)] = mesh.edge_label(t);
+        }
+    }
+
+    mesh.consolidate_mesh([&mesh](size_t i) { return mesh.positions[i]; });
+    REQUIRE(mesh.check_mesh_connectivity_validity());
+    for (size_t i = 0; i < mesh.tet_capacity(); i++) {
+        for (auto j = 0; j < 4; j++) {
+            auto t = mesh.tuple_from_face(i, j);
+            REQUIRE(mesh.face_labels[t.fid(mesh)] == mesh.face_label(t));
+        }
+        for (auto j = 0; j < 6; j++) {
+            auto t = mesh.tuple_from_edge(i, j);
+            REQUIRE(mesh.edge_labels[t.eid(mesh)] == mesh.edge_label(t));
+        }
+    }
+}
+
+TEST_CASE("benchmark_consolidate_mesh_morton", "[tuple_operation][!benchmark]")
+{
+    auto mesh = ShuffledGridMesh(40);
+    BENCHMARK("one-ring pass, shuffled order")
+    {
+        return mesh.smooth_pass();
+    };
+    mesh.consolidate_mesh([&mesh](size_t i) { return mesh.positions[i]; });
+    BENCHMARK("one-ring pass, morton order")
+    {
+        return mesh.smooth_pass();
+    };
+}
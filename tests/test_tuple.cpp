@@ -2,6 +2,8 @@
 
 #include <catch2/catch.hpp>
 
+#include <set>
+
 using namespace wmtk;
 
 TEST_CASE("test_get_edges", "[test_tuple]")
@@ -13,6 +15,59 @@ TEST_CASE("test_get_edges", "[test_tuple]")
     REQUIRE(edges.size() == 6);
 }
 
+TEST_CASE("get_edges_parallel", "[test_tuple]")
+{
+    // a strip of tets sharing faces, with enough tets to be split in several blocks
+    std::vector<std::array<size_t, 4>> tets;
+    for (size_t i = 0; i < 3000; i++) tets.push_back({{i, i + 1, i + 2, i + 3}});
+    TetMesh mesh;
+    mesh.init(3003, tets);
+
+    const auto edges = mesh.get_edges();
+    mesh.NUM_THREADS = 4;
+    const auto edges_parallel = mesh.get_edges();
+    REQUIRE(edges.size() == 3 * 3000 + 3);
+    REQUIRE(edges_parallel.size() == edges.size());
+    std::set<std::array<size_t, 2>> unique_edges;
+    for (size_t i = 0; i < edges.size(); i++) {
+        // the edges are unique, and in the order of their eids whatever the number of threads
+        REQUIRE(edges[i].eid(mesh) == edges_parallel[i].eid(mesh));
+        if (i > 0) REQUIRE(edges[i - 1].eid(mesh) < edges[i].eid(mesh));
+        auto v0 = edges[i].vid(mesh), v1 = edges[i].switch_vertex(mesh).vid(mesh);
+        unique_edges.insert({{std::min(v0, v1), std::max(v0, v1)}});
+    }
+    REQUIRE(unique_edges.size() == edges.size());
+    REQUIRE(mesh.get_faces().size() == 4 * 3000 - 2999);
+    REQUIRE(mesh.get_tets().size() == 3000);
+    REQUIRE(mesh.get_vertices().size() == 3003);
+}
+
+TEST_CASE("reduce_elements", "[test_tuple]")
+{
+    std::vector<std::array<size_t, 4>> tets;
+    for (size_t i = 0; i < 3000; i++) tets.push_back({{i, i + 1, i + 2, i + 3}});
+    TetMesh mesh;
+    mesh.init(3003, tets);
+
+    auto count = [](size_t& cnt, auto&) { cnt++; };
+    auto add = [](size_t a, size_t b) { return a + b; };
+    auto sum_inverse_tids = [&]() {
+        return mesh.reduce_tetra(
+            0.,
+            [&](double& s, auto& t) { s += 1. / (t.tid(mesh) + 1); },
+            [](double a, double b) { return a + b; });
+    };
+    const auto sum = sum_inverse_tids();
+    for (int n_threads : {1, 4}) {
+        mesh.NUM_THREADS = n_threads;
+        REQUIRE(mesh.reduce_tetra(size_t(0), count, add) == 3000);
+        REQUIRE(mesh.reduce_vertex(size_t(0), count, add) == 3003);
+        REQUIRE(mesh.reduce_edge(size_t(0), count, add) == mesh.get_edges().size());
+        // the floating point sum is the same whatever the number of threads
+        REQUIRE(sum_inverse_tids() == sum);
+    }
+}
+
 TEST_CASE("switch_vertex", "[test_tuple]")
 {
     TetMesh mesh;
@@ -163,4 +218,85 @@ TEST_CASE("tuple_iterator", "[test_tuple]")
         cnt++;
     }
     REQUIRE(cnt == 10);
-}
\ No newline at end of file
+}
+TEST_CASE("connectivity_index", "[test_tuple]")
+{
+    TetMesh::TetrahedronConnectivity tet;
+    tet.set_vids({{3, 1, 4, 2}});
+    REQUIRE(tet.vids() == std::array<size_t, 4>{{3, 1, 4, 2}});
+    REQUIRE(tet.find(4) == 2);
+
+    REQUIRE_NOTHROW(check_connectivity_index_range(1 << 20));
+    if (sizeof(ConnectivityIndex) < sizeof(size_t)) {
+        REQUIRE(sizeof(TetMesh::TetrahedronConnectivity) < 4 * sizeof(size_t));
+        REQUIRE_THROWS(check_connectivity_index_range(size_t(1) << 33));
+    }
+}
+TEST_CASE("conn_tets_small_vector", "[test_tuple]")
+{
+    TetMesh::VertexConnectivity::TetList tids;
+    for (size_t i = 0; i < 40; i++) set_insert(tids, 39 - i);
+    REQUIRE(tids.size() == 40);
+    REQUIRE_FALSE(tids.is_inline());
+    REQUIRE(std::is_sorted(tids.begin(), tids.end()));
+    REQUIRE(set_erase(tids, size_t(7)));
+    REQUIRE_FALSE(set_erase(tids, size_t(7)));
+
+    auto copy = tids;
+    REQUIRE(copy == tids);
+    tids.clear();
+    REQUIRE(tids.empty());
+    auto moved = std::move(copy);
+    REQUIRE(moved.size() == 39);
+
+    TetMesh::VertexConnectivity::TetList small = {1, 3, 5, 8};
+    REQUIRE(small.is_inline());
+    std::vector<size_t> common;
+    set_intersection_for_each(small, moved, [&](size_t i) { common.push_back(i); });
+    REQUIRE(common == std::vector<size_t>{{1, 3, 5, 8}});
+}
+
+TEST_CASE("incident_tids_of_edge", "[test_tuple]")
+{
+    TetMesh mesh;
+    mesh.init(6, {{{0, 1, 2, 3}}, {{0, 1, 3, 4}}, {{0, 1, 4, 5}}, {{1, 2, 3, 5}}});
+    std::vector<size_t> tids;
+    mesh.for_each_incident_tid_of_edge(0, 1, [&](size_t tid) { tids.push_back(tid); });
+    REQUIRE(tids == std::vector<size_t>{{0, 1, 2}});
+
+    auto edge = mesh.tuple_from_edge({{0, 1}});
+    REQUIRE(edge.is_valid(mesh));
+    REQUIRE(mesh.get_incident_tets_for_edge(edge).size() == 3);
+    REQUIRE(mesh.get_one_ring_tets_for_edge(edge).size() == 4);
+    REQUIRE(mesh.one_ring_tids(3).size() == 3);
+
+    size_t n_tets = 0;
+    mesh.for_each_tet_in_edge_one_ring(edge, [&](const TetMesh::Tuple& t) {
+        REQUIRE(t.is_valid(mesh));
+        n_tets++;
+    });
+    REQUIRE(n_tets == 4);
+    const auto& incident = mesh.get_incident_tets_for_edge_scratch(edge);
+    REQUIRE(incident.size() == 3);
+    REQUIRE(mesh.get_one_ring_tets_for_vertex_scratch(mesh.tuple_from_vertex(5)).size() == 2);
+    REQUIRE(incident.size() == 3);
+}
+
+TEST_CASE("edges_of_tet_visitor", "[test_tuple]")
+{
+    TetMesh mesh;
+    mesh.init(5, {{{0, 1, 2, 3}}, {{0, 1, 3, 4}}});
+    for (size_t tid = 0; tid < mesh.tet_capacity(); tid++) {
+        const auto tet = mesh.tuple_from_tet(tid);
+        const auto edges = mesh.tet_edges(tet);
+        size_t j = 0;
+        mesh.for_each_edge_of_tet(tet, [&](const TetMesh::Tuple& e) {
+            REQUIRE(e.is_valid(mesh));
+            REQUIRE(e.tid(mesh) == tid);
+            REQUIRE(e.vid(mesh) == edges[j].vid(mesh));
+            REQUIRE(e.eid(mesh) == edges[j].eid(mesh));
+            j++;
+        });
+        REQUIRE(j == 6);
+    }
+}